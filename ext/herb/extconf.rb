@@ -61,13 +61,16 @@ core_src_files = [
   "extension.c",
   "nodes.c",
   "error_helpers.c",
-  "extension_helpers.c"
+  "extension_helpers.c",
+  "lazy_document.c"
 ]
 
 $srcs = core_src_files + herb_src_files + prism_main_files + prism_util_files
 
 puts "Sources to be compiled: #{$srcs.inspect}"
 
+have_func("rb_ext_ractor_safe", "ruby.h")
+
 abort("could not find prism.h") unless find_header("prism.h")
 abort("could not find herb.h") unless find_header("herb.h")
 
@@ -3,6 +3,7 @@
 #include "error_helpers.h"
 #include "extension.h"
 #include "extension_helpers.h"
+#include "lazy_document.h"
 #include "nodes.h"
 
 VALUE mHerb;
@@ -19,6 +20,7 @@ typedef struct {
   AST_DOCUMENT_NODE_T* root;
   VALUE source;
   const parser_options_T* parser_options;
+  hb_arena_T* allocator;
 } parse_args_T;
 
 typedef struct {
@@ -39,7 +41,11 @@ static VALUE parse_convert_body(VALUE arg) {
 static VALUE parse_cleanup(VALUE arg) {
   parse_args_T* args = (parse_args_T*) arg;
 
-  if (args->root != NULL) { ast_node_free((AST_NODE_T*) args->root); }
+  if (args->allocator != NULL) {
+    hb_arena_free(args->allocator);
+  } else if (args->root != NULL) {
+    ast_node_free((AST_NODE_T*) args->root);
+  }
 
   return Qnil;
 }
@@ -73,29 +79,42 @@ static VALUE buffer_cleanup(VALUE arg) {
 }
 
 static VALUE Herb_lex(VALUE self, VALUE source) {
-  char* string = (char*) check_string(source);
+  check_string(source);
+
+  // A frozen copy shares the bytes of `source`, so they stay put if another thread modifies `source` while
+  // the GVL is released. It has to outlive the conversion below, as the tokens view into it.
+  VALUE frozen_source = rb_str_new_frozen(source);
+  lex_args_T args = { .tokens = lex_without_gvl(frozen_source), .source = source };
 
-  lex_args_T args = { .tokens = herb_lex(string), .source = source };
+  VALUE result = rb_ensure(lex_convert_body, (VALUE) &args, lex_cleanup, (VALUE) &args);
+  RB_GC_GUARD(frozen_source);
 
-  return rb_ensure(lex_convert_body, (VALUE) &args, lex_cleanup, (VALUE) &args);
+  return result;
 }
 
 static VALUE Herb_lex_file(VALUE self, VALUE path) {
   char* file_path = (char*) check_string(path);
 
+  // The file is read once, and lexed from the same string that becomes the result's source.
   VALUE source_value = read_file_to_ruby_string(file_path);
-  lex_args_T args = { .tokens = herb_lex_file(file_path), .source = source_value };
+  VALUE frozen_source = rb_str_new_frozen(source_value);
+  lex_args_T args = { .tokens = lex_without_gvl(frozen_source), .source = source_value };
+
+  VALUE result = rb_ensure(lex_convert_body, (VALUE) &args, lex_cleanup, (VALUE) &args);
+  RB_GC_GUARD(frozen_source);
 
-  return rb_ensure(lex_convert_body, (VALUE) &args, lex_cleanup, (VALUE) &args);
+  return result;
 }
 
 static VALUE Herb_parse(int argc, VALUE* argv, VALUE self) {
   VALUE source, options;
   rb_scan_args(argc, argv, "1:", &source, &options);
 
-  char* string = (char*) check_string(source);
+  check_string(source);
 
   parser_options_T parser_options = HERB_DEFAULT_PARSER_OPTIONS;
+  herb_parse_stats_T parse_stats = { 0 };
+  bool lazy = false;
 
   if (!NIL_P(options)) {
     VALUE track_whitespace = rb_hash_lookup(options, rb_utf8_str_new_cstr("track_whitespace"));
@@ -109,13 +128,36 @@ static VALUE Herb_parse(int argc, VALUE* argv, VALUE self) {
     VALUE strict = rb_hash_lookup(options, rb_utf8_str_new_cstr("strict"));
     if (NIL_P(strict)) { strict = rb_hash_lookup(options, ID2SYM(rb_intern("strict"))); }
     if (!NIL_P(strict)) { parser_options.strict = RTEST(strict); }
+
+    VALUE lazy_value = rb_hash_lookup(options, rb_utf8_str_new_cstr("lazy"));
+    if (NIL_P(lazy_value)) { lazy_value = rb_hash_lookup(options, ID2SYM(rb_intern("lazy"))); }
+    if (!NIL_P(lazy_value)) { lazy = RTEST(lazy_value); }
+
+    VALUE stats = rb_hash_lookup(options, rb_utf8_str_new_cstr("stats"));
+    if (NIL_P(stats)) { stats = rb_hash_lookup(options, ID2SYM(rb_intern("stats"))); }
+    if (!NIL_P(stats) && RTEST(stats)) { parser_options.stats = &parse_stats; }
   }
 
-  parse_args_T args = { .root = herb_parse(string, &parser_options),
+  if (lazy) {
+    return create_parse_result_from_value(rb_lazy_document_parse(source, &parser_options), source, &parser_options);
+  }
+
+  // With stats the document is parsed into an arena, so its allocations are counted too.
+  hb_arena_T allocator;
+  hb_arena_T* arena = NULL;
+
+  if (parser_options.stats != NULL && hb_arena_init(&allocator, KB(64))) { arena = &allocator; }
+
+  VALUE frozen_source = rb_str_new_frozen(source);
+  parse_args_T args = { .root = parse_without_gvl(frozen_source, &parser_options, arena),
                         .source = source,
-                        .parser_options = &parser_options };
+                        .parser_options = &parser_options,
+                        .allocator = arena };
 
-  return rb_ensure(parse_convert_body, (VALUE) &args, parse_cleanup, (VALUE) &args);
+  VALUE result = rb_ensure(parse_convert_body, (VALUE) &args, parse_cleanup, (VALUE) &args);
+  RB_GC_GUARD(frozen_source);
+
+  return result;
 }
 
 static VALUE Herb_parse_file(int argc, VALUE* argv, VALUE self) {
@@ -125,9 +167,10 @@ static VALUE Herb_parse_file(int argc, VALUE* argv, VALUE self) {
   char* file_path = (char*) check_string(path);
 
   VALUE source_value = read_file_to_ruby_string(file_path);
-  char* string = (char*) check_string(source_value);
 
   parser_options_T parser_options = HERB_DEFAULT_PARSER_OPTIONS;
+  herb_parse_stats_T parse_stats = { 0 };
+  bool lazy = false;
 
   if (!NIL_P(options)) {
     VALUE track_whitespace = rb_hash_lookup(options, rb_utf8_str_new_cstr("track_whitespace"));
@@ -141,23 +184,49 @@ static VALUE Herb_parse_file(int argc, VALUE* argv, VALUE self) {
     VALUE strict = rb_hash_lookup(options, rb_utf8_str_new_cstr("strict"));
     if (NIL_P(strict)) { strict = rb_hash_lookup(options, ID2SYM(rb_intern("strict"))); }
     if (!NIL_P(strict)) { parser_options.strict = RTEST(strict); }
+
+    VALUE lazy_value = rb_hash_lookup(options, rb_utf8_str_new_cstr("lazy"));
+    if (NIL_P(lazy_value)) { lazy_value = rb_hash_lookup(options, ID2SYM(rb_intern("lazy"))); }
+    if (!NIL_P(lazy_value)) { lazy = RTEST(lazy_value); }
+
+    VALUE stats = rb_hash_lookup(options, rb_utf8_str_new_cstr("stats"));
+    if (NIL_P(stats)) { stats = rb_hash_lookup(options, ID2SYM(rb_intern("stats"))); }
+    if (!NIL_P(stats) && RTEST(stats)) { parser_options.stats = &parse_stats; }
+  }
+
+  if (lazy) {
+    return create_parse_result_from_value(
+      rb_lazy_document_parse(source_value, &parser_options),
+      source_value,
+      &parser_options
+    );
   }
 
-  parse_args_T args = { .root = herb_parse(string, &parser_options),
+  hb_arena_T allocator;
+  hb_arena_T* arena = NULL;
+
+  if (parser_options.stats != NULL && hb_arena_init(&allocator, KB(64))) { arena = &allocator; }
+
+  VALUE frozen_source = rb_str_new_frozen(source_value);
+  parse_args_T args = { .root = parse_without_gvl(frozen_source, &parser_options, arena),
                         .source = source_value,
-                        .parser_options = &parser_options };
+                        .parser_options = &parser_options,
+                        .allocator = arena };
 
-  return rb_ensure(parse_convert_body, (VALUE) &args, parse_cleanup, (VALUE) &args);
+  VALUE result = rb_ensure(parse_convert_body, (VALUE) &args, parse_cleanup, (VALUE) &args);
+  RB_GC_GUARD(frozen_source);
+
+  return result;
 }
 
 static VALUE Herb_extract_ruby(int argc, VALUE* argv, VALUE self) {
   VALUE source, options;
   rb_scan_args(argc, argv, "1:", &source, &options);
 
-  char* string = (char*) check_string(source);
+  check_string(source);
   hb_buffer_T output;
 
-  if (!hb_buffer_init(&output, strlen(string))) { return Qnil; }
+  if (!hb_buffer_init(&output, RSTRING_LEN(source))) { return Qnil; }
 
   herb_extract_ruby_options_T extract_options = HERB_EXTRACT_RUBY_DEFAULT_OPTIONS;
 
@@ -177,7 +246,7 @@ static VALUE Herb_extract_ruby(int argc, VALUE* argv, VALUE self) {
     if (!NIL_P(preserve_positions_value)) { extract_options.preserve_positions = RTEST(preserve_positions_value); }
   }
 
-  herb_extract_ruby_to_buffer_with_options(string, &output, &extract_options);
+  extract_ruby_without_gvl(rb_str_new_frozen(source), &output, &extract_options);
 
   buffer_args_T args = { .buffer_value = output.value };
 
@@ -185,12 +254,12 @@ static VALUE Herb_extract_ruby(int argc, VALUE* argv, VALUE self) {
 }
 
 static VALUE Herb_extract_html(VALUE self, VALUE source) {
-  char* string = (char*) check_string(source);
+  check_string(source);
   hb_buffer_T output;
 
-  if (!hb_buffer_init(&output, strlen(string))) { return Qnil; }
+  if (!hb_buffer_init(&output, RSTRING_LEN(source))) { return Qnil; }
 
-  herb_extract_html_to_buffer(string, &output);
+  extract_html_without_gvl(rb_str_new_frozen(source), &output);
 
   buffer_args_T args = { .buffer_value = output.value };
 
@@ -207,6 +276,12 @@ static VALUE Herb_version(VALUE self) {
 }
 
 __attribute__((__visibility__("default"))) void Init_herb(void) {
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+  // Nothing here keeps mutable global state: the class handles below are set once, and every call
+  // works on its own parser, tree and buffers.
+  rb_ext_ractor_safe(true);
+#endif
+
   mHerb = rb_define_module("Herb");
   cPosition = rb_define_class_under(mHerb, "Position", rb_cObject);
   cLocation = rb_define_class_under(mHerb, "Location", rb_cObject);
@@ -219,6 +294,7 @@ __attribute__((__visibility__("default"))) void Init_herb(void) {
 
   rb_init_node_classes();
   rb_init_error_classes();
+  rb_init_lazy_document_class();
 
   rb_define_singleton_method(mHerb, "parse", Herb_parse, -1);
   rb_define_singleton_method(mHerb, "lex", Herb_lex, 1);
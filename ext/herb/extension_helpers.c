@@ -1,9 +1,11 @@
 #include <ruby.h>
+#include <ruby/thread.h>
 
 #include "extension.h"
 #include "extension_helpers.h"
 #include "nodes.h"
 
+#include "../../src/include/extract.h"
 #include "../../src/include/herb.h"
 #include "../../src/include/io.h"
 #include "../../src/include/location.h"
@@ -47,7 +49,7 @@ VALUE rb_range_from_c_struct(range_T range) {
 VALUE rb_token_from_c_struct(token_T* token) {
   if (!token) { return Qnil; }
 
-  VALUE value = token->value ? rb_utf8_str_new_cstr(token->value) : Qnil;
+  VALUE value = rb_utf8_str_new(token->value.data, token->value.length);
 
   VALUE range = rb_range_from_c_struct(token->range);
   VALUE location = rb_location_from_c_struct(token->location);
@@ -58,6 +60,80 @@ VALUE rb_token_from_c_struct(token_T* token) {
   return rb_class_new_instance(4, args, cToken);
 }
 
+typedef struct {
+  const char* source;
+  size_t length;
+  const parser_options_T* parser_options;
+  const herb_extract_ruby_options_T* extract_options;
+  hb_arena_T* allocator;
+  hb_buffer_T* output;
+  AST_DOCUMENT_NODE_T* root;
+  hb_array_T* tokens;
+} without_gvl_args_T;
+
+static void* parse_body(void* data) {
+  without_gvl_args_T* args = (without_gvl_args_T*) data;
+  args->root = herb_parse_arena_with_length(args->source, args->length, args->parser_options, args->allocator);
+
+  return NULL;
+}
+
+static void* lex_body(void* data) {
+  without_gvl_args_T* args = (without_gvl_args_T*) data;
+  args->tokens = herb_lex_with_length(args->source, args->length);
+
+  return NULL;
+}
+
+static void* extract_ruby_body(void* data) {
+  without_gvl_args_T* args = (without_gvl_args_T*) data;
+  herb_extract_ruby_to_buffer_with_length(args->source, args->length, args->output, args->extract_options);
+
+  return NULL;
+}
+
+static void* extract_html_body(void* data) {
+  without_gvl_args_T* args = (without_gvl_args_T*) data;
+  herb_extract_html_to_buffer_with_length(args->source, args->length, args->output);
+
+  return NULL;
+}
+
+// libherb only allocates with malloc and never calls back into Ruby, so none of these need the GVL.
+// They can't be interrupted either; Thread#raise and Thread#kill take effect once the call returns.
+static void call_without_gvl(void* (*body)(void*), VALUE source, without_gvl_args_T* args) {
+  args->source = check_string(source);
+  args->length = RSTRING_LEN(source);
+
+  rb_thread_call_without_gvl(body, args, NULL, NULL);
+
+  RB_GC_GUARD(source);
+}
+
+AST_DOCUMENT_NODE_T* parse_without_gvl(VALUE source, const parser_options_T* options, hb_arena_T* allocator) {
+  without_gvl_args_T args = { .parser_options = options, .allocator = allocator };
+  call_without_gvl(parse_body, source, &args);
+
+  return args.root;
+}
+
+hb_array_T* lex_without_gvl(VALUE source) {
+  without_gvl_args_T args = { 0 };
+  call_without_gvl(lex_body, source, &args);
+
+  return args.tokens;
+}
+
+void extract_ruby_without_gvl(VALUE source, hb_buffer_T* output, const herb_extract_ruby_options_T* options) {
+  without_gvl_args_T args = { .output = output, .extract_options = options };
+  call_without_gvl(extract_ruby_body, source, &args);
+}
+
+void extract_html_without_gvl(VALUE source, hb_buffer_T* output) {
+  without_gvl_args_T args = { .output = output };
+  call_without_gvl(extract_html_body, source, &args);
+}
+
 VALUE create_lex_result(hb_array_T* tokens, VALUE source) {
   VALUE value = rb_ary_new();
   VALUE warnings = rb_ary_new();
@@ -74,7 +150,28 @@ VALUE create_lex_result(hb_array_T* tokens, VALUE source) {
 }
 
 VALUE create_parse_result(AST_DOCUMENT_NODE_T* root, VALUE source, const parser_options_T* options) {
-  VALUE value = rb_node_from_c_struct((AST_NODE_T*) root);
+  return create_parse_result_from_value(rb_node_from_c_struct((AST_NODE_T*) root), source, options);
+}
+
+static VALUE create_parse_stats(const herb_parse_stats_T* stats) {
+  VALUE nanoseconds = rb_hash_new();
+
+  for (int phase = 0; phase < HERB_PARSE_PHASE_COUNT; phase++) {
+    const char* name = herb_parse_phase_name((herb_parse_phase_T) phase);
+    rb_hash_aset(nanoseconds, ID2SYM(rb_intern(name)), ULL2NUM(stats->nanoseconds[phase]));
+  }
+
+  VALUE hash = rb_hash_new();
+  rb_hash_aset(hash, ID2SYM(rb_intern("nanoseconds")), nanoseconds);
+  rb_hash_aset(hash, ID2SYM(rb_intern("tokens")), SIZET2NUM(stats->tokens));
+  rb_hash_aset(hash, ID2SYM(rb_intern("nodes")), SIZET2NUM(stats->nodes));
+  rb_hash_aset(hash, ID2SYM(rb_intern("prism_parses")), SIZET2NUM(stats->prism_parses));
+  rb_hash_aset(hash, ID2SYM(rb_intern("allocations")), SIZET2NUM(stats->allocations));
+
+  return hash;
+}
+
+VALUE create_parse_result_from_value(VALUE value, VALUE source, const parser_options_T* options) {
   VALUE warnings = rb_ary_new();
   VALUE errors = rb_ary_new();
 
@@ -86,16 +183,19 @@ VALUE create_parse_result(AST_DOCUMENT_NODE_T* root, VALUE source, const parser_
   VALUE parser_options_args[1] = { kwargs };
   VALUE parser_options = rb_class_new_instance_kw(1, parser_options_args, cParserOptions, RB_PASS_KEYWORDS);
 
-  VALUE args[5] = { value, source, warnings, errors, parser_options };
+  VALUE stats = options->stats != NULL ? create_parse_stats(options->stats) : Qnil;
+  VALUE args[6] = { value, source, warnings, errors, parser_options, stats };
 
-  return rb_class_new_instance(5, args, cParseResult);
+  return rb_class_new_instance(6, args, cParseResult);
 }
 
 VALUE read_file_to_ruby_string(const char* file_path) {
-  char* source = herb_read_file(file_path);
-  VALUE source_value = rb_utf8_str_new_cstr(source);
+  herb_mapped_file_T file;
+
+  if (!herb_try_map_file(file_path, &file)) { rb_sys_fail(file_path); }
 
-  free(source);
+  VALUE source_value = rb_utf8_str_new(file.data, (long) file.length);
+  herb_unmap_file(&file);
 
   return source_value;
 }
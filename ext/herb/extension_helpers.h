@@ -3,8 +3,10 @@
 
 #include <ruby.h>
 
+#include "../../src/include/extract.h"
 #include "../../src/include/herb.h"
 #include "../../src/include/location.h"
+#include "../../src/include/macros.h"
 #include "../../src/include/position.h"
 #include "../../src/include/range.h"
 #include "../../src/include/token.h"
@@ -18,7 +20,16 @@ VALUE rb_location_from_c_struct(location_T location);
 VALUE rb_token_from_c_struct(token_T* token);
 VALUE rb_range_from_c_struct(range_T range);
 
+// These run libherb with the GVL released, so other Ruby threads keep running while it works.
+// `source` must be frozen, and the caller keeps it alive (and so pinned) while it uses the result,
+// since tokens view into it. `allocator` may be NULL to parse with malloc.
+AST_DOCUMENT_NODE_T* parse_without_gvl(VALUE source, const parser_options_T* options, hb_arena_T* allocator);
+hb_array_T* lex_without_gvl(VALUE source);
+void extract_ruby_without_gvl(VALUE source, hb_buffer_T* output, const herb_extract_ruby_options_T* options);
+void extract_html_without_gvl(VALUE source, hb_buffer_T* output);
+
 VALUE create_lex_result(hb_array_T* tokens, VALUE source);
 VALUE create_parse_result(AST_DOCUMENT_NODE_T* root, VALUE source, const parser_options_T* options);
+VALUE create_parse_result_from_value(VALUE value, VALUE source, const parser_options_T* options);
 
 #endif
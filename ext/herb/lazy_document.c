@@ -0,0 +1,147 @@
+#include <ruby.h>
+
+#include "error_helpers.h"
+#include "extension.h"
+#include "extension_helpers.h"
+#include "lazy_document.h"
+#include "nodes.h"
+
+#include "../../src/include/herb.h"
+#include "../../src/include/macros.h"
+#include "../../src/include/util/hb_arena.h"
+#include "../../src/include/visitor.h"
+
+static VALUE cLazyDocument;
+
+#define LAZY_DOCUMENT_ARENA_SIZE KB(16)
+
+typedef struct {
+  AST_DOCUMENT_NODE_T* root;
+  hb_arena_T allocator;
+  bool has_allocator;
+  VALUE source;
+  VALUE value;
+  VALUE errors;
+} lazy_document_T;
+
+static void lazy_document_mark(void* data) {
+  lazy_document_T* document = (lazy_document_T*) data;
+
+  // Tokens in the C tree view into `source`, so it's marked with rb_gc_mark() to pin it in place during compaction.
+  rb_gc_mark(document->source);
+  rb_gc_mark(document->value);
+  rb_gc_mark(document->errors);
+}
+
+static void lazy_document_release_root(lazy_document_T* document) {
+  if (document->has_allocator) {
+    hb_arena_free(&document->allocator);
+    document->has_allocator = false;
+  } else if (document->root != NULL) {
+    ast_node_free((AST_NODE_T*) document->root);
+  }
+
+  document->root = NULL;
+}
+
+static void lazy_document_free(void* data) {
+  lazy_document_T* document = (lazy_document_T*) data;
+
+  lazy_document_release_root(document);
+
+  xfree(document);
+}
+
+// The C tree lives in the document's arena, so its pages are what it costs until the tree is materialized.
+static size_t lazy_document_memsize(const void* data) {
+  const lazy_document_T* document = (const lazy_document_T*) data;
+  size_t size = sizeof(lazy_document_T);
+
+  if (document->has_allocator) { size += hb_arena_capacity((hb_arena_T*) &document->allocator); }
+
+  return size;
+}
+
+static const rb_data_type_t lazy_document_type = {
+  .wrap_struct_name = "Herb::LazyDocument",
+  .function = { .dmark = lazy_document_mark, .dfree = lazy_document_free, .dsize = lazy_document_memsize },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
+VALUE rb_lazy_document_parse(VALUE source, const parser_options_T* options) {
+  lazy_document_T* document;
+  VALUE self = TypedData_Make_Struct(cLazyDocument, lazy_document_T, &lazy_document_type, document);
+
+  // A frozen copy shares the bytes of `source` until either one is modified, so the tree always sees what it parsed.
+  document->source = rb_str_new_frozen(source);
+  document->value = Qnil;
+  document->errors = Qnil;
+
+  // Parsing into an arena lets memsize_of see the tree, and counts its allocations when stats are collected.
+  document->has_allocator = hb_arena_init(&document->allocator, LAZY_DOCUMENT_ARENA_SIZE);
+  document->root =
+    parse_without_gvl(document->source, options, document->has_allocator ? &document->allocator : NULL);
+
+  return self;
+}
+
+static VALUE LazyDocument_value(VALUE self) {
+  lazy_document_T* document;
+  TypedData_Get_Struct(self, lazy_document_T, &lazy_document_type, document);
+
+  if (NIL_P(document->value)) {
+    document->value = rb_node_from_c_struct((AST_NODE_T*) document->root);
+
+    // The Ruby nodes own copies of everything they need, so the C tree can go right away.
+    lazy_document_release_root(document);
+  }
+
+  return document->value;
+}
+
+static bool collect_errors_visitor(const AST_NODE_T* node, void* data) {
+  VALUE errors = (VALUE) data;
+
+  if (node->errors != NULL) {
+    for (size_t index = 0; index < hb_array_size(node->errors); index++) {
+      ERROR_T* error = hb_array_get(node->errors, index);
+      if (error != NULL) { rb_ary_push(errors, rb_error_from_c_struct(error)); }
+    }
+  }
+
+  return true;
+}
+
+// Same errors, in the same order, as Herb::AST::Node#recursive_errors on the materialized document.
+static VALUE LazyDocument_errors(VALUE self) {
+  lazy_document_T* document;
+  TypedData_Get_Struct(self, lazy_document_T, &lazy_document_type, document);
+
+  if (NIL_P(document->errors)) {
+    if (document->root != NULL) {
+      VALUE errors = rb_ary_new();
+      herb_visit_node((AST_NODE_T*) document->root, collect_errors_visitor, (void*) errors);
+      document->errors = errors;
+    } else {
+      document->errors = rb_funcall(document->value, rb_intern("recursive_errors"), 0);
+    }
+  }
+
+  return document->errors;
+}
+
+static VALUE LazyDocument_materialized_p(VALUE self) {
+  lazy_document_T* document;
+  TypedData_Get_Struct(self, lazy_document_T, &lazy_document_type, document);
+
+  return NIL_P(document->value) ? Qfalse : Qtrue;
+}
+
+void rb_init_lazy_document_class(void) {
+  cLazyDocument = rb_define_class_under(mHerb, "LazyDocument", rb_cObject);
+  rb_undef_alloc_func(cLazyDocument);
+
+  rb_define_method(cLazyDocument, "value", LazyDocument_value, 0);
+  rb_define_method(cLazyDocument, "errors", LazyDocument_errors, 0);
+  rb_define_method(cLazyDocument, "materialized?", LazyDocument_materialized_p, 0);
+}
@@ -0,0 +1,13 @@
+#ifndef HERB_EXTENSION_LAZY_DOCUMENT_H
+#define HERB_EXTENSION_LAZY_DOCUMENT_H
+
+#include <ruby.h>
+
+#include "../../src/include/herb.h"
+
+void rb_init_lazy_document_class(void);
+
+// Parses `source` into a Herb::LazyDocument, which keeps the C tree and only builds Ruby nodes when asked for them.
+VALUE rb_lazy_document_parse(VALUE source, const parser_options_T* options);
+
+#endif
@@ -48,7 +48,9 @@ jobject CreateToken(JNIEnv* env, token_T* token) {
       env, tokenClass, "<init>", "(Ljava/lang/String;Ljava/lang/String;Lorg/herb/Location;Lorg/herb/Range;)V");
 
   jstring type = (*env)->NewStringUTF(env, token_type_to_string(token->type));
-  jstring value = (*env)->NewStringUTF(env, token->value);
+  char* token_value = token_value_to_c_string(token);
+  jstring value = (*env)->NewStringUTF(env, token_value);
+  free(token_value);
   jobject location = CreateLocation(env, token->location);
   jobject range = CreateRange(env, token->range);
 
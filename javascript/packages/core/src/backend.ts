@@ -1,13 +1,13 @@
 import type { SerializedParseResult } from "./parse-result.js"
 import type { SerializedLexResult } from "./lex-result.js"
-import type { ParseOptions } from "./parser-options.js"
+import type { ParseOptions, LazyParseOptions, InstrumentedParseOptions } from "./parser-options.js"
 import type { ExtractRubyOptions } from "./extract-ruby-options.js"
 
 interface LibHerbBackendFunctions {
   lex: (source: string) => SerializedLexResult
   lexFile: (path: string) => SerializedLexResult
 
-  parse: (source: string, options?: ParseOptions) => SerializedParseResult
+  parse: (source: string, options?: InstrumentedParseOptions) => SerializedParseResult
   parseFile: (path: string) => SerializedParseResult
 
   extractRuby: (source: string, options?: ExtractRubyOptions) => string
@@ -16,6 +16,16 @@ interface LibHerbBackendFunctions {
   version: () => string
 }
 
+// Functions a backend may expose on top of `LibHerbBackendFunctions`.
+// They are not checked by `isLibHerbBackend`, so callers need to fall back when one is missing.
+interface LibHerbBackendOptionalFunctions {
+  parseToBuffer: (source: string, options?: LazyParseOptions) => ArrayBuffer
+
+  parseAsync: (source: string, options?: ParseOptions) => Promise<SerializedParseResult>
+  lexAsync: (source: string) => Promise<SerializedLexResult>
+  parseFilesAsync: (paths: string[]) => Promise<SerializedParseResult[]>
+}
+
 export type BackendPromise = () => Promise<LibHerbBackend>
 
 const expectedFunctions = [
@@ -55,7 +65,7 @@ export function _TYPECHECK() {
 
 export type LibHerbBackend = {
   [K in LibHerbBackendFunctionName]: LibHerbBackendFunctions[K]
-}
+} & Partial<LibHerbBackendOptionalFunctions>
 
 export function isLibHerbBackend(
   object: any,
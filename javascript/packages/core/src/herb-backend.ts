@@ -3,11 +3,11 @@ import packageJSON from "../package.json" with { type: "json" }
 import { ensureString } from "./util.js"
 import { LexResult } from "./lex-result.js"
 import { ParseResult } from "./parse-result.js"
-import { DEFAULT_PARSER_OPTIONS } from "./parser-options.js"
+import { DEFAULT_PARSER_OPTIONS, ParserOptions } from "./parser-options.js"
 import { DEFAULT_EXTRACT_RUBY_OPTIONS } from "./extract-ruby-options.js"
 
 import type { LibHerbBackend, BackendPromise } from "./backend.js"
-import type { ParseOptions } from "./parser-options.js"
+import type { ParseOptions, LazyParseOptions, InstrumentedParseOptions } from "./parser-options.js"
 import type { ExtractRubyOptions } from "./extract-ruby-options.js"
 
 /**
@@ -68,11 +68,11 @@ export abstract class HerbBackend {
   /**
    * Parses the given source string into a `ParseResult`.
    * @param source - The source code to parse.
-   * @param options - Optional parsing options.
+   * @param options - Optional parsing options. Pass `stats: true` to fill in `ParseResult#stats`.
    * @returns A `ParseResult` instance.
    * @throws Error if the backend is not loaded.
    */
-  parse(source: string, options?: ParseOptions): ParseResult {
+  parse(source: string, options?: InstrumentedParseOptions): ParseResult {
     this.ensureBackend()
 
     const mergedOptions = { ...DEFAULT_PARSER_OPTIONS, ...options }
@@ -80,6 +80,28 @@ export abstract class HerbBackend {
     return ParseResult.from(this.backend.parse(ensureString(source), mergedOptions))
   }
 
+  /**
+   * Parses the given source string like `parse()`, but through the backend's flat buffer encoding
+   * when it provides `parseToBuffer()`. The nodes are then only built the first time `value` is read.
+   * Backends without `parseToBuffer()` fall back to `parse()`.
+   * @param source - The source code to parse.
+   * @param options - Optional parsing options, plus an optional `cache_directory` for the serialized documents.
+   * @returns A `ParseResult` instance.
+   * @throws Error if the backend is not loaded.
+   */
+  parseLazy(source: string, options?: LazyParseOptions): ParseResult {
+    this.ensureBackend()
+
+    if (!this.backend.parseToBuffer) {
+      return this.parse(source, options)
+    }
+
+    const mergedOptions = { ...DEFAULT_PARSER_OPTIONS, ...options }
+    const buffer = this.backend.parseToBuffer(ensureString(source), mergedOptions)
+
+    return ParseResult.fromBuffer(buffer, source, ParserOptions.from(mergedOptions))
+  }
+
   /**
    * Parses a file.
    * @param path - The file path to parse.
@@ -92,6 +114,62 @@ export abstract class HerbBackend {
     return ParseResult.from(this.backend.parseFile(ensureString(path)))
   }
 
+  /**
+   * Lexes the given source string like `lex()`, without blocking the event loop
+   * when the backend provides `lexAsync()`.
+   * @param source - The source code to lex.
+   * @returns A promise resolving to a `LexResult` instance.
+   * @throws Error if the backend is not loaded.
+   */
+  async lexAsync(source: string): Promise<LexResult> {
+    this.ensureBackend()
+
+    if (!this.backend.lexAsync) {
+      return this.lex(source)
+    }
+
+    return LexResult.from(await this.backend.lexAsync(ensureString(source)))
+  }
+
+  /**
+   * Parses the given source string like `parse()`, without blocking the event loop
+   * when the backend provides `parseAsync()`.
+   * @param source - The source code to parse.
+   * @param options - Optional parsing options.
+   * @returns A promise resolving to a `ParseResult` instance.
+   * @throws Error if the backend is not loaded.
+   */
+  async parseAsync(source: string, options?: ParseOptions): Promise<ParseResult> {
+    this.ensureBackend()
+
+    if (!this.backend.parseAsync) {
+      return this.parse(source, options)
+    }
+
+    const mergedOptions = { ...DEFAULT_PARSER_OPTIONS, ...options }
+
+    return ParseResult.from(await this.backend.parseAsync(ensureString(source), mergedOptions))
+  }
+
+  /**
+   * Parses several files like `parseFile()`. Backends providing `parseFilesAsync()` parse them
+   * in parallel, off the main thread.
+   * @param paths - The file paths to parse.
+   * @returns A promise resolving to a `ParseResult` for each path, in the same order.
+   * @throws Error if the backend is not loaded.
+   */
+  async parseFilesAsync(paths: string[]): Promise<ParseResult[]> {
+    this.ensureBackend()
+
+    if (!this.backend.parseFilesAsync) {
+      return paths.map((path) => this.parseFile(path))
+    }
+
+    const results = await this.backend.parseFilesAsync(paths.map((path) => ensureString(path)))
+
+    return results.map((result) => ParseResult.from(result))
+  }
+
   /**
    * Extracts embedded Ruby code from the given source.
    * @param source - The source code to extract Ruby from.
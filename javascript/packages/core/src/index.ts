@@ -1,5 +1,6 @@
 export * from "./ast-utils.js"
 export * from "./backend.js"
+export * from "./buffer-decoder.js"
 export * from "./diagnostic.js"
 export * from "./didyoumean.js"
 export * from "./errors.js"
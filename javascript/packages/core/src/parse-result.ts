@@ -1,6 +1,7 @@
 import { Result } from "./result.js"
 
 import { DocumentNode } from "./nodes.js"
+import { decodeDocumentBuffer } from "./buffer-decoder.js"
 import { HerbError } from "./errors.js"
 import { HerbWarning } from "./warning.js"
 import { ParserOptions } from "./parser-options.js"
@@ -18,6 +19,26 @@ export type SerializedParseResult = {
   warnings: SerializedHerbWarning[]
   errors: SerializedHerbError[]
   options: SerializedParserOptions
+  stats?: ParseStats
+}
+
+export type ParsePhase =
+  | "lex"
+  | "parse"
+  | "transform"
+  | "match_tags"
+  | "parse_errors"
+
+/**
+ * Timings and counters collected by `parse()` with `stats: true`.
+ * Lexing happens on demand while parsing, so the `parse` phase excludes the time spent in the lexer.
+ */
+export type ParseStats = {
+  nanoseconds: Record<ParsePhase, number>
+  tokens: number
+  nodes: number
+  prism_parses: number
+  allocations: number
 }
 
 /**
@@ -25,12 +46,14 @@ export type SerializedParseResult = {
  * It contains the parsed document node, source code, warnings, and errors.
  */
 export class ParseResult extends Result {
-  /** The document node generated from the source code. */
-  readonly value: DocumentNode
+  private document: DocumentNode | (() => DocumentNode)
 
   /** The parser options used during parsing. */
   readonly options: ParserOptions
 
+  /** Per-phase timings and counters, when parsed with `stats: true`. */
+  readonly stats: ParseStats | null
+
   /**
    * Creates a `ParseResult` instance from a serialized result.
    * @param result - The serialized parse result containing the value and source.
@@ -43,27 +66,58 @@ export class ParseResult extends Result {
       result.warnings.map((warning) => HerbWarning.from(warning)),
       result.errors.map((error) => HerbError.from(error)),
       ParserOptions.from(result.options),
+      result.stats ?? null,
+    )
+  }
+
+  /**
+   * Creates a `ParseResult` instance from a document serialized by `herb_serialize()`.
+   * The buffer is only decoded into nodes the first time `value` is read.
+   * @param buffer - The serialized document, e.g. from the Node backend's `parseToBuffer()`.
+   * @param source - The source code the document was parsed from.
+   * @param options - The parser options used during parsing.
+   * @returns A new `ParseResult` instance.
+   */
+  static fromBuffer(buffer: ArrayBuffer, source: string, options: ParserOptions = new ParserOptions()) {
+    return new ParseResult(
+      () => DocumentNode.from(decodeDocumentBuffer(buffer, source)),
+      source,
+      [],
+      [],
+      options,
     )
   }
 
   /**
    * Constructs a new `ParseResult`.
-   * @param value - The document node.
+   * @param value - The document node, or a function building it when it's first needed.
    * @param source - The source code that was parsed.
    * @param warnings - An array of warnings encountered during parsing.
    * @param errors - An array of errors encountered during parsing.
    * @param options - The parser options used during parsing.
+   * @param stats - Per-phase timings and counters, when they were collected.
    */
   constructor(
-    value: DocumentNode,
+    value: DocumentNode | (() => DocumentNode),
     source: string,
     warnings: HerbWarning[] = [],
     errors: HerbError[] = [],
     options: ParserOptions = new ParserOptions(),
+    stats: ParseStats | null = null,
   ) {
     super(source, warnings, errors)
-    this.value = value
+    this.document = value
     this.options = options
+    this.stats = stats
+  }
+
+  /** The document node generated from the source code. */
+  get value(): DocumentNode {
+    if (typeof this.document === "function") {
+      this.document = this.document()
+    }
+
+    return this.document
   }
 
   /**
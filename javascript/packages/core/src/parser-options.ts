@@ -4,6 +4,16 @@ export interface ParseOptions {
   strict?: boolean
 }
 
+export interface LazyParseOptions extends ParseOptions {
+  /** Directory to cache serialized documents in, so unchanged sources aren't parsed again. It has to exist. */
+  cache_directory?: string
+}
+
+export interface InstrumentedParseOptions extends ParseOptions {
+  /** Collect per-phase timings and counters into `ParseResult#stats`. */
+  stats?: boolean
+}
+
 export type SerializedParserOptions = Required<ParseOptions>
 
 export const DEFAULT_PARSER_OPTIONS: SerializedParserOptions = {
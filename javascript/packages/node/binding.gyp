@@ -4,6 +4,7 @@
       "target_name": "<(module_name)",
       "product_dir": "<(module_path)",
       "sources": [
+        "./extension/async.cpp",
         "./extension/error_helpers.cpp",
         "./extension/extension_helpers.cpp",
         "./extension/herb.cpp",
@@ -16,6 +17,7 @@
         "./extension/libherb/analyze/conditional_elements.c",
         "./extension/libherb/analyze/conditional_open_tags.c",
         "./extension/libherb/analyze/control_type.c",
+        "./extension/libherb/analyze/erb_tag_tokens.c",
         "./extension/libherb/analyze/helpers.c",
         "./extension/libherb/analyze/invalid_structures.c",
         "./extension/libherb/analyze/missing_end.c",
@@ -24,15 +26,23 @@
         "./extension/libherb/ast_node.c",
         "./extension/libherb/ast_nodes.c",
         "./extension/libherb/ast_pretty_print.c",
+        "./extension/libherb/ast_relocate.c",
+        "./extension/libherb/ast_serialize.c",
+        "./extension/libherb/context.c",
         "./extension/libherb/element_source.c",
         "./extension/libherb/errors.c",
         "./extension/libherb/extract.c",
         "./extension/libherb/herb.c",
         "./extension/libherb/html_util.c",
+        "./extension/libherb/incremental.c",
         "./extension/libherb/io.c",
         "./extension/libherb/lexer_peek_helpers.c",
         "./extension/libherb/lexer.c",
+        "./extension/libherb/line_offsets.c",
         "./extension/libherb/location.c",
+        "./extension/libherb/parse_cache.c",
+        "./extension/libherb/parse_files.c",
+        "./extension/libherb/parse_stats.c",
         "./extension/libherb/parser_helpers.c",
         "./extension/libherb/parser_match_tags.c",
         "./extension/libherb/parser.c",
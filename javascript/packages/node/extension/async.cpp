@@ -0,0 +1,346 @@
+#include <node_api.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+#include "../extension/libherb/include/ast_nodes.h"
+#include "../extension/libherb/include/herb.h"
+#include "../extension/libherb/include/io.h"
+#include "../extension/libherb/include/util/hb_array.h"
+}
+
+#include "async.h"
+#include "extension_helpers.h"
+
+// The execute callbacks run on libuv's thread pool and must not call into N-API,
+// so they only ever touch the C strings and trees owned by their work item.
+
+struct ParseWork {
+  napi_async_work work;
+  napi_deferred deferred;
+  char* source;
+  size_t length;
+  parser_options_T options;
+  AST_DOCUMENT_NODE_T* root;
+};
+
+struct LexWork {
+  napi_async_work work;
+  napi_deferred deferred;
+  char* source;
+  size_t length;
+  hb_array_T* tokens;
+};
+
+struct ParseFilesBatch {
+  napi_deferred deferred;
+  napi_ref results_ref;
+  size_t pending;
+  char* failed_path;
+};
+
+struct ParseFileWork {
+  napi_async_work work;
+  ParseFilesBatch* batch;
+  uint32_t index;
+  char* path;
+  herb_mapped_file_T file;
+  bool read;
+  parser_options_T options;
+  AST_DOCUMENT_NODE_T* root;
+};
+
+static void QueueWork(
+  napi_env env,
+  const char* name,
+  napi_async_execute_callback execute,
+  napi_async_complete_callback complete,
+  void* data,
+  napi_async_work* work
+) {
+  napi_value resource_name;
+  napi_create_string_utf8(env, name, NAPI_AUTO_LENGTH, &resource_name);
+  napi_create_async_work(env, nullptr, resource_name, execute, complete, data, work);
+  napi_queue_async_work(env, *work);
+}
+
+static void RejectWithError(napi_env env, napi_deferred deferred, const char* message) {
+  napi_value message_value, error;
+  napi_create_string_utf8(env, message, NAPI_AUTO_LENGTH, &message_value);
+  napi_create_error(env, nullptr, message_value, &error);
+  napi_reject_deferred(env, deferred, error);
+}
+
+static void ExecuteParse(napi_env env, void* data) {
+  ParseWork* parse_work = (ParseWork*) data;
+
+  parse_work->root = herb_parse_with_length(parse_work->source, parse_work->length, &parse_work->options);
+}
+
+static void CompleteParse(napi_env env, napi_status status, void* data) {
+  ParseWork* parse_work = (ParseWork*) data;
+
+  if (status == napi_ok) {
+    napi_value source;
+    napi_create_string_utf8(env, parse_work->source, parse_work->length, &source);
+    napi_value result = CreateParseResult(env, parse_work->root, source, &parse_work->options);
+    napi_resolve_deferred(env, parse_work->deferred, result);
+  } else {
+    RejectWithError(env, parse_work->deferred, "Parse was cancelled");
+  }
+
+  if (parse_work->root) { ast_node_free((AST_NODE_T *) parse_work->root); }
+
+  napi_delete_async_work(env, parse_work->work);
+  free(parse_work->source);
+  free(parse_work);
+}
+
+napi_value Herb_parse_async(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value args[2];
+  napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+  if (argc < 1) {
+    napi_throw_error(env, nullptr, "Wrong number of arguments");
+    return nullptr;
+  }
+
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
+  if (!string) { return nullptr; }
+
+  ParseWork* parse_work = (ParseWork*) calloc(1, sizeof(ParseWork));
+  if (!parse_work) {
+    free(string);
+    napi_throw_error(env, nullptr, "Memory allocation failed");
+    return nullptr;
+  }
+
+  parse_work->source = string;
+  parse_work->length = length;
+  parse_work->options = HERB_DEFAULT_PARSER_OPTIONS;
+  if (argc >= 2) { ReadParserOptions(env, args[1], &parse_work->options); }
+
+  napi_value promise;
+  napi_create_promise(env, &parse_work->deferred, &promise);
+
+  QueueWork(env, "herb:parseAsync", ExecuteParse, CompleteParse, parse_work, &parse_work->work);
+
+  return promise;
+}
+
+static void ExecuteLex(napi_env env, void* data) {
+  LexWork* lex_work = (LexWork*) data;
+
+  lex_work->tokens = herb_lex_with_length(lex_work->source, lex_work->length);
+}
+
+static void CompleteLex(napi_env env, napi_status status, void* data) {
+  LexWork* lex_work = (LexWork*) data;
+
+  if (status == napi_ok) {
+    napi_value source;
+    napi_create_string_utf8(env, lex_work->source, lex_work->length, &source);
+    napi_value result = CreateLexResult(env, lex_work->tokens, source);
+    napi_resolve_deferred(env, lex_work->deferred, result);
+  } else {
+    RejectWithError(env, lex_work->deferred, "Lex was cancelled");
+  }
+
+  if (lex_work->tokens) { herb_free_tokens(&lex_work->tokens); }
+
+  napi_delete_async_work(env, lex_work->work);
+  free(lex_work->source);
+  free(lex_work);
+}
+
+napi_value Herb_lex_async(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+  if (argc < 1) {
+    napi_throw_error(env, nullptr, "Wrong number of arguments");
+    return nullptr;
+  }
+
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
+  if (!string) { return nullptr; }
+
+  LexWork* lex_work = (LexWork*) calloc(1, sizeof(LexWork));
+  if (!lex_work) {
+    free(string);
+    napi_throw_error(env, nullptr, "Memory allocation failed");
+    return nullptr;
+  }
+
+  lex_work->source = string;
+  lex_work->length = length;
+
+  napi_value promise;
+  napi_create_promise(env, &lex_work->deferred, &promise);
+
+  QueueWork(env, "herb:lexAsync", ExecuteLex, CompleteLex, lex_work, &lex_work->work);
+
+  return promise;
+}
+
+static void ExecuteParseFile(napi_env env, void* data) {
+  ParseFileWork* file_work = (ParseFileWork*) data;
+
+  file_work->read = herb_try_map_file(file_work->path, &file_work->file);
+
+  if (file_work->read) {
+    file_work->root = herb_parse_with_length(file_work->file.data, file_work->file.length, &file_work->options);
+  }
+}
+
+static void SettleParseFilesBatch(napi_env env, ParseFilesBatch* batch) {
+  napi_value results;
+  napi_get_reference_value(env, batch->results_ref, &results);
+  napi_delete_reference(env, batch->results_ref);
+
+  if (batch->failed_path) {
+    const char* format = "Failed to read file '%s'";
+    size_t length = strlen(format) + strlen(batch->failed_path);
+    char* message = (char*) malloc(length);
+
+    if (message) {
+      snprintf(message, length, format, batch->failed_path);
+      RejectWithError(env, batch->deferred, message);
+      free(message);
+    } else {
+      RejectWithError(env, batch->deferred, "Failed to read file");
+    }
+
+    free(batch->failed_path);
+  } else {
+    napi_resolve_deferred(env, batch->deferred, results);
+  }
+
+  free(batch);
+}
+
+// Each file is its own work item so the batch spreads over the whole thread pool. Results are stored
+// by index as they complete, and the promise settles once the last one is in.
+static void CompleteParseFile(napi_env env, napi_status status, void* data) {
+  ParseFileWork* file_work = (ParseFileWork*) data;
+  ParseFilesBatch* batch = file_work->batch;
+
+  if (batch->failed_path == NULL) {
+    if (status == napi_ok && file_work->read) {
+      napi_value source;
+      napi_create_string_utf8(env, file_work->file.data, file_work->file.length, &source);
+      napi_value result = CreateParseResult(env, file_work->root, source, &file_work->options);
+
+      napi_value results;
+      napi_get_reference_value(env, batch->results_ref, &results);
+      napi_set_element(env, results, file_work->index, result);
+    } else {
+      batch->failed_path = file_work->path;
+      file_work->path = nullptr;
+    }
+  }
+
+  if (file_work->root) { ast_node_free((AST_NODE_T *) file_work->root); }
+
+  napi_delete_async_work(env, file_work->work);
+  if (file_work->read) { herb_unmap_file(&file_work->file); }
+  free(file_work->path);
+  free(file_work);
+
+  if (--batch->pending == 0) { SettleParseFilesBatch(env, batch); }
+}
+
+napi_value Herb_parse_files_async(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value args[1];
+  napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+  if (argc < 1) {
+    napi_throw_error(env, nullptr, "Wrong number of arguments");
+    return nullptr;
+  }
+
+  bool is_array;
+  napi_is_array(env, args[0], &is_array);
+
+  if (!is_array) {
+    napi_throw_type_error(env, nullptr, "Array expected");
+    return nullptr;
+  }
+
+  uint32_t count;
+  napi_get_array_length(env, args[0], &count);
+
+  char** paths = (char**) calloc(count > 0 ? count : 1, sizeof(char*));
+  if (!paths) {
+    napi_throw_error(env, nullptr, "Memory allocation failed");
+    return nullptr;
+  }
+
+  for (uint32_t index = 0; index < count; index++) {
+    napi_value path;
+    napi_get_element(env, args[0], index, &path);
+    paths[index] = CheckString(env, path);
+
+    if (!paths[index]) {
+      for (uint32_t previous = 0; previous < index; previous++) { free(paths[previous]); }
+      free(paths);
+      return nullptr;
+    }
+  }
+
+  napi_value promise, results;
+  napi_deferred deferred;
+  napi_create_promise(env, &deferred, &promise);
+  napi_create_array_with_length(env, count, &results);
+
+  if (count == 0) {
+    napi_resolve_deferred(env, deferred, results);
+    free(paths);
+    return promise;
+  }
+
+  ParseFilesBatch* batch = (ParseFilesBatch*) calloc(1, sizeof(ParseFilesBatch));
+  if (!batch) {
+    for (uint32_t index = 0; index < count; index++) { free(paths[index]); }
+    free(paths);
+    RejectWithError(env, deferred, "Memory allocation failed");
+    return promise;
+  }
+
+  batch->deferred = deferred;
+  batch->pending = count;
+  napi_create_reference(env, results, 1, &batch->results_ref);
+
+  for (uint32_t index = 0; index < count; index++) {
+    ParseFileWork* file_work = (ParseFileWork*) calloc(1, sizeof(ParseFileWork));
+
+    if (!file_work) {
+      // Counted as a failed file, so the batch still settles once the queued files are done.
+      if (batch->failed_path == NULL) {
+        batch->failed_path = paths[index];
+      } else {
+        free(paths[index]);
+      }
+
+      if (--batch->pending == 0) { SettleParseFilesBatch(env, batch); }
+      continue;
+    }
+
+    file_work->batch = batch;
+    file_work->index = index;
+    file_work->path = paths[index];
+    file_work->options = HERB_DEFAULT_PARSER_OPTIONS;
+
+    QueueWork(env, "herb:parseFilesAsync", ExecuteParseFile, CompleteParseFile, file_work, &file_work->work);
+  }
+
+  free(paths);
+
+  return promise;
+}
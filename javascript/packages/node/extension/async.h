@@ -0,0 +1,12 @@
+#ifndef HERB_NODE_ASYNC_H
+#define HERB_NODE_ASYNC_H
+
+#include <node_api.h>
+
+// Promise-returning variants of parse, lex and parseFile. libherb runs on libuv's thread pool;
+// only the conversion of the result into JavaScript objects happens on the main thread.
+napi_value Herb_parse_async(napi_env env, napi_callback_info info);
+napi_value Herb_lex_async(napi_env env, napi_callback_info info);
+napi_value Herb_parse_files_async(napi_env env, napi_callback_info info);
+
+#endif
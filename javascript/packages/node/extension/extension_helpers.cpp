@@ -18,7 +18,7 @@ extern "C" {
 #include "error_helpers.h"
 #include "nodes.h"
 
-char* CheckString(napi_env env, napi_value value) {
+char* CheckString(napi_env env, napi_value value, size_t* string_length) {
   size_t length;
   size_t copied;
   napi_valuetype type;
@@ -37,6 +37,8 @@ char* CheckString(napi_env env, napi_value value) {
   }
 
   napi_get_value_string_utf8(env, value, result, length + 1, &copied);
+  if (string_length) { *string_length = copied; }
+
   return result;
 }
 
@@ -105,14 +107,8 @@ napi_value CreateToken(napi_env env, token_T* token) {
   napi_create_object(env, &result);
 
   // Value
-  napi_value value = token->value ? CreateString(env, token->value) : nullptr;
-  if (value) {
-    napi_set_named_property(env, result, "value", value);
-  } else {
-    napi_value null_value;
-    napi_get_null(env, &null_value);
-    napi_set_named_property(env, result, "value", null_value);
-  }
+  napi_value value = CreateStringFromHbString(env, token->value);
+  napi_set_named_property(env, result, "value", value);
 
   // Range
   napi_value range = CreateRange(env, token->range);
@@ -129,16 +125,87 @@ napi_value CreateToken(napi_env env, token_T* token) {
   return result;
 }
 
-napi_value ReadFileToString(napi_env env, const char* file_path) {
-  char* content = herb_read_file(file_path);
-  if (!content) {
-    napi_throw_error(env, nullptr, "Failed to read file");
-    return nullptr;
+void ReadParserOptions(napi_env env, napi_value value, parser_options_T* options) {
+  napi_valuetype valuetype;
+  napi_typeof(env, value, &valuetype);
+
+  if (valuetype == napi_object) {
+    napi_value track_whitespace_prop;
+    bool has_track_whitespace_prop;
+    napi_has_named_property(env, value, "track_whitespace", &has_track_whitespace_prop);
+
+    if (has_track_whitespace_prop) {
+      napi_get_named_property(env, value, "track_whitespace", &track_whitespace_prop);
+      bool track_whitespace_value;
+      napi_get_value_bool(env, track_whitespace_prop, &track_whitespace_value);
+
+      if (track_whitespace_value) {
+        options->track_whitespace = true;
+      }
+    }
+
+    napi_value analyze_prop;
+    bool has_analyze_prop;
+    napi_has_named_property(env, value, "analyze", &has_analyze_prop);
+
+    if (has_analyze_prop) {
+      napi_get_named_property(env, value, "analyze", &analyze_prop);
+      bool analyze_value;
+      napi_get_value_bool(env, analyze_prop, &analyze_value);
+
+      if (!analyze_value) {
+        options->analyze = false;
+      }
+    }
+
+    napi_value strict_prop;
+    bool has_strict_prop;
+    napi_has_named_property(env, value, "strict", &has_strict_prop);
+
+    if (has_strict_prop) {
+      napi_get_named_property(env, value, "strict", &strict_prop);
+      bool strict_value;
+      napi_get_value_bool(env, strict_prop, &strict_value);
+      options->strict = strict_value;
+    }
   }
+}
+
+bool ReadStatsOption(napi_env env, napi_value value) {
+  napi_valuetype valuetype;
+  napi_typeof(env, value, &valuetype);
+
+  if (valuetype != napi_object) { return false; }
 
-  napi_value result = CreateString(env, content);
+  bool has_stats_prop;
+  napi_has_named_property(env, value, "stats", &has_stats_prop);
 
-  free(content);
+  if (!has_stats_prop) { return false; }
+
+  napi_value stats_prop;
+  napi_get_named_property(env, value, "stats", &stats_prop);
+
+  bool stats_value = false;
+  napi_get_value_bool(env, stats_prop, &stats_value);
+
+  return stats_value;
+}
+
+bool MapFile(napi_env env, const char* file_path, herb_mapped_file_T* file) {
+  if (herb_try_map_file(file_path, file)) { return true; }
+
+  napi_throw_error(env, nullptr, "Failed to read file");
+  return false;
+}
+
+napi_value ReadFileToString(napi_env env, const char* file_path) {
+  herb_mapped_file_T file;
+  if (!MapFile(env, file_path, &file)) { return nullptr; }
+
+  napi_value result;
+  napi_create_string_utf8(env, file.data, file.length, &result);
+
+  herb_unmap_file(&file);
 
   return result;
 }
@@ -170,6 +237,31 @@ napi_value CreateLexResult(napi_env env, hb_array_T* tokens, napi_value source)
   return result;
 }
 
+static void SetCount(napi_env env, napi_value object, const char* name, double value) {
+  napi_value number;
+  napi_create_double(env, value, &number);
+  napi_set_named_property(env, object, name, number);
+}
+
+static napi_value CreateParseStats(napi_env env, const herb_parse_stats_T* stats) {
+  napi_value result, nanoseconds;
+  napi_create_object(env, &result);
+  napi_create_object(env, &nanoseconds);
+
+  for (int phase = 0; phase < HERB_PARSE_PHASE_COUNT; phase++) {
+    const char* name = herb_parse_phase_name((herb_parse_phase_T) phase);
+    SetCount(env, nanoseconds, name, (double) stats->nanoseconds[phase]);
+  }
+
+  napi_set_named_property(env, result, "nanoseconds", nanoseconds);
+  SetCount(env, result, "tokens", (double) stats->tokens);
+  SetCount(env, result, "nodes", (double) stats->nodes);
+  SetCount(env, result, "prism_parses", (double) stats->prism_parses);
+  SetCount(env, result, "allocations", (double) stats->allocations);
+
+  return result;
+}
+
 napi_value CreateParseResult(napi_env env, AST_DOCUMENT_NODE_T* root, napi_value source, parser_options_T* options) {
   napi_value result, errors_array, warnings_array;
 
@@ -204,5 +296,7 @@ napi_value CreateParseResult(napi_env env, AST_DOCUMENT_NODE_T* root, napi_value
 
   napi_set_named_property(env, result, "options", options_object);
 
+  if (options->stats != NULL) { napi_set_named_property(env, result, "stats", CreateParseStats(env, options->stats)); }
+
   return result;
 }
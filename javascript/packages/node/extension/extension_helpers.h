@@ -6,13 +6,17 @@
 extern "C" {
 #include "../extension/libherb/include/ast_nodes.h"
 #include "../extension/libherb/include/herb.h"
+#include "../extension/libherb/include/io.h"
 #include "../extension/libherb/include/util/hb_array.h"
 #include "../extension/libherb/include/util/hb_string.h"
 }
 
-char* CheckString(napi_env env, napi_value value);
+char* CheckString(napi_env env, napi_value value, size_t* length = nullptr);
 napi_value CreateString(napi_env env, const char* str);
 napi_value CreateStringFromHbString(napi_env env, hb_string_T string);
+void ReadParserOptions(napi_env env, napi_value value, parser_options_T* options);
+bool ReadStatsOption(napi_env env, napi_value value);
+bool MapFile(napi_env env, const char* file_path, herb_mapped_file_T* file);
 napi_value ReadFileToString(napi_env env, const char* file_path);
 napi_value CreateLexResult(napi_env env, hb_array_T* tokens, napi_value source);
 napi_value CreateParseResult(napi_env env, AST_DOCUMENT_NODE_T* root, napi_value source, parser_options_T* options);
@@ -9,6 +9,7 @@ extern "C" {
 #include "../extension/libherb/include/util/hb_buffer.h"
 }
 
+#include "async.h"
 #include "error_helpers.h"
 #include "extension_helpers.h"
 #include "nodes.h"
@@ -28,10 +29,11 @@ napi_value Herb_lex(napi_env env, napi_callback_info info) {
     return nullptr;
   }
 
-  char* string = CheckString(env, args[0]);
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
   if (!string) { return nullptr; }
 
-  hb_array_T* tokens = herb_lex(string);
+  hb_array_T* tokens = herb_lex_with_length(string, length);
   napi_value result = CreateLexResult(env, tokens, args[0]);
 
   herb_free_tokens(&tokens);
@@ -53,11 +55,21 @@ napi_value Herb_lex_file(napi_env env, napi_callback_info info) {
   char* file_path = CheckString(env, args[0]);
   if (!file_path) { return nullptr; }
 
-  hb_array_T* tokens = herb_lex_file(file_path);
-  napi_value source_value = ReadFileToString(env, file_path);
+  // The file is read once: the tokens view into it until they have been converted.
+  herb_mapped_file_T file;
+  if (!MapFile(env, file_path, &file)) {
+    free(file_path);
+    return nullptr;
+  }
+
+  hb_array_T* tokens = herb_lex_with_length(file.data, file.length);
+
+  napi_value source_value;
+  napi_create_string_utf8(env, file.data, file.length, &source_value);
   napi_value result = CreateLexResult(env, tokens, source_value);
 
   herb_free_tokens(&tokens);
+  herb_unmap_file(&file);
   free(file_path);
 
   return result;
@@ -73,62 +85,112 @@ napi_value Herb_parse(napi_env env, napi_callback_info info) {
     return nullptr;
   }
 
-  char* string = CheckString(env, args[0]);
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
+  if (!string) { return nullptr; }
+
+  parser_options_T parser_options = HERB_DEFAULT_PARSER_OPTIONS;
+  if (argc >= 2) { ReadParserOptions(env, args[1], &parser_options); }
+
+  // With stats the document is parsed into an arena, so its allocations are counted too.
+  herb_parse_stats_T parse_stats = {};
+  hb_arena_T allocator;
+  hb_arena_T* arena = nullptr;
+
+  if (argc >= 2 && ReadStatsOption(env, args[1])) {
+    parser_options.stats = &parse_stats;
+    if (hb_arena_init(&allocator, KB(64))) { arena = &allocator; }
+  }
+
+  AST_DOCUMENT_NODE_T* root = herb_parse_arena_with_length(string, length, &parser_options, arena);
+  napi_value result = CreateParseResult(env, root, args[0], &parser_options);
+
+  if (arena) {
+    hb_arena_free(arena);
+  } else {
+    ast_node_free((AST_NODE_T *) root);
+  }
+
+  free(string);
+
+  return result;
+}
+
+static void FreeSerializedBuffer(napi_env env, void* data, void* hint) {
+  free(data);
+}
+
+napi_value Herb_parse_to_buffer(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value args[2];
+  napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+  if (argc < 1) {
+    napi_throw_error(env, nullptr, "Wrong number of arguments");
+    return nullptr;
+  }
+
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
   if (!string) { return nullptr; }
 
   parser_options_T parser_options = HERB_DEFAULT_PARSER_OPTIONS;
+  char* cache_directory = nullptr;
 
   if (argc >= 2) {
+    ReadParserOptions(env, args[1], &parser_options);
+
     napi_valuetype valuetype;
     napi_typeof(env, args[1], &valuetype);
 
+    bool has_cache_directory_prop = false;
     if (valuetype == napi_object) {
-      napi_value track_whitespace_prop;
-      bool has_track_whitespace_prop;
-      napi_has_named_property(env, args[1], "track_whitespace", &has_track_whitespace_prop);
-
-      if (has_track_whitespace_prop) {
-        napi_get_named_property(env, args[1], "track_whitespace", &track_whitespace_prop);
-        bool track_whitespace_value;
-        napi_get_value_bool(env, track_whitespace_prop, &track_whitespace_value);
-
-        if (track_whitespace_value) {
-          parser_options.track_whitespace = true;
-        }
-      }
-
-      napi_value analyze_prop;
-      bool has_analyze_prop;
-      napi_has_named_property(env, args[1], "analyze", &has_analyze_prop);
+      napi_has_named_property(env, args[1], "cache_directory", &has_cache_directory_prop);
+    }
 
-      if (has_analyze_prop) {
-        napi_get_named_property(env, args[1], "analyze", &analyze_prop);
-        bool analyze_value;
-        napi_get_value_bool(env, analyze_prop, &analyze_value);
+    if (has_cache_directory_prop) {
+      napi_value cache_directory_prop;
+      napi_get_named_property(env, args[1], "cache_directory", &cache_directory_prop);
 
-        if (!analyze_value) {
-          parser_options.analyze = false;
-        }
-      }
+      napi_valuetype cache_directory_type;
+      napi_typeof(env, cache_directory_prop, &cache_directory_type);
 
-      napi_value strict_prop;
-      bool has_strict_prop;
-      napi_has_named_property(env, args[1], "strict", &has_strict_prop);
-
-      if (has_strict_prop) {
-        napi_get_named_property(env, args[1], "strict", &strict_prop);
-        bool strict_value;
-        napi_get_value_bool(env, strict_prop, &strict_value);
-        parser_options.strict = strict_value;
-      }
+      if (cache_directory_type == napi_string) { cache_directory = CheckString(env, cache_directory_prop); }
     }
   }
 
-  AST_DOCUMENT_NODE_T* root = herb_parse(string, &parser_options);
-  napi_value result = CreateParseResult(env, root, args[0], &parser_options);
+  hb_buffer_T output;
+  if (!hb_buffer_init(&output, length * 4)) {
+    free(string);
+    free(cache_directory);
+    napi_throw_error(env, nullptr, "Failed to initialize buffer");
+    return nullptr;
+  }
+
+  herb_parse_to_buffer_cached_with_length(string, length, &parser_options, cache_directory, &output);
 
-  ast_node_free((AST_NODE_T *) root);
   free(string);
+  free(cache_directory);
+
+  // Hands the serialized bytes to JavaScript without copying them; runtimes that don't allow external
+  // buffers (e.g. with the V8 sandbox enabled) get a copy instead.
+  napi_value result;
+  napi_status status =
+    napi_create_external_arraybuffer(env, output.value, output.length, FreeSerializedBuffer, nullptr, &result);
+
+  if (status != napi_ok) {
+    void* data;
+    status = napi_create_arraybuffer(env, output.length, &data, &result);
+
+    if (status == napi_ok) { memcpy(data, output.value, output.length); }
+
+    free(output.value);
+
+    if (status != napi_ok) {
+      napi_throw_error(env, nullptr, "Failed to create ArrayBuffer");
+      return nullptr;
+    }
+  }
 
   return result;
 }
@@ -146,21 +208,22 @@ napi_value Herb_parse_file(napi_env env, napi_callback_info info) {
   char* file_path = CheckString(env, args[0]);
   if (!file_path) { return nullptr; }
 
-  napi_value source_value = ReadFileToString(env, file_path);
-
-  char* string = CheckString(env, source_value);
-  if (!string) {
+  herb_mapped_file_T file;
+  if (!MapFile(env, file_path, &file)) {
     free(file_path);
     return nullptr;
   }
 
+  napi_value source_value;
+  napi_create_string_utf8(env, file.data, file.length, &source_value);
+
   parser_options_T parser_options = HERB_DEFAULT_PARSER_OPTIONS;
-  AST_DOCUMENT_NODE_T* root = herb_parse(string, &parser_options);
+  AST_DOCUMENT_NODE_T* root = herb_parse_with_length(file.data, file.length, &parser_options);
   napi_value result = CreateParseResult(env, root, source_value, &parser_options);
 
   ast_node_free((AST_NODE_T *) root);
+  herb_unmap_file(&file);
   free(file_path);
-  free(string);
 
   return result;
 }
@@ -175,11 +238,12 @@ napi_value Herb_extract_ruby(napi_env env, napi_callback_info info) {
     return nullptr;
   }
 
-  char* string = CheckString(env, args[0]);
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
   if (!string) { return nullptr; }
 
   hb_buffer_T output;
-  if (!hb_buffer_init(&output, strlen(string))) {
+  if (!hb_buffer_init(&output, length)) {
     free(string);
     napi_throw_error(env, nullptr, "Failed to initialize buffer");
     return nullptr;
@@ -221,7 +285,7 @@ napi_value Herb_extract_ruby(napi_env env, napi_callback_info info) {
     }
   }
 
-  herb_extract_ruby_to_buffer_with_options(string, &output, &extract_options);
+  herb_extract_ruby_to_buffer_with_length(string, length, &output, &extract_options);
 
   napi_value result;
   napi_create_string_utf8(env, output.value, NAPI_AUTO_LENGTH, &result);
@@ -241,17 +305,18 @@ napi_value Herb_extract_html(napi_env env, napi_callback_info info) {
     return nullptr;
   }
 
-  char* string = CheckString(env, args[0]);
+  size_t length;
+  char* string = CheckString(env, args[0], &length);
   if (!string) { return nullptr; }
 
   hb_buffer_T output;
-  if (!hb_buffer_init(&output, strlen(string))) {
+  if (!hb_buffer_init(&output, length)) {
     free(string);
     napi_throw_error(env, nullptr, "Failed to initialize buffer");
     return nullptr;
   }
 
-  herb_extract_html_to_buffer(string, &output);
+  herb_extract_html_to_buffer_with_length(string, length, &output);
 
   napi_value result;
   napi_create_string_utf8(env, output.value, NAPI_AUTO_LENGTH, &result);
@@ -277,6 +342,10 @@ napi_value Herb_version(napi_env env, napi_callback_info info) {
 napi_value Init(napi_env env, napi_value exports) {
   napi_property_descriptor descriptors[] = {
     { "parse", nullptr, Herb_parse, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "parseToBuffer", nullptr, Herb_parse_to_buffer, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "parseAsync", nullptr, Herb_parse_async, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "lexAsync", nullptr, Herb_lex_async, nullptr, nullptr, nullptr, napi_default, nullptr },
+    { "parseFilesAsync", nullptr, Herb_parse_files_async, nullptr, nullptr, nullptr, napi_default, nullptr },
     { "lex", nullptr, Herb_lex, nullptr, nullptr, nullptr, napi_default, nullptr },
     { "parseFile", nullptr, Herb_parse_file, nullptr, nullptr, nullptr, napi_default, nullptr },
     { "lexFile", nullptr, Herb_lex_file, nullptr, nullptr, nullptr, napi_default, nullptr },
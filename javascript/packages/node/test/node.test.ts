@@ -1,4 +1,7 @@
 import dedent from "dedent"
+import { mkdtempSync, rmSync, writeFileSync } from "fs"
+import { tmpdir } from "os"
+import { join } from "path"
 import { describe, test, expect, beforeAll } from "vitest"
 import { Herb, HerbBackend } from "../src/index-esm.mjs"
 
@@ -155,4 +158,110 @@ describe("@herb-tools/node", () => {
     expect(whenNode.then_keyword.end.line).toBe(2)
     expect(whenNode.then_keyword.end.column).toBe(19)
   })
+
+  test("parseToBuffer() returns an ArrayBuffer", () => {
+    const buffer = Herb.backend!.parseToBuffer!("<p>Hello</p>")
+
+    expect(buffer).toBeInstanceOf(ArrayBuffer)
+    expect(new TextDecoder().decode(new Uint8Array(buffer, 0, 4))).toBe("HERB")
+  })
+
+  test("parseLazy() matches parse()", () => {
+    const content = dedent`
+      <div class="héllo"><span></div>
+      <%= user.name %>
+      <% if admin? %><p>Welcome</p><% end %>
+    `
+
+    const eager = Herb.parse(content)
+    const lazy = Herb.parseLazy(content)
+
+    expect(lazy.value.toJSON()).toEqual(eager.value.toJSON())
+    expect(lazy.value.inspect()).toBe(eager.value.inspect())
+    expect(lazy.recursiveErrors().length).toBe(eager.recursiveErrors().length)
+  })
+
+  test("parseLazy() passes parser options through", () => {
+    const content = '<div   class="example"  >content</div   >'
+
+    const eager = Herb.parse(content, { track_whitespace: true })
+    const lazy = Herb.parseLazy(content, { track_whitespace: true })
+
+    expect(lazy.options.track_whitespace).toBe(true)
+    expect(lazy.value.inspect()).toBe(eager.value.inspect())
+  })
+
+  test("parseLazy() reuses documents from the cache directory", () => {
+    const directory = mkdtempSync(join(tmpdir(), "herb-cache-"))
+    const content = '<div class="example"><%= user.name %></span>'
+
+    try {
+      const first = Herb.parseLazy(content, { cache_directory: directory })
+      const second = Herb.parseLazy(content, { cache_directory: directory })
+
+      expect(second.value.inspect()).toBe(Herb.parse(content).value.inspect())
+      expect(second.recursiveErrors().length).toBe(first.recursiveErrors().length)
+    } finally {
+      rmSync(directory, { recursive: true, force: true })
+    }
+  })
+
+  test("parse() collects stats when asked to", () => {
+    const content = "<div><% if admin? %><p><%= user.name %></p><% end %></div>"
+
+    const result = Herb.parse(content, { stats: true })
+
+    expect(result.stats).not.toBeNull()
+    expect(result.stats!.tokens).toBeGreaterThan(0)
+    expect(result.stats!.nodes).toBeGreaterThan(0)
+    expect(result.stats!.prism_parses).toBeGreaterThan(0)
+    expect(result.stats!.allocations).toBeGreaterThan(0)
+    expect(Object.keys(result.stats!.nanoseconds)).toContain("match_tags")
+    expect(result.value.inspect()).toBe(Herb.parse(content).value.inspect())
+    expect(Herb.parse(content).stats).toBeNull()
+  })
+
+  test("parseAsync() resolves with the same result as parse()", async () => {
+    const content = '<div class="example"><%= user.name %></div>'
+
+    const result = await Herb.parseAsync(content, { track_whitespace: true })
+
+    expect(result.value.inspect()).toBe(Herb.parse(content, { track_whitespace: true }).value.inspect())
+    expect(result.options.track_whitespace).toBe(true)
+    expect(result.source).toBe(content)
+  })
+
+  test("lexAsync() resolves with the same tokens as lex()", async () => {
+    const content = "<p><%= title %></p>"
+
+    const result = await Herb.lexAsync(content)
+
+    expect(result.value.inspect()).toBe(Herb.lex(content).value.inspect())
+  })
+
+  test("parseFilesAsync() parses every file in order", async () => {
+    const directory = mkdtempSync(join(tmpdir(), "herb-"))
+    const sources = ["<h1><%= title %></h1>", "<p>Hello</p>", "<div><span></div>"]
+    const paths = sources.map((source, index) => {
+      const path = join(directory, `${index}.html.erb`)
+      writeFileSync(path, source)
+
+      return path
+    })
+
+    try {
+      const results = await Herb.parseFilesAsync(paths)
+
+      expect(results.map((result) => result.source)).toEqual(sources)
+      expect(results.map((result) => result.value.inspect())).toEqual(
+        sources.map((source) => Herb.parse(source).value.inspect()),
+      )
+
+      await expect(Herb.parseFilesAsync([paths[0], join(directory, "missing.html.erb")])).rejects.toThrow(
+        "Failed to read file",
+      )
+    } finally {
+      rmSync(directory, { recursive: true, force: true })
+    }
+  })
 })
@@ -5,19 +5,34 @@ require "json"
 
 module Herb
   class ParseResult < Result
-    attr_reader :value #: Herb::AST::DocumentNode
     attr_reader :options #: Herb::ParserOptions
 
-    #: (Herb::AST::DocumentNode, String, Array[Herb::Warnings::Warning], Array[Herb::Errors::Error], Herb::ParserOptions) -> void
-    def initialize(value, source, warnings, errors, options)
+    # With `stats: true`, the nanoseconds spent in each parsing phase (e.g. `:lex`, `:transform` or
+    # `:match_tags`) under `:nanoseconds`, and the number of `:tokens`, `:nodes`, `:prism_parses` and arena
+    # `:allocations`. Otherwise nil.
+    attr_reader :stats #: Hash[Symbol, untyped]?
+
+    # `value` is a Herb::LazyDocument when parsed with `lazy: true`, in which case the Ruby nodes are only built
+    # once #value is first called. #errors doesn't need them.
+    #: (Herb::AST::DocumentNode | Herb::LazyDocument, String, Array[Herb::Warnings::Warning], Array[Herb::Errors::Error], Herb::ParserOptions, ?Hash[Symbol, untyped]?) -> void
+    def initialize(value, source, warnings, errors, options, stats = nil)
       @value = value
       @options = options
+      @stats = stats
       super(source, warnings, errors)
     end
 
+    #: () -> Herb::AST::DocumentNode
+    def value
+      @value = @value.value if @value.is_a?(LazyDocument)
+      @value
+    end
+
     #: () -> Array[Herb::Errors::Error]
     def errors
-      super + value.recursive_errors
+      document_errors = @value.is_a?(LazyDocument) ? @value.errors : value.recursive_errors
+
+      super + document_errors
     end
 
     #: () -> bool
@@ -10,6 +10,7 @@
 #include "../include/ast_nodes.h"
 #include "../include/errors.h"
 #include "../include/location.h"
+#include "../include/parse_stats.h"
 #include "../include/parser.h"
 #include "../include/position.h"
 #include "../include/token_struct.h"
@@ -24,79 +25,67 @@
 #include <stdlib.h>
 #include <string.h>
 
-static analyzed_ruby_T* herb_analyze_ruby(hb_string_T source) {
-  analyzed_ruby_T* analyzed = init_analyzed_ruby(source);
-
-  pm_visit_node(analyzed->root, search_if_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_block_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_case_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_case_match_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_while_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_for_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_until_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_begin_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_unless_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_when_nodes, analyzed);
-  pm_visit_node(analyzed->root, search_in_nodes, analyzed);
-
-  search_unexpected_elsif_nodes(analyzed);
-  search_unexpected_else_nodes(analyzed);
-  search_unexpected_end_nodes(analyzed);
-  search_unexpected_when_nodes(analyzed);
-  search_unexpected_in_nodes(analyzed);
-
-  search_unexpected_rescue_nodes(analyzed);
-  search_unexpected_ensure_nodes(analyzed);
-  search_yield_nodes(analyzed->root, analyzed);
-  search_then_keywords(analyzed->root, analyzed);
-  search_unexpected_block_closing_nodes(analyzed);
-
-  if (!analyzed->valid) { pm_visit_node(analyzed->root, search_unclosed_control_flows, analyzed); }
+static analyzed_ruby_T* herb_analyze_ruby(hb_string_T source, hb_arena_T* allocator) {
+  analyzed_ruby_T* analyzed = init_analyzed_ruby(allocator);
+
+  if (!analyzed) { return NULL; }
+
+  pm_parser_t parser;
+  pm_parser_init(&parser, (const uint8_t*) source.data, source.length, NULL);
+
+  pm_node_t* root = pm_parse(&parser);
+  herb_parse_stats_count_prism_parse();
+  analyzed->valid = (parser.error_list.size == 0);
+  analyzed->parsed = true;
+
+  ruby_search_context_T context = { .analyzed = analyzed, .source_start = parser.start };
+
+  pm_visit_node(root, search_ruby_nodes, &context);
+  search_ruby_errors(&parser, analyzed);
+
+  if (!analyzed->valid && (analyzed->unclosed_control_flow_count > 0 || has_yield_node(analyzed))) {
+    analyzed->earliest_control_type = find_earliest_control_keyword(root, parser.start);
+  }
+
+  pm_node_destroy(&parser, root);
+  pm_parser_free(&parser);
 
   return analyzed;
 }
 
-static bool analyze_erb_content(const AST_NODE_T* node, void* data) {
-  const parser_options_T* options = (const parser_options_T*) data;
-
-  if (node->type == AST_ERB_CONTENT_NODE) {
-    AST_ERB_CONTENT_NODE_T* erb_content_node = (AST_ERB_CONTENT_NODE_T*) node;
+static void analyze_erb_content(AST_ERB_CONTENT_NODE_T* erb_content_node, const parser_options_T* options) {
+  if (erb_content_node->analyzed_ruby != NULL) { return; }
 
-    const char* opening = erb_content_node->tag_opening->value;
+  hb_string_T opening = erb_content_node->tag_opening->value;
 
-    if (!string_equals(opening, "<%%") && !string_equals(opening, "<%%=") && !string_equals(opening, "<%#")
-        && !string_equals(opening, "<%graphql")) {
-      analyzed_ruby_T* analyzed = herb_analyze_ruby(hb_string(erb_content_node->content->value));
+  if (!hb_string_equals(opening, hb_string("<%%")) && !hb_string_equals(opening, hb_string("<%%="))
+      && !hb_string_equals(opening, hb_string("<%#")) && !hb_string_equals(opening, hb_string("<%graphql"))) {
+    analyzed_ruby_T* analyzed = herb_analyze_ruby(erb_content_node->content->value, erb_content_node->base.allocator);
 
-      erb_content_node->parsed = true;
-      erb_content_node->valid = analyzed->valid;
-      erb_content_node->analyzed_ruby = analyzed;
+    erb_content_node->parsed = true;
+    erb_content_node->valid = analyzed->valid;
+    erb_content_node->analyzed_ruby = analyzed;
 
-      if (!analyzed->valid && analyzed->unclosed_control_flow_count >= 2) {
-        append_erb_multiple_blocks_in_tag_error(
-          erb_content_node->base.location.start,
-          erb_content_node->base.location.end,
-          erb_content_node->base.errors
-        );
-      }
+    if (!analyzed->valid && analyzed->unclosed_control_flow_count >= 2) {
+      append_erb_multiple_blocks_in_tag_error(
+        erb_content_node->base.location.start,
+        erb_content_node->base.location.end,
+        erb_content_node->base.errors
+      );
+    }
 
-      if (options && options->strict && !analyzed->valid && has_inline_case_condition(analyzed)) {
-        append_erb_case_with_conditions_error(
-          erb_content_node->base.location.start,
-          erb_content_node->base.location.end,
-          erb_content_node->base.errors
-        );
-      }
-    } else {
-      erb_content_node->parsed = false;
-      erb_content_node->valid = true;
-      erb_content_node->analyzed_ruby = NULL;
+    if (options && options->strict && !analyzed->valid && has_inline_case_condition(analyzed)) {
+      append_erb_case_with_conditions_error(
+        erb_content_node->base.location.start,
+        erb_content_node->base.location.end,
+        erb_content_node->base.errors
+      );
     }
+  } else {
+    erb_content_node->parsed = false;
+    erb_content_node->valid = true;
+    erb_content_node->analyzed_ruby = NULL;
   }
-
-  herb_visit_child_nodes(node, analyze_erb_content, data);
-
-  return false;
 }
 
 static size_t process_block_children(
@@ -182,6 +171,7 @@ static void collect_children_until(
 static AST_ERB_END_NODE_T* build_end_node(AST_ERB_CONTENT_NODE_T* end_erb) {
   if (!end_erb) { return NULL; }
 
+  hb_arena_T* allocator = end_erb->base.allocator;
   hb_array_T* end_errors = end_erb->base.errors;
   end_erb->base.errors = NULL;
 
@@ -191,7 +181,8 @@ static AST_ERB_END_NODE_T* build_end_node(AST_ERB_CONTENT_NODE_T* end_erb) {
     end_erb->tag_closing,
     end_erb->tag_opening->location.start,
     erb_content_end_position(end_erb),
-    end_errors
+    end_errors,
+    allocator
   );
 
   ast_node_free((AST_NODE_T*) end_erb);
@@ -275,9 +266,10 @@ static size_t process_case_structure(
   AST_ERB_CONTENT_NODE_T* erb_node = get_erb_content_at(array, index);
   if (!erb_node) { return index; }
 
-  hb_array_T* when_conditions = hb_array_init(8);
-  hb_array_T* in_conditions = hb_array_init(8);
-  hb_array_T* non_when_non_in_children = hb_array_init(8);
+  hb_arena_T* allocator = erb_node->base.allocator;
+  hb_array_T* when_conditions = hb_array_init_arena(allocator, 8);
+  hb_array_T* in_conditions = hb_array_init_arena(allocator, 8);
+  hb_array_T* non_when_non_in_children = hb_array_init_arena(allocator, 8);
 
   analyzed_ruby_T* analyzed = erb_node->analyzed_ruby;
   bool has_inline_when = has_case_node(analyzed) && has_when_node(analyzed);
@@ -297,7 +289,7 @@ static size_t process_case_structure(
   // Create a synthetic when/in node for inline when/in (e.g., <% case variable when "a" %>),
   if (has_inline_when || has_inline_in) {
     hb_array_T* statements = non_when_non_in_children;
-    non_when_non_in_children = hb_array_init(8);
+    non_when_non_in_children = hb_array_init_arena(allocator, 8);
 
     position_T start_position =
       erb_node->tag_closing ? erb_node->tag_closing->location.end : erb_node->content->location.end;
@@ -309,13 +301,31 @@ static size_t process_case_structure(
     }
 
     if (has_inline_when) {
-      AST_NODE_T* synthetic_node = (AST_NODE_T*)
-        ast_erb_when_node_init(NULL, NULL, NULL, NULL, statements, start_position, end_position, hb_array_init(0));
+      AST_NODE_T* synthetic_node = (AST_NODE_T*) ast_erb_when_node_init(
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        statements,
+        start_position,
+        end_position,
+        hb_array_init_arena(allocator, 0),
+        allocator
+      );
 
       hb_array_append(when_conditions, synthetic_node);
     } else {
-      AST_NODE_T* synthetic_node = (AST_NODE_T*)
-        ast_erb_in_node_init(NULL, NULL, NULL, NULL, statements, start_position, end_position, hb_array_init(0));
+      AST_NODE_T* synthetic_node = (AST_NODE_T*) ast_erb_in_node_init(
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        statements,
+        start_position,
+        end_position,
+        hb_array_init_arena(allocator, 0),
+        allocator
+      );
 
       hb_array_append(in_conditions, synthetic_node);
     }
@@ -337,7 +347,7 @@ static size_t process_case_structure(
     control_type_t next_type = detect_control_type(next_erb);
 
     if (next_type == CONTROL_TYPE_WHEN || next_type == CONTROL_TYPE_IN) {
-      hb_array_T* statements = hb_array_init(8);
+      hb_array_T* statements = hb_array_init_arena(allocator, 8);
       index++;
       index = process_block_children(node, array, index, statements, context, next_type);
 
@@ -359,7 +369,8 @@ static size_t process_case_structure(
           statements,
           cond_start,
           cond_end,
-          cond_errors
+          cond_errors,
+          allocator
         );
       } else {
         condition_node = (AST_NODE_T*) ast_erb_in_node_init(
@@ -370,7 +381,8 @@ static size_t process_case_structure(
           statements,
           cond_start,
           cond_end,
-          cond_errors
+          cond_errors,
+          allocator
         );
       }
 
@@ -390,7 +402,7 @@ static size_t process_case_structure(
   AST_ERB_CONTENT_NODE_T* next_erb = NULL;
 
   if (peek_control_type(array, index, &next_type, &next_erb) && next_type == CONTROL_TYPE_ELSE) {
-    hb_array_T* else_children = hb_array_init(8);
+    hb_array_T* else_children = hb_array_init_arena(allocator, 8);
     index++;
 
     index = process_block_children(node, array, index, else_children, context, CONTROL_TYPE_CASE);
@@ -405,7 +417,8 @@ static size_t process_case_structure(
       else_children,
       next_erb->tag_opening->location.start,
       erb_content_end_position(next_erb),
-      else_errors
+      else_errors,
+      allocator
     );
 
     ast_node_free((AST_NODE_T*) next_erb);
@@ -443,7 +456,8 @@ static size_t process_case_structure(
       end_node,
       start_position,
       end_position,
-      node_errors
+      node_errors,
+      allocator
     );
 
     ast_node_free((AST_NODE_T*) erb_node);
@@ -462,7 +476,8 @@ static size_t process_case_structure(
     end_node,
     start_position,
     end_position,
-    node_errors
+    node_errors,
+    allocator
   );
 
   ast_node_free((AST_NODE_T*) erb_node);
@@ -481,7 +496,9 @@ static size_t process_begin_structure(
 ) {
   AST_ERB_CONTENT_NODE_T* erb_node = get_erb_content_at(array, index);
   if (!erb_node) { return index; }
-  hb_array_T* children = hb_array_init(8);
+
+  hb_arena_T* allocator = erb_node->base.allocator;
+  hb_array_T* children = hb_array_init_arena(allocator, 8);
 
   index++;
   index = process_block_children(node, array, index, children, context, CONTROL_TYPE_BEGIN);
@@ -500,7 +517,7 @@ static size_t process_begin_structure(
   }
 
   if (peek_control_type(array, index, &next_type, &next_erb) && next_type == CONTROL_TYPE_ELSE) {
-    hb_array_T* else_children = hb_array_init(8);
+    hb_array_T* else_children = hb_array_init_arena(allocator, 8);
     index++;
 
     index = process_block_children(node, array, index, else_children, context, CONTROL_TYPE_BEGIN);
@@ -515,14 +532,15 @@ static size_t process_begin_structure(
       else_children,
       next_erb->tag_opening->location.start,
       erb_content_end_position(next_erb),
-      else_errors
+      else_errors,
+      allocator
     );
 
     ast_node_free((AST_NODE_T*) next_erb);
   }
 
   if (peek_control_type(array, index, &next_type, &next_erb) && next_type == CONTROL_TYPE_ENSURE) {
-    hb_array_T* ensure_children = hb_array_init(8);
+    hb_array_T* ensure_children = hb_array_init_arena(allocator, 8);
     index++;
 
     const control_type_t ensure_stop[] = { CONTROL_TYPE_END };
@@ -538,7 +556,8 @@ static size_t process_begin_structure(
       ensure_children,
       next_erb->tag_opening->location.start,
       erb_content_end_position(next_erb),
-      ensure_errors
+      ensure_errors,
+      allocator
     );
 
     ast_node_free((AST_NODE_T*) next_erb);
@@ -574,7 +593,8 @@ static size_t process_begin_structure(
     end_node,
     start_position,
     end_position,
-    begin_errors
+    begin_errors,
+    allocator
   );
 
   ast_node_free((AST_NODE_T*) erb_node);
@@ -593,7 +613,9 @@ static size_t process_generic_structure(
 ) {
   AST_ERB_CONTENT_NODE_T* erb_node = get_erb_content_at(array, index);
   if (!erb_node) { return index; }
-  hb_array_T* children = hb_array_init(8);
+
+  hb_arena_T* allocator = erb_node->base.allocator;
+  hb_array_T* children = hb_array_init_arena(allocator, 8);
 
   index++;
   index = process_block_children(node, array, index, children, context, initial_type);
@@ -641,7 +663,7 @@ static size_t process_subsequent_block(
   if (!erb_node) { return index; }
 
   control_type_t type = detect_control_type(erb_node);
-  hb_array_T* children = hb_array_init(8);
+  hb_array_T* children = hb_array_init_arena(erb_node->base.allocator, 8);
 
   index++;
 
@@ -742,9 +764,18 @@ static size_t process_block_children(
 }
 
 hb_array_T* rewrite_node_array(AST_NODE_T* node, hb_array_T* array, analyze_ruby_context_T* context) {
-  hb_array_T* new_array = hb_array_init(hb_array_size(array));
+  hb_array_T* new_array = hb_array_init_arena(node->allocator, hb_array_size(array));
   size_t index = 0;
 
+  // Every tag needs its Ruby analyzed before the structures spanning it can be found.
+  for (size_t i = 0; i < hb_array_size(array); i++) {
+    AST_NODE_T* item = hb_array_get(array, i);
+
+    if (item && item->type == AST_ERB_CONTENT_NODE) {
+      analyze_erb_content((AST_ERB_CONTENT_NODE_T*) item, context->options);
+    }
+  }
+
   while (index < hb_array_size(array)) {
     AST_NODE_T* item = hb_array_get(array, index);
 
@@ -785,40 +816,139 @@ hb_array_T* rewrite_node_array(AST_NODE_T* node, hb_array_T* array, analyze_ruby
   return new_array;
 }
 
-void herb_analyze_parse_tree(AST_DOCUMENT_NODE_T* document, const char* source, const parser_options_T* options) {
-  herb_visit_node((AST_NODE_T*) document, analyze_erb_content, (void*) options);
+// The arrays the conditional element and conditional open tag transforms look at: the bodies of elements and of
+// control flow. Neither looks inside of an element's open or close tag.
+static bool is_conditional_body(const AST_NODE_T* node, const hb_array_T* array) {
+  switch (node->type) {
+    case AST_DOCUMENT_NODE: return array == ((const AST_DOCUMENT_NODE_T*) node)->children;
+    case AST_HTML_ELEMENT_NODE: return array == ((const AST_HTML_ELEMENT_NODE_T*) node)->body;
+    case AST_ERB_IF_NODE: return array == ((const AST_ERB_IF_NODE_T*) node)->statements;
+    case AST_ERB_ELSE_NODE: return array == ((const AST_ERB_ELSE_NODE_T*) node)->statements;
+    case AST_ERB_UNLESS_NODE: return array == ((const AST_ERB_UNLESS_NODE_T*) node)->statements;
+    case AST_ERB_BLOCK_NODE: return array == ((const AST_ERB_BLOCK_NODE_T*) node)->body;
+    case AST_ERB_WHILE_NODE: return array == ((const AST_ERB_WHILE_NODE_T*) node)->statements;
+    case AST_ERB_UNTIL_NODE: return array == ((const AST_ERB_UNTIL_NODE_T*) node)->statements;
+    case AST_ERB_FOR_NODE: return array == ((const AST_ERB_FOR_NODE_T*) node)->statements;
+    case AST_ERB_CASE_NODE: return array == ((const AST_ERB_CASE_NODE_T*) node)->children;
+    case AST_ERB_CASE_MATCH_NODE: return array == ((const AST_ERB_CASE_MATCH_NODE_T*) node)->children;
+    case AST_ERB_WHEN_NODE: return array == ((const AST_ERB_WHEN_NODE_T*) node)->statements;
+    case AST_ERB_IN_NODE: return array == ((const AST_ERB_IN_NODE_T*) node)->statements;
+    case AST_ERB_BEGIN_NODE: return array == ((const AST_ERB_BEGIN_NODE_T*) node)->statements;
+    case AST_ERB_RESCUE_NODE: return array == ((const AST_ERB_RESCUE_NODE_T*) node)->statements;
+    case AST_ERB_ENSURE_NODE: return array == ((const AST_ERB_ENSURE_NODE_T*) node)->statements;
+    default: return false;
+  }
+}
+
+void transform_conditionals_in_array(const AST_NODE_T* node, hb_array_T* array, analyze_ruby_context_T* context) {
+  if (context->element_tag_depth > 0) { return; }
 
-  analyze_ruby_context_T* context = malloc(sizeof(analyze_ruby_context_T));
+  hb_array_T* document_errors = context->document->base.errors;
 
-  if (!context) { return; }
+  if (!is_conditional_body(node, array)) {
+    herb_transform_conditional_open_tags_in_branches(array, document_errors);
+    return;
+  }
 
-  context->document = document;
-  context->parent = NULL;
-  context->ruby_context_stack = hb_array_init(8);
+  // Conditional elements aren't looked for in the branches of `case ... in`.
+  if (node->type != AST_ERB_CASE_MATCH_NODE && node->type != AST_ERB_IN_NODE) {
+    herb_transform_conditional_elements_in_array(array, document_errors);
+  }
 
-  herb_visit_node((AST_NODE_T*) document, transform_erb_nodes, context);
-  herb_transform_conditional_elements(document);
-  herb_transform_conditional_open_tags(document);
+  // Conditional elements are built from the branches of the `if` and `unless` nodes next to each other, so these
+  // branches get their conditional open tags with the array holding the conditional, after it has been checked.
+  if (node->type == AST_ERB_IF_NODE || node->type == AST_ERB_UNLESS_NODE) { return; }
 
-  invalid_erb_context_T* invalid_context = malloc(sizeof(invalid_erb_context_T));
+  herb_transform_conditional_open_tags_in_array(array, document_errors);
+}
 
-  if (!invalid_context) {
-    hb_array_free(&context->ruby_context_stack);
-    free(context);
-    return;
+typedef struct {
+  const analyze_hook_T* hooks;
+  size_t hook_count;
+  const AST_NODE_T* parent;
+  unsigned int active;
+} analyze_walk_T;
+
+static bool analyze_walk_visitor(const AST_NODE_T* node, void* data) {
+  analyze_walk_T* walk = (analyze_walk_T*) data;
+  const AST_NODE_T* parent = walk->parent;
+  unsigned int active = walk->active;
+  unsigned int descend = 0;
+
+  for (size_t index = 0; index < walk->hook_count; index++) {
+    const analyze_hook_T* hook = &walk->hooks[index];
+
+    if ((active & (1u << index)) && hook->enter(node, parent, hook->data)) { descend |= 1u << index; }
   }
 
-  invalid_context->loop_depth = 0;
-  invalid_context->rescue_depth = 0;
+  if (descend != 0) {
+    walk->parent = node;
+    walk->active = descend;
+
+    herb_visit_child_nodes(node, analyze_walk_visitor, walk);
+
+    walk->parent = parent;
+    walk->active = active;
+  }
+
+  for (size_t index = walk->hook_count; index > 0; index--) {
+    const analyze_hook_T* hook = &walk->hooks[index - 1];
+
+    if ((active & (1u << (index - 1))) && hook->leave != NULL) { hook->leave(node, parent, hook->data); }
+  }
+
+  return false;
+}
+
+// Runs all hooks in one walk over the document. A hook sees each node before its children, after the hooks
+// listed before it, and its `leave` once the children have been walked.
+static void analyze_walk(AST_DOCUMENT_NODE_T* document, const analyze_hook_T* hooks, size_t hook_count) {
+  analyze_walk_T walk = { .hooks = hooks, .hook_count = hook_count, .parent = NULL, .active = (1u << hook_count) - 1 };
+
+  analyze_walk_visitor((const AST_NODE_T*) document, &walk);
+}
+
+// Adds the time since `*start` to `phase` and restarts the clock, when parsing with stats.
+static void analyze_stats_phase(herb_parse_stats_T* stats, herb_parse_phase_T phase, uint64_t* start) {
+  if (stats == NULL) { return; }
+
+  uint64_t now = herb_parse_stats_clock();
+  stats->nanoseconds[phase] += now - *start;
+  *start = now;
+}
+
+// The analysis takes two walks over the document. The first parses the Ruby of every ERB tag and rebuilds the
+// tree around the control flow and conditional elements it finds. The second runs the checks that need the
+// finished tree, while matching the open and close tags that are left and collecting the Ruby for one last
+// parse of the whole template.
+void herb_analyze_parse_tree(
+  AST_DOCUMENT_NODE_T* document,
+  const char* source,
+  size_t source_length,
+  const parser_options_T* options
+) {
+  herb_parse_stats_T* stats = options != NULL ? options->stats : NULL;
+  uint64_t start = stats != NULL ? herb_parse_stats_clock() : 0;
+
+  analyze_ruby_context_T context = { .document = document, .options = options, .element_tag_depth = 0 };
 
-  herb_visit_node((AST_NODE_T*) document, detect_invalid_erb_structures, invalid_context);
+  herb_visit_node((AST_NODE_T*) document, transform_erb_nodes, &context);
+  analyze_stats_phase(stats, HERB_PARSE_PHASE_TRANSFORM, &start);
 
-  herb_analyze_parse_errors(document, source);
+  invalid_erb_context_T invalid_context = { .loop_depth = 0, .rescue_depth = 0 };
+  match_tags_context_T match_tags_context = { .options = options };
+  parse_errors_context_T parse_errors_context;
+  bool collect_ruby = herb_analyze_parse_errors_init(&parse_errors_context, source, source_length);
 
-  herb_parser_match_html_tags_post_analyze(document, options);
+  const analyze_hook_T hooks[] = {
+    { detect_invalid_erb_structures, detect_invalid_erb_structures_leave, &invalid_context },
+    { match_tags_visitor, NULL, &match_tags_context },
+    { herb_analyze_parse_errors_collect, NULL, &parse_errors_context },
+  };
 
-  hb_array_free(&context->ruby_context_stack);
+  analyze_walk(document, hooks, collect_ruby ? 3 : 2);
+  analyze_stats_phase(stats, HERB_PARSE_PHASE_MATCH_TAGS, &start);
 
-  free(context);
-  free(invalid_context);
+  if (collect_ruby) { herb_analyze_parse_errors(document, source, &parse_errors_context); }
+  analyze_stats_phase(stats, HERB_PARSE_PHASE_PARSE_ERRORS, &start);
 }
@@ -4,10 +4,12 @@
 #include "../include/location.h"
 #include "../include/position.h"
 #include "../include/prism_helpers.h"
+#include "../include/token.h"
 #include "../include/token_struct.h"
 #include "../include/util/hb_array.h"
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 position_T erb_content_end_position(const AST_ERB_CONTENT_NODE_T* erb_node) {
@@ -27,7 +29,7 @@ location_T* compute_then_keyword(AST_ERB_CONTENT_NODE_T* erb_node, control_type_
   }
 
   token_T* content = erb_node->content;
-  const char* source = content ? content->value : NULL;
+  char* source = token_value_to_c_string(content);
   location_T* then_keyword = NULL;
 
   if (control_type == CONTROL_TYPE_WHEN || control_type == CONTROL_TYPE_IN) {
@@ -51,6 +53,16 @@ location_T* compute_then_keyword(AST_ERB_CONTENT_NODE_T* erb_node, control_type_
     then_keyword->end.column = content_start.column + then_keyword->end.column;
   }
 
+  free(source);
+
+  if (then_keyword != NULL && erb_node->base.allocator != NULL) {
+    location_T* arena_then_keyword = hb_arena_alloc(erb_node->base.allocator, sizeof(location_T));
+    *arena_then_keyword = *then_keyword;
+    free(then_keyword);
+
+    then_keyword = arena_then_keyword;
+  }
+
   return then_keyword;
 }
 
@@ -66,6 +78,7 @@ typedef struct {
   position_T start_position;
   position_T end_position;
   hb_array_T* errors;
+  hb_arena_T* allocator;
   control_type_t control_type;
 } control_builder_context_T;
 
@@ -125,6 +138,7 @@ AST_NODE_T* create_control_node(
                                         .start_position = erb_node->tag_opening->location.start,
                                         .end_position = erb_content_end_position(erb_node),
                                         .errors = erb_node->base.errors,
+                                        .allocator = erb_node->base.allocator,
                                         .control_type = control_type };
 
   erb_node->base.errors = NULL;
@@ -156,7 +170,8 @@ static AST_NODE_T* build_if_node(control_builder_context_T* context) {
     context->end_node,
     context->start_position,
     context->end_position,
-    context->errors
+    context->errors,
+    context->allocator
   );
 }
 
@@ -168,7 +183,8 @@ static AST_NODE_T* build_else_node(control_builder_context_T* context) {
     context->children,
     context->start_position,
     context->end_position,
-    context->errors
+    context->errors,
+    context->allocator
   );
 }
 
@@ -181,7 +197,8 @@ static AST_NODE_T* build_when_node(control_builder_context_T* context) {
     context->children,
     context->start_position,
     context->end_position,
-    context->errors
+    context->errors,
+    context->allocator
   );
 }
 
@@ -194,7 +211,8 @@ static AST_NODE_T* build_in_node(control_builder_context_T* context) {
     context->children,
     context->start_position,
     context->end_position,
-    context->errors
+    context->errors,
+    context->allocator
   );
 }
 
@@ -213,7 +231,8 @@ static AST_NODE_T* build_rescue_node(control_builder_context_T* context) {
     rescue_node,
     context->start_position,
     context->end_position,
-    context->errors
+    context->errors,
+    context->allocator
   );
 }
 
@@ -225,7 +244,8 @@ static AST_NODE_T* build_ensure_node(control_builder_context_T* context) {
     context->children,
     context->start_position,
     context->end_position,
-    context->errors
+    context->errors,
+    context->allocator
   );
 }
 
@@ -246,7 +266,8 @@ static AST_NODE_T* build_unless_node(control_builder_context_T* context) {
     context->end_node,
     context->start_position,
     context->end_position,
-    context->errors
+    context->errors,
+    context->allocator
   );
 }
 
@@ -259,7 +280,8 @@ static AST_NODE_T* build_while_node(control_builder_context_T* context) {
     context->end_node,
     context->start_position,
     context->end_position,
-    context->errors
+    context->errors,
+    context->allocator
   );
 }
 
@@ -272,7 +294,8 @@ static AST_NODE_T* build_until_node(control_builder_context_T* context) {
     context->end_node,
     context->start_position,
     context->end_position,
-    context->errors
+    context->errors,
+    context->allocator
   );
 }
 
@@ -285,7 +308,8 @@ static AST_NODE_T* build_for_node(control_builder_context_T* context) {
     context->end_node,
     context->start_position,
     context->end_position,
-    context->errors
+    context->errors,
+    context->allocator
   );
 }
 
@@ -298,7 +322,8 @@ static AST_NODE_T* build_block_node(control_builder_context_T* context) {
     context->end_node,
     context->start_position,
     context->end_position,
-    context->errors
+    context->errors,
+    context->allocator
   );
 }
 
@@ -309,6 +334,7 @@ static AST_NODE_T* build_yield_node(control_builder_context_T* context) {
     context->tag_closing,
     context->start_position,
     context->end_position,
-    context->errors
+    context->errors,
+    context->allocator
   );
 }
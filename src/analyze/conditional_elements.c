@@ -8,7 +8,6 @@
 #include "../include/util/hb_buffer.h"
 #include "../include/util/hb_string.h"
 #include "../include/util/string.h"
-#include "../include/visitor.h"
 
 #include <stdbool.h>
 #include <stdlib.h>
@@ -31,23 +30,30 @@ static const char* extract_condition_from_erb_content(AST_NODE_T* erb_node, bool
     return NULL;
   }
 
-  if (!content_token || !content_token->value) { return NULL; }
+  if (!content_token) { return NULL; }
 
-  const char* content = content_token->value;
+  const char* content = content_token->value.data;
+  const char* content_end = content + content_token->value.length;
 
-  content = skip_whitespace(content);
+  while (content < content_end && is_whitespace(*content)) {
+    content++;
+  }
+
+  size_t remaining = (size_t) (content_end - content);
 
   if (*is_if) {
-    if (strncmp(content, "if", 2) == 0 && is_whitespace(content[2])) { content += 3; }
+    if (remaining > 2 && strncmp(content, "if", 2) == 0 && is_whitespace(content[2])) { content += 3; }
   } else {
-    if (strncmp(content, "unless", 6) == 0 && is_whitespace(content[6])) { content += 7; }
+    if (remaining > 6 && strncmp(content, "unless", 6) == 0 && is_whitespace(content[6])) { content += 7; }
   }
 
-  content = skip_whitespace(content);
+  while (content < content_end && is_whitespace(*content)) {
+    content++;
+  }
 
-  if (strlen(content) == 0) { return NULL; }
+  size_t length = (size_t) (content_end - content);
 
-  size_t length = strlen(content);
+  if (length == 0) { return NULL; }
 
   while (length > 0 && is_whitespace(content[length - 1])) {
     length--;
@@ -208,12 +214,12 @@ typedef struct {
   size_t open_index;
   AST_NODE_T* open_conditional;
   AST_HTML_OPEN_TAG_NODE_T* open_tag;
-  const char* tag_name;
+  hb_string_T tag_name;
   const char* condition;
   bool is_if;
 } conditional_open_tag_T;
 
-static void rewrite_conditional_elements(hb_array_T* nodes, hb_array_T* document_errors) {
+void herb_transform_conditional_elements_in_array(hb_array_T* nodes, hb_array_T* document_errors) {
   if (!nodes || hb_array_size(nodes) == 0) { return; }
   if (!document_errors) { return; }
 
@@ -262,7 +268,8 @@ static void rewrite_conditional_elements(hb_array_T* nodes, hb_array_T* document
           open_node->location.start.line,
           open_node->location.start.column,
           open_node->location.start,
-          open_node->location.end
+          open_node->location.end,
+          document_errors->allocator
         );
 
         hb_array_append(document_errors, multiple_tags_error);
@@ -331,7 +338,7 @@ static void rewrite_conditional_elements(hb_array_T* nodes, hb_array_T* document
       conditional_open_tag_T* entry = (conditional_open_tag_T*) hb_array_get(open_stack, stack_index - 1);
 
       if (!entry) { continue; }
-      if (!hb_string_equals_case_insensitive(hb_string(entry->tag_name), hb_string(close_tag->tag_name->value))) {
+      if (!hb_string_equals_case_insensitive(entry->tag_name, close_tag->tag_name->value)) {
         continue;
       }
 
@@ -372,9 +379,11 @@ static void rewrite_conditional_elements(hb_array_T* nodes, hb_array_T* document
     }
 
     if (!matched_open && mismatched_open && mismatched_close_condition) {
+      char* mismatched_tag_name = hb_string_to_c_string_using_malloc(mismatched_open->tag_name);
+
       CONDITIONAL_ELEMENT_CONDITION_MISMATCH_ERROR_T* mismatch_error =
         conditional_element_condition_mismatch_error_init(
-          mismatched_open->tag_name,
+          mismatched_tag_name,
           mismatched_open->condition,
           mismatched_open->open_conditional->location.start.line,
           mismatched_open->open_conditional->location.start.column,
@@ -382,10 +391,12 @@ static void rewrite_conditional_elements(hb_array_T* nodes, hb_array_T* document
           node->location.start.line,
           node->location.start.column,
           mismatched_open->open_conditional->location.start,
-          node->location.end
+          node->location.end,
+          document_errors->allocator
         );
 
       hb_array_append(document_errors, mismatch_error);
+      free(mismatched_tag_name);
       free((void*) mismatched_close_condition);
       continue;
     }
@@ -394,7 +405,7 @@ static void rewrite_conditional_elements(hb_array_T* nodes, hb_array_T* document
 
     if (!matched_open) { continue; }
 
-    hb_array_T* body = hb_array_init(8);
+    hb_array_T* body = hb_array_init_arena(nodes->allocator, 8);
 
     for (size_t body_index = matched_open->open_index + 1; body_index < node_index; body_index++) {
       AST_NODE_T* body_node = (AST_NODE_T*) hb_array_get(nodes, body_index);
@@ -404,7 +415,7 @@ static void rewrite_conditional_elements(hb_array_T* nodes, hb_array_T* document
 
     position_T start_position = matched_open->open_conditional->location.start;
     position_T end_position = node->location.end;
-    hb_array_T* errors = hb_array_init(8);
+    hb_array_T* errors = hb_array_init_arena(nodes->allocator, 8);
     char* condition_copy = hb_string_to_c_string_using_malloc(hb_string(matched_open->condition));
 
     AST_HTML_CONDITIONAL_ELEMENT_NODE_T* conditional_element = ast_html_conditional_element_node_init(
@@ -418,7 +429,8 @@ static void rewrite_conditional_elements(hb_array_T* nodes, hb_array_T* document
       ELEMENT_SOURCE_HTML,
       start_position,
       end_position,
-      errors
+      errors,
+      nodes->allocator
     );
 
     free(condition_copy);
@@ -500,151 +512,3 @@ static void rewrite_conditional_elements(hb_array_T* nodes, hb_array_T* document
 
   hb_array_free(&consumed_indices);
 }
-
-static bool transform_conditional_elements_visitor(const AST_NODE_T* node, void* data);
-
-static void transform_conditional_elements_in_array(hb_array_T* array, hb_array_T* document_errors) {
-  if (!array) { return; }
-
-  for (size_t i = 0; i < hb_array_size(array); i++) {
-    AST_NODE_T* child = (AST_NODE_T*) hb_array_get(array, i);
-
-    if (child) { herb_visit_node(child, transform_conditional_elements_visitor, document_errors); }
-  }
-
-  rewrite_conditional_elements(array, document_errors);
-}
-
-static bool transform_conditional_elements_visitor(const AST_NODE_T* node, void* data) {
-  if (!node) { return false; }
-
-  hb_array_T* document_errors = (hb_array_T*) data;
-
-  switch (node->type) {
-    case AST_DOCUMENT_NODE: {
-      AST_DOCUMENT_NODE_T* doc = (AST_DOCUMENT_NODE_T*) node;
-      transform_conditional_elements_in_array(doc->children, document_errors);
-      return false;
-    }
-
-    case AST_HTML_ELEMENT_NODE: {
-      AST_HTML_ELEMENT_NODE_T* element = (AST_HTML_ELEMENT_NODE_T*) node;
-      transform_conditional_elements_in_array(element->body, document_errors);
-      return false;
-    }
-
-    case AST_ERB_IF_NODE: {
-      AST_ERB_IF_NODE_T* if_node = (AST_ERB_IF_NODE_T*) node;
-      transform_conditional_elements_in_array(if_node->statements, document_errors);
-
-      if (if_node->subsequent) { herb_visit_node(if_node->subsequent, transform_conditional_elements_visitor, data); }
-
-      return false;
-    }
-
-    case AST_ERB_ELSE_NODE: {
-      AST_ERB_ELSE_NODE_T* else_node = (AST_ERB_ELSE_NODE_T*) node;
-      transform_conditional_elements_in_array(else_node->statements, document_errors);
-      return false;
-    }
-
-    case AST_ERB_UNLESS_NODE: {
-      AST_ERB_UNLESS_NODE_T* unless_node = (AST_ERB_UNLESS_NODE_T*) node;
-      transform_conditional_elements_in_array(unless_node->statements, document_errors);
-
-      if (unless_node->else_clause) {
-        herb_visit_node((AST_NODE_T*) unless_node->else_clause, transform_conditional_elements_visitor, data);
-      }
-
-      return false;
-    }
-
-    case AST_ERB_BLOCK_NODE: {
-      AST_ERB_BLOCK_NODE_T* block_node = (AST_ERB_BLOCK_NODE_T*) node;
-      transform_conditional_elements_in_array(block_node->body, document_errors);
-      return false;
-    }
-
-    case AST_ERB_WHILE_NODE: {
-      AST_ERB_WHILE_NODE_T* while_node = (AST_ERB_WHILE_NODE_T*) node;
-      transform_conditional_elements_in_array(while_node->statements, document_errors);
-      return false;
-    }
-
-    case AST_ERB_UNTIL_NODE: {
-      AST_ERB_UNTIL_NODE_T* until_node = (AST_ERB_UNTIL_NODE_T*) node;
-      transform_conditional_elements_in_array(until_node->statements, document_errors);
-      return false;
-    }
-
-    case AST_ERB_FOR_NODE: {
-      AST_ERB_FOR_NODE_T* for_node = (AST_ERB_FOR_NODE_T*) node;
-      transform_conditional_elements_in_array(for_node->statements, document_errors);
-      return false;
-    }
-
-    case AST_ERB_CASE_NODE: {
-      AST_ERB_CASE_NODE_T* case_node = (AST_ERB_CASE_NODE_T*) node;
-      transform_conditional_elements_in_array(case_node->children, document_errors);
-
-      for (size_t i = 0; i < hb_array_size(case_node->conditions); i++) {
-        AST_NODE_T* when = (AST_NODE_T*) hb_array_get(case_node->conditions, i);
-        if (when) { herb_visit_node(when, transform_conditional_elements_visitor, data); }
-      }
-
-      if (case_node->else_clause) {
-        herb_visit_node((AST_NODE_T*) case_node->else_clause, transform_conditional_elements_visitor, data);
-      }
-
-      return false;
-    }
-
-    case AST_ERB_WHEN_NODE: {
-      AST_ERB_WHEN_NODE_T* when_node = (AST_ERB_WHEN_NODE_T*) node;
-      transform_conditional_elements_in_array(when_node->statements, document_errors);
-      return false;
-    }
-
-    case AST_ERB_BEGIN_NODE: {
-      AST_ERB_BEGIN_NODE_T* begin_node = (AST_ERB_BEGIN_NODE_T*) node;
-      transform_conditional_elements_in_array(begin_node->statements, document_errors);
-
-      if (begin_node->rescue_clause) {
-        herb_visit_node((AST_NODE_T*) begin_node->rescue_clause, transform_conditional_elements_visitor, data);
-      }
-
-      if (begin_node->else_clause) {
-        herb_visit_node((AST_NODE_T*) begin_node->else_clause, transform_conditional_elements_visitor, data);
-      }
-
-      if (begin_node->ensure_clause) {
-        herb_visit_node((AST_NODE_T*) begin_node->ensure_clause, transform_conditional_elements_visitor, data);
-      }
-
-      return false;
-    }
-
-    case AST_ERB_RESCUE_NODE: {
-      AST_ERB_RESCUE_NODE_T* rescue_node = (AST_ERB_RESCUE_NODE_T*) node;
-      transform_conditional_elements_in_array(rescue_node->statements, document_errors);
-
-      if (rescue_node->subsequent) {
-        herb_visit_node((AST_NODE_T*) rescue_node->subsequent, transform_conditional_elements_visitor, data);
-      }
-
-      return false;
-    }
-
-    case AST_ERB_ENSURE_NODE: {
-      AST_ERB_ENSURE_NODE_T* ensure_node = (AST_ERB_ENSURE_NODE_T*) node;
-      transform_conditional_elements_in_array(ensure_node->statements, document_errors);
-      return false;
-    }
-
-    default: return true;
-  }
-}
-
-void herb_transform_conditional_elements(AST_DOCUMENT_NODE_T* document) {
-  herb_visit_node((AST_NODE_T*) document, transform_conditional_elements_visitor, document->base.errors);
-}
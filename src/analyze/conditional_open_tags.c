@@ -6,15 +6,11 @@
 #include "../include/util.h"
 #include "../include/util/hb_array.h"
 #include "../include/util/hb_string.h"
-#include "../include/visitor.h"
 
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
-static bool transform_conditional_open_tags_visitor(const AST_NODE_T* node, void* data);
-static void transform_conditional_open_tags_in_array(hb_array_T* array, hb_array_T* document_errors);
-
 static bool is_non_void_open_tag(AST_NODE_T* node) {
   if (!node || node->type != AST_HTML_OPEN_TAG_NODE) { return false; }
 
@@ -23,10 +19,10 @@ static bool is_non_void_open_tag(AST_NODE_T* node) {
   return !open_tag->is_void;
 }
 
-static const char* get_open_tag_name(AST_HTML_OPEN_TAG_NODE_T* open_tag) {
-  if (!open_tag || !open_tag->tag_name) { return NULL; }
+static const token_T* get_open_tag_name(AST_HTML_OPEN_TAG_NODE_T* open_tag) {
+  if (!open_tag) { return NULL; }
 
-  return open_tag->tag_name->value;
+  return open_tag->tag_name;
 }
 
 typedef struct {
@@ -35,7 +31,11 @@ typedef struct {
   bool has_multiple_tags;
 } single_open_tag_result_T;
 
-static bool has_matching_close_tag_in_statements(hb_array_T* statements, size_t open_tag_index, const char* tag_name) {
+static bool has_matching_close_tag_in_statements(
+  hb_array_T* statements,
+  size_t open_tag_index,
+  const token_T* tag_name
+) {
   if (!statements || !tag_name) { return false; }
 
   int depth = 0;
@@ -48,14 +48,14 @@ static bool has_matching_close_tag_in_statements(hb_array_T* statements, size_t
     if (node->type == AST_HTML_OPEN_TAG_NODE) {
       AST_HTML_OPEN_TAG_NODE_T* open_tag = (AST_HTML_OPEN_TAG_NODE_T*) node;
 
-      if (open_tag->tag_name && open_tag->tag_name->value) {
-        if (hb_string_equals_case_insensitive(hb_string(tag_name), hb_string(open_tag->tag_name->value))) { depth++; }
+      if (open_tag->tag_name) {
+        if (hb_string_equals_case_insensitive(tag_name->value, open_tag->tag_name->value)) { depth++; }
       }
     } else if (node->type == AST_HTML_CLOSE_TAG_NODE) {
       AST_HTML_CLOSE_TAG_NODE_T* close_tag = (AST_HTML_CLOSE_TAG_NODE_T*) node;
 
-      if (close_tag->tag_name && close_tag->tag_name->value) {
-        if (hb_string_equals_case_insensitive(hb_string(tag_name), hb_string(close_tag->tag_name->value))) {
+      if (close_tag->tag_name) {
+        if (hb_string_equals_case_insensitive(tag_name->value, close_tag->tag_name->value)) {
           if (depth == 0) { return true; }
           depth--;
         }
@@ -95,7 +95,7 @@ static single_open_tag_result_T get_single_open_tag_from_statements(hb_array_T*
       if (whitespace_only) { continue; }
 
       if (result.tag) {
-        const char* tag_name = get_open_tag_name(result.tag);
+        const token_T* tag_name = get_open_tag_name(result.tag);
 
         if (tag_name && has_matching_close_tag_in_statements(statements, first_tag_index, tag_name)) {
           result.tag = NULL;
@@ -125,7 +125,7 @@ static single_open_tag_result_T get_single_open_tag_from_statements(hb_array_T*
     result.tag = NULL;
 
     if (result.has_multiple_tags && result.second_tag) {
-      const char* first_tag_name =
+      const token_T* first_tag_name =
         get_open_tag_name((AST_HTML_OPEN_TAG_NODE_T*) hb_array_get(statements, first_tag_index));
       bool first_has_close =
         first_tag_name && has_matching_close_tag_in_statements(statements, first_tag_index, first_tag_name);
@@ -138,7 +138,7 @@ static single_open_tag_result_T get_single_open_tag_from_statements(hb_array_T*
   }
 
   if (result.tag) {
-    const char* tag_name = get_open_tag_name(result.tag);
+    const token_T* tag_name = get_open_tag_name(result.tag);
 
     if (tag_name && has_matching_close_tag_in_statements(statements, first_tag_index, tag_name)) { result.tag = NULL; }
   }
@@ -146,7 +146,7 @@ static single_open_tag_result_T get_single_open_tag_from_statements(hb_array_T*
   return result;
 }
 
-static const char* check_erb_if_conditional_open_tag(AST_ERB_IF_NODE_T* if_node) {
+static const token_T* check_erb_if_conditional_open_tag(AST_ERB_IF_NODE_T* if_node) {
   if (!if_node) { return NULL; }
 
   if (!if_node->subsequent) { return NULL; }
@@ -154,7 +154,7 @@ static const char* check_erb_if_conditional_open_tag(AST_ERB_IF_NODE_T* if_node)
   single_open_tag_result_T if_result = get_single_open_tag_from_statements(if_node->statements);
   if (!if_result.tag) { return NULL; }
 
-  const char* common_tag_name = get_open_tag_name(if_result.tag);
+  const token_T* common_tag_name = get_open_tag_name(if_result.tag);
   if (!common_tag_name) { return NULL; }
 
   AST_NODE_T* current = if_node->subsequent;
@@ -180,10 +180,10 @@ static const char* check_erb_if_conditional_open_tag(AST_ERB_IF_NODE_T* if_node)
     single_open_tag_result_T branch_result = get_single_open_tag_from_statements(branch_statements);
     if (!branch_result.tag) { return NULL; }
 
-    const char* branch_tag_name = get_open_tag_name(branch_result.tag);
+    const token_T* branch_tag_name = get_open_tag_name(branch_result.tag);
     if (!branch_tag_name) { return NULL; }
 
-    if (!hb_string_equals_case_insensitive(hb_string(common_tag_name), hb_string(branch_tag_name))) { return NULL; }
+    if (!hb_string_equals_case_insensitive(common_tag_name->value, branch_tag_name->value)) { return NULL; }
 
     current = next_subsequent;
   }
@@ -193,23 +193,23 @@ static const char* check_erb_if_conditional_open_tag(AST_ERB_IF_NODE_T* if_node)
   return common_tag_name;
 }
 
-static const char* check_erb_unless_conditional_open_tag(AST_ERB_UNLESS_NODE_T* unless_node) {
+static const token_T* check_erb_unless_conditional_open_tag(AST_ERB_UNLESS_NODE_T* unless_node) {
   if (!unless_node) { return NULL; }
   if (!unless_node->else_clause) { return NULL; }
 
   single_open_tag_result_T unless_result = get_single_open_tag_from_statements(unless_node->statements);
   if (!unless_result.tag) { return NULL; }
 
-  const char* common_tag_name = get_open_tag_name(unless_result.tag);
+  const token_T* common_tag_name = get_open_tag_name(unless_result.tag);
   if (!common_tag_name) { return NULL; }
 
   single_open_tag_result_T else_result = get_single_open_tag_from_statements(unless_node->else_clause->statements);
   if (!else_result.tag) { return NULL; }
 
-  const char* else_tag_name = get_open_tag_name(else_result.tag);
+  const token_T* else_tag_name = get_open_tag_name(else_result.tag);
   if (!else_tag_name) { return NULL; }
 
-  if (!hb_string_equals_case_insensitive(hb_string(common_tag_name), hb_string(else_tag_name))) { return NULL; }
+  if (!hb_string_equals_case_insensitive(common_tag_name->value, else_tag_name->value)) { return NULL; }
 
   return common_tag_name;
 }
@@ -217,7 +217,7 @@ static const char* check_erb_unless_conditional_open_tag(AST_ERB_UNLESS_NODE_T*
 static size_t find_matching_close_tag(
   hb_array_T* siblings,
   size_t start_index,
-  const char* tag_name,
+  const token_T* tag_name,
   AST_HTML_CLOSE_TAG_NODE_T** out_close_tag
 ) {
   *out_close_tag = NULL;
@@ -229,8 +229,8 @@ static size_t find_matching_close_tag(
     if (node->type == AST_HTML_CLOSE_TAG_NODE) {
       AST_HTML_CLOSE_TAG_NODE_T* close_tag = (AST_HTML_CLOSE_TAG_NODE_T*) node;
 
-      if (close_tag->tag_name && close_tag->tag_name->value) {
-        if (hb_string_equals_case_insensitive(hb_string(tag_name), hb_string(close_tag->tag_name->value))) {
+      if (close_tag->tag_name) {
+        if (hb_string_equals_case_insensitive(tag_name->value, close_tag->tag_name->value)) {
           *out_close_tag = close_tag;
           return i;
         }
@@ -260,10 +260,11 @@ static void add_multiple_tags_error_to_erb_node(AST_NODE_T* erb_node, AST_HTML_O
     second_tag->base.location.start.line,
     second_tag->base.location.start.column,
     erb_node->location.start,
-    erb_node->location.end
+    erb_node->location.end,
+    erb_node->allocator
   );
 
-  if (!erb_node->errors) { erb_node->errors = hb_array_init(1); }
+  if (!erb_node->errors) { erb_node->errors = hb_array_init_arena(erb_node->allocator, 1); }
 
   hb_array_append(erb_node->errors, error);
 }
@@ -344,7 +345,7 @@ static void rewrite_conditional_open_tags(hb_array_T* nodes, hb_array_T* documen
     AST_NODE_T* node = (AST_NODE_T*) hb_array_get(nodes, i);
     if (!node) { continue; }
 
-    const char* tag_name = NULL;
+    const token_T* tag_name = NULL;
     AST_NODE_T* conditional_node = NULL;
     token_T* tag_name_token = NULL;
 
@@ -377,7 +378,7 @@ static void rewrite_conditional_open_tags(hb_array_T* nodes, hb_array_T* documen
 
     if (close_index == (size_t) -1 || !close_tag) { continue; }
 
-    hb_array_T* body = hb_array_init(8);
+    hb_array_T* body = hb_array_init_arena(nodes->allocator, 8);
 
     for (size_t j = i + 1; j < close_index; j++) {
       AST_NODE_T* body_node = (AST_NODE_T*) hb_array_get(nodes, j);
@@ -387,7 +388,7 @@ static void rewrite_conditional_open_tags(hb_array_T* nodes, hb_array_T* documen
     position_T start_position = conditional_node->location.start;
     position_T end_position = close_tag->base.location.end;
 
-    hb_array_T* conditional_open_tag_errors = hb_array_init(1);
+    hb_array_T* conditional_open_tag_errors = hb_array_init_arena(nodes->allocator, 1);
 
     AST_HTML_CONDITIONAL_OPEN_TAG_NODE_T* conditional_open_tag = ast_html_conditional_open_tag_node_init(
       conditional_node,
@@ -395,10 +396,11 @@ static void rewrite_conditional_open_tags(hb_array_T* nodes, hb_array_T* documen
       false,
       conditional_node->location.start,
       conditional_node->location.end,
-      conditional_open_tag_errors
+      conditional_open_tag_errors,
+      nodes->allocator
     );
 
-    hb_array_T* element_errors = hb_array_init(1);
+    hb_array_T* element_errors = hb_array_init_arena(nodes->allocator, 1);
 
     AST_HTML_ELEMENT_NODE_T* element = ast_html_element_node_init(
       (AST_NODE_T*) conditional_open_tag,
@@ -409,7 +411,8 @@ static void rewrite_conditional_open_tags(hb_array_T* nodes, hb_array_T* documen
       ELEMENT_SOURCE_HTML,
       start_position,
       end_position,
-      element_errors
+      element_errors,
+      nodes->allocator
     );
 
     hb_array_set(nodes, i, element);
@@ -462,174 +465,40 @@ static void rewrite_conditional_open_tags(hb_array_T* nodes, hb_array_T* documen
   hb_array_free(&consumed_indices);
 }
 
-static void transform_conditional_open_tags_in_array(hb_array_T* array, hb_array_T* document_errors) {
+void herb_transform_conditional_open_tags_in_branches(hb_array_T* array, hb_array_T* document_errors) {
   if (!array) { return; }
 
   for (size_t i = 0; i < hb_array_size(array); i++) {
     AST_NODE_T* child = (AST_NODE_T*) hb_array_get(array, i);
-    if (child) { herb_visit_node(child, transform_conditional_open_tags_visitor, document_errors); }
-  }
-
-  rewrite_conditional_open_tags(array, document_errors);
-}
-
-static bool transform_conditional_open_tags_visitor(const AST_NODE_T* node, void* data) {
-  if (!node) { return false; }
-
-  hb_array_T* document_errors = (hb_array_T*) data;
-
-  switch (node->type) {
-    case AST_DOCUMENT_NODE: {
-      AST_DOCUMENT_NODE_T* doc = (AST_DOCUMENT_NODE_T*) node;
-      transform_conditional_open_tags_in_array(doc->children, document_errors);
-      return false;
-    }
-
-    case AST_HTML_ELEMENT_NODE: {
-      AST_HTML_ELEMENT_NODE_T* element = (AST_HTML_ELEMENT_NODE_T*) node;
-      transform_conditional_open_tags_in_array(element->body, document_errors);
-      return false;
-    }
-
-    case AST_HTML_CONDITIONAL_ELEMENT_NODE: {
-      AST_HTML_CONDITIONAL_ELEMENT_NODE_T* conditional = (AST_HTML_CONDITIONAL_ELEMENT_NODE_T*) node;
-      transform_conditional_open_tags_in_array(conditional->body, document_errors);
-      return false;
-    }
-
-    case AST_ERB_IF_NODE: {
-      AST_ERB_IF_NODE_T* if_node = (AST_ERB_IF_NODE_T*) node;
-      transform_conditional_open_tags_in_array(if_node->statements, document_errors);
-
-      if (if_node->subsequent) { herb_visit_node(if_node->subsequent, transform_conditional_open_tags_visitor, data); }
-
-      return false;
-    }
-
-    case AST_ERB_ELSE_NODE: {
-      AST_ERB_ELSE_NODE_T* else_node = (AST_ERB_ELSE_NODE_T*) node;
-      transform_conditional_open_tags_in_array(else_node->statements, document_errors);
-      return false;
-    }
-
-    case AST_ERB_UNLESS_NODE: {
-      AST_ERB_UNLESS_NODE_T* unless_node = (AST_ERB_UNLESS_NODE_T*) node;
-      transform_conditional_open_tags_in_array(unless_node->statements, document_errors);
-
-      if (unless_node->else_clause) {
-        herb_visit_node((AST_NODE_T*) unless_node->else_clause, transform_conditional_open_tags_visitor, data);
-      }
-      return false;
-    }
-
-    case AST_ERB_BLOCK_NODE: {
-      AST_ERB_BLOCK_NODE_T* block_node = (AST_ERB_BLOCK_NODE_T*) node;
-      transform_conditional_open_tags_in_array(block_node->body, document_errors);
-      return false;
-    }
-
-    case AST_ERB_WHILE_NODE: {
-      AST_ERB_WHILE_NODE_T* while_node = (AST_ERB_WHILE_NODE_T*) node;
-      transform_conditional_open_tags_in_array(while_node->statements, document_errors);
-      return false;
-    }
-
-    case AST_ERB_UNTIL_NODE: {
-      AST_ERB_UNTIL_NODE_T* until_node = (AST_ERB_UNTIL_NODE_T*) node;
-      transform_conditional_open_tags_in_array(until_node->statements, document_errors);
-      return false;
-    }
-
-    case AST_ERB_FOR_NODE: {
-      AST_ERB_FOR_NODE_T* for_node = (AST_ERB_FOR_NODE_T*) node;
-      transform_conditional_open_tags_in_array(for_node->statements, document_errors);
-      return false;
-    }
-
-    case AST_ERB_CASE_NODE: {
-      AST_ERB_CASE_NODE_T* case_node = (AST_ERB_CASE_NODE_T*) node;
-      transform_conditional_open_tags_in_array(case_node->children, document_errors);
-
-      for (size_t i = 0; i < hb_array_size(case_node->conditions); i++) {
-        AST_NODE_T* when_node = (AST_NODE_T*) hb_array_get(case_node->conditions, i);
-        if (when_node) { herb_visit_node(when_node, transform_conditional_open_tags_visitor, data); }
-      }
-
-      if (case_node->else_clause) {
-        herb_visit_node((AST_NODE_T*) case_node->else_clause, transform_conditional_open_tags_visitor, data);
-      }
-
-      return false;
-    }
-
-    case AST_ERB_CASE_MATCH_NODE: {
-      AST_ERB_CASE_MATCH_NODE_T* case_match_node = (AST_ERB_CASE_MATCH_NODE_T*) node;
-      transform_conditional_open_tags_in_array(case_match_node->children, document_errors);
-
-      for (size_t i = 0; i < hb_array_size(case_match_node->conditions); i++) {
-        AST_NODE_T* in_node = (AST_NODE_T*) hb_array_get(case_match_node->conditions, i);
-        if (in_node) { herb_visit_node(in_node, transform_conditional_open_tags_visitor, data); }
-      }
-
-      if (case_match_node->else_clause) {
-        herb_visit_node((AST_NODE_T*) case_match_node->else_clause, transform_conditional_open_tags_visitor, data);
-      }
-
-      return false;
-    }
-
-    case AST_ERB_WHEN_NODE: {
-      AST_ERB_WHEN_NODE_T* when_node = (AST_ERB_WHEN_NODE_T*) node;
-      transform_conditional_open_tags_in_array(when_node->statements, document_errors);
-      return false;
-    }
-
-    case AST_ERB_IN_NODE: {
-      AST_ERB_IN_NODE_T* in_node = (AST_ERB_IN_NODE_T*) node;
-      transform_conditional_open_tags_in_array(in_node->statements, document_errors);
-      return false;
-    }
-
-    case AST_ERB_BEGIN_NODE: {
-      AST_ERB_BEGIN_NODE_T* begin_node = (AST_ERB_BEGIN_NODE_T*) node;
-      transform_conditional_open_tags_in_array(begin_node->statements, document_errors);
-
-      if (begin_node->rescue_clause) {
-        herb_visit_node((AST_NODE_T*) begin_node->rescue_clause, transform_conditional_open_tags_visitor, data);
-      }
-
-      if (begin_node->else_clause) {
-        herb_visit_node((AST_NODE_T*) begin_node->else_clause, transform_conditional_open_tags_visitor, data);
-      }
-
-      if (begin_node->ensure_clause) {
-        herb_visit_node((AST_NODE_T*) begin_node->ensure_clause, transform_conditional_open_tags_visitor, data);
-      }
-
-      return false;
-    }
-
-    case AST_ERB_RESCUE_NODE: {
-      AST_ERB_RESCUE_NODE_T* rescue_node = (AST_ERB_RESCUE_NODE_T*) node;
-      transform_conditional_open_tags_in_array(rescue_node->statements, document_errors);
-
-      if (rescue_node->subsequent) {
-        herb_visit_node((AST_NODE_T*) rescue_node->subsequent, transform_conditional_open_tags_visitor, data);
-      }
+    if (!child) { continue; }
+
+    switch (child->type) {
+      // Conditional elements built from this array are new, so the walk hasn't been through their bodies yet.
+      case AST_HTML_CONDITIONAL_ELEMENT_NODE: {
+        AST_HTML_CONDITIONAL_ELEMENT_NODE_T* conditional = (AST_HTML_CONDITIONAL_ELEMENT_NODE_T*) child;
+        herb_transform_conditional_open_tags_in_array(conditional->body, document_errors);
+      } break;
+
+      case AST_ERB_IF_NODE: {
+        for (AST_NODE_T* branch = child; branch && branch->type == AST_ERB_IF_NODE;
+             branch = ((AST_ERB_IF_NODE_T*) branch)->subsequent) {
+          herb_transform_conditional_open_tags_in_array(((AST_ERB_IF_NODE_T*) branch)->statements, document_errors);
+        }
+      } break;
 
-      return false;
-    }
+      case AST_ERB_UNLESS_NODE: {
+        AST_ERB_UNLESS_NODE_T* unless_node = (AST_ERB_UNLESS_NODE_T*) child;
+        herb_transform_conditional_open_tags_in_array(unless_node->statements, document_errors);
+      } break;
 
-    case AST_ERB_ENSURE_NODE: {
-      AST_ERB_ENSURE_NODE_T* ensure_node = (AST_ERB_ENSURE_NODE_T*) node;
-      transform_conditional_open_tags_in_array(ensure_node->statements, document_errors);
-      return false;
+      default: break;
     }
-
-    default: return true;
   }
 }
 
-void herb_transform_conditional_open_tags(AST_DOCUMENT_NODE_T* document) {
-  herb_visit_node((AST_NODE_T*) document, transform_conditional_open_tags_visitor, document->base.errors);
+void herb_transform_conditional_open_tags_in_array(hb_array_T* array, hb_array_T* document_errors) {
+  if (!array) { return; }
+
+  herb_transform_conditional_open_tags_in_branches(array, document_errors);
+  rewrite_conditional_open_tags(array, document_errors);
 }
@@ -169,7 +169,7 @@ static bool find_earliest_control_keyword_walker(const pm_node_t* node, void* da
   return true;
 }
 
-static control_type_t find_earliest_control_keyword(pm_node_t* root, const uint8_t* source_start) {
+control_type_t find_earliest_control_keyword(const pm_node_t* root, const uint8_t* source_start) {
   if (!root) { return CONTROL_TYPE_UNKNOWN; }
 
   earliest_control_keyword_T result = { .type = CONTROL_TYPE_UNKNOWN, .offset = UINT32_MAX, .found = false };
@@ -190,8 +190,6 @@ control_type_t detect_control_type(AST_ERB_CONTENT_NODE_T* erb_node) {
   if (!ruby) { return CONTROL_TYPE_UNKNOWN; }
   if (ruby->valid) { return CONTROL_TYPE_UNKNOWN; }
 
-  pm_node_t* root = ruby->root;
-
   if (has_elsif_node(ruby)) { return CONTROL_TYPE_ELSIF; }
   if (has_else_node(ruby)) { return CONTROL_TYPE_ELSE; }
   if (has_end(ruby)) { return CONTROL_TYPE_END; }
@@ -203,7 +201,7 @@ control_type_t detect_control_type(AST_ERB_CONTENT_NODE_T* erb_node) {
 
   if (ruby->unclosed_control_flow_count == 0 && !has_yield_node(ruby)) { return CONTROL_TYPE_UNKNOWN; }
 
-  return find_earliest_control_keyword(root, ruby->parser.start);
+  return ruby->earliest_control_type;
 }
 
 bool is_subsequent_type(control_type_t parent_type, control_type_t child_type) {
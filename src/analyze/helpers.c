@@ -1,8 +1,10 @@
 #include <prism.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "../include/analyze/analyzed_ruby.h"
+#include "../include/analyze/helpers.h"
 #include "../include/util/string.h"
 
 bool has_if_node(analyzed_ruby_T* analyzed) {
@@ -86,32 +88,6 @@ bool has_inline_case_condition(analyzed_ruby_T* analyzed) {
       || (has_case_match_node(analyzed) && has_in_node(analyzed));
 }
 
-bool has_error_message(analyzed_ruby_T* analyzed, const char* message) {
-  for (const pm_diagnostic_t* error = (const pm_diagnostic_t*) analyzed->parser.error_list.head; error != NULL;
-       error = (const pm_diagnostic_t*) error->node.next) {
-    if (string_equals(error->message, message)) { return true; }
-  }
-
-  return false;
-}
-
-bool search_if_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_IF_NODE) {
-    const pm_if_node_t* if_node = (const pm_if_node_t*) node;
-
-    bool has_if_keyword = if_node->if_keyword_loc.start != NULL && if_node->if_keyword_loc.end != NULL;
-    bool has_end_keyword = if_node->end_keyword_loc.start != NULL && if_node->end_keyword_loc.end != NULL;
-
-    if (has_if_keyword && has_end_keyword) { analyzed->if_node_count++; }
-  }
-
-  pm_visit_child_nodes(node, search_if_nodes, analyzed);
-
-  return false;
-}
-
 bool is_do_block(pm_location_t opening_location) {
   size_t length = opening_location.end - opening_location.start;
 
@@ -154,273 +130,119 @@ bool has_valid_block_closing(pm_location_t opening_loc, pm_location_t closing_lo
   return false;
 }
 
-bool search_block_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_BLOCK_NODE) {
-    pm_block_node_t* block_node = (pm_block_node_t*) node;
-
-    bool has_opening = is_do_block(block_node->opening_loc) || is_brace_block(block_node->opening_loc);
-    bool is_unclosed = !has_valid_block_closing(block_node->opening_loc, block_node->closing_loc);
-
-    if (has_opening && is_unclosed) { analyzed->block_node_count++; }
-  }
-
-  if (node->type == PM_LAMBDA_NODE) {
-    pm_lambda_node_t* lambda_node = (pm_lambda_node_t*) node;
-
-    bool has_opening = is_do_block(lambda_node->opening_loc) || is_brace_block(lambda_node->opening_loc);
-    bool is_unclosed = !has_valid_block_closing(lambda_node->opening_loc, lambda_node->closing_loc);
-
-    if (has_opening && is_unclosed) { analyzed->block_node_count++; }
-  }
-
-  pm_visit_child_nodes(node, search_block_nodes, analyzed);
-
-  return false;
+static bool has_keyword(pm_location_t location) {
+  return location.start != NULL && location.end != NULL;
 }
 
-bool search_case_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_CASE_NODE) { analyzed->case_node_count++; }
-
-  pm_visit_child_nodes(node, search_case_nodes, analyzed);
+static bool is_unclosed_block(pm_location_t opening_loc, pm_location_t closing_loc) {
+  bool has_opening = is_do_block(opening_loc) || is_brace_block(opening_loc);
 
-  return false;
-}
-
-bool search_case_match_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_CASE_MATCH_NODE) { analyzed->case_match_node_count++; }
-
-  pm_visit_child_nodes(node, search_case_match_nodes, analyzed);
-
-  return false;
+  return has_opening && !has_valid_block_closing(opening_loc, closing_loc);
 }
 
-bool search_while_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_WHILE_NODE) { analyzed->while_node_count++; }
-
-  pm_visit_child_nodes(node, search_while_nodes, analyzed);
-
-  return false;
-}
-
-bool search_for_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_FOR_NODE) { analyzed->for_node_count++; }
-
-  pm_visit_child_nodes(node, search_for_nodes, analyzed);
-
-  return false;
-}
-
-bool search_until_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_UNTIL_NODE) { analyzed->until_node_count++; }
-
-  pm_visit_child_nodes(node, search_until_nodes, analyzed);
-
-  return false;
-}
-
-bool search_begin_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_BEGIN_NODE) { analyzed->begin_node_count++; }
-
-  pm_visit_child_nodes(node, search_begin_nodes, analyzed);
-
-  return false;
-}
-
-bool search_unless_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_UNLESS_NODE) {
-    const pm_unless_node_t* unless_node = (const pm_unless_node_t*) node;
-
-    bool has_if_keyword = unless_node->keyword_loc.start != NULL && unless_node->keyword_loc.end != NULL;
-    bool has_end_keyword = unless_node->end_keyword_loc.start != NULL && unless_node->end_keyword_loc.end != NULL;
-
-    if (has_if_keyword && has_end_keyword) { analyzed->unless_node_count++; }
-  }
-
-  pm_visit_child_nodes(node, search_unless_nodes, analyzed);
-
-  return false;
-}
-
-bool search_when_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_WHEN_NODE) { analyzed->when_node_count++; }
-
-  pm_visit_child_nodes(node, search_when_nodes, analyzed);
-
-  return false;
-}
-
-bool search_in_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
-
-  if (node->type == PM_IN_NODE) { analyzed->in_node_count++; }
-  if (node->type == PM_MATCH_PREDICATE_NODE) { analyzed->in_node_count++; }
-
-  pm_visit_child_nodes(node, search_in_nodes, analyzed);
-
-  return false;
-}
-
-bool search_unexpected_elsif_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'elsif', ignoring it")) {
-    analyzed->elsif_node_count++;
-    return true;
-  }
+static bool is_postfix_conditional(const pm_statements_node_t* statements, pm_location_t keyword_location) {
+  if (statements == NULL) { return false; }
 
-  return false;
+  return statements->base.location.start < keyword_location.start;
 }
 
-bool search_unexpected_else_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'else', ignoring it")) {
-    analyzed->else_node_count++;
-    return true;
-  }
+static bool is_unclosed_control_flow(const pm_node_t* node) {
+  switch (node->type) {
+    case PM_IF_NODE: {
+      const pm_if_node_t* if_node = (const pm_if_node_t*) node;
 
-  return false;
-}
+      if (has_location(if_node->if_keyword_loc) && !is_end_keyword(if_node->end_keyword_loc)) {
+        return !is_postfix_conditional(if_node->statements, if_node->if_keyword_loc);
+      }
 
-bool search_unexpected_end_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'end', ignoring it")) {
-    if (has_error_message(analyzed, "unexpected '=', ignoring it")) {
-      // `=end`
       return false;
     }
 
-    analyzed->end_count++;
-    return true;
-  }
-
-  return false;
-}
+    case PM_UNLESS_NODE: {
+      const pm_unless_node_t* unless_node = (const pm_unless_node_t*) node;
 
-bool search_unexpected_block_closing_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected '}', ignoring it")) {
-    analyzed->block_closing_count++;
-    return true;
-  }
+      if (has_location(unless_node->keyword_loc) && !is_end_keyword(unless_node->end_keyword_loc)) {
+        return !is_postfix_conditional(unless_node->statements, unless_node->keyword_loc);
+      }
 
-  return false;
-}
+      return false;
+    }
 
-bool search_unexpected_when_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'when', ignoring it")) {
-    analyzed->when_node_count++;
-    return true;
-  }
+    case PM_CASE_NODE: {
+      const pm_case_node_t* case_node = (const pm_case_node_t*) node;
 
-  return false;
-}
+      return has_location(case_node->case_keyword_loc) && !is_end_keyword(case_node->end_keyword_loc);
+    }
 
-bool search_unexpected_in_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'in', ignoring it")) {
-    analyzed->in_node_count++;
-    return true;
-  }
+    case PM_CASE_MATCH_NODE: {
+      const pm_case_match_node_t* case_match_node = (const pm_case_match_node_t*) node;
 
-  return false;
-}
+      return has_location(case_match_node->case_keyword_loc) && !is_end_keyword(case_match_node->end_keyword_loc);
+    }
 
-bool search_unexpected_rescue_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'rescue', ignoring it")) {
-    analyzed->rescue_node_count++;
-    return true;
-  }
+    case PM_WHILE_NODE: {
+      const pm_while_node_t* while_node = (const pm_while_node_t*) node;
 
-  return false;
-}
+      return has_location(while_node->keyword_loc) && !is_end_keyword(while_node->closing_loc);
+    }
 
-bool search_unexpected_ensure_nodes(analyzed_ruby_T* analyzed) {
-  if (has_error_message(analyzed, "unexpected 'ensure', ignoring it")) {
-    analyzed->ensure_node_count++;
-    return true;
-  }
+    case PM_UNTIL_NODE: {
+      const pm_until_node_t* until_node = (const pm_until_node_t*) node;
 
-  return false;
-}
+      return has_location(until_node->keyword_loc) && !is_end_keyword(until_node->closing_loc);
+    }
 
-bool search_yield_nodes(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
+    case PM_FOR_NODE: {
+      const pm_for_node_t* for_node = (const pm_for_node_t*) node;
 
-  if (node->type == PM_YIELD_NODE) { analyzed->yield_node_count++; }
+      return has_location(for_node->for_keyword_loc) && !is_end_keyword(for_node->end_keyword_loc);
+    }
 
-  pm_visit_child_nodes(node, search_yield_nodes, analyzed);
+    case PM_BEGIN_NODE: {
+      const pm_begin_node_t* begin_node = (const pm_begin_node_t*) node;
 
-  return false;
-}
+      return has_location(begin_node->begin_keyword_loc) && !is_end_keyword(begin_node->end_keyword_loc);
+    }
 
-bool search_then_keywords(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
+    case PM_BLOCK_NODE: {
+      const pm_block_node_t* block_node = (const pm_block_node_t*) node;
 
-  switch (node->type) {
-    case PM_IF_NODE: {
-      const pm_if_node_t* if_node = (const pm_if_node_t*) node;
-      if (if_node->then_keyword_loc.start != NULL && if_node->then_keyword_loc.end != NULL) {
-        analyzed->then_keyword_count++;
-      }
-      break;
+      return is_unclosed_block(block_node->opening_loc, block_node->closing_loc);
     }
 
-    case PM_UNLESS_NODE: {
-      const pm_unless_node_t* unless_node = (const pm_unless_node_t*) node;
-      if (unless_node->then_keyword_loc.start != NULL && unless_node->then_keyword_loc.end != NULL) {
-        analyzed->then_keyword_count++;
-      }
-      break;
-    }
+    case PM_LAMBDA_NODE: {
+      const pm_lambda_node_t* lambda_node = (const pm_lambda_node_t*) node;
 
-    case PM_WHEN_NODE: {
-      const pm_when_node_t* when_node = (const pm_when_node_t*) node;
-      if (when_node->then_keyword_loc.start != NULL && when_node->then_keyword_loc.end != NULL) {
-        analyzed->then_keyword_count++;
-      }
-      break;
+      return is_unclosed_block(lambda_node->opening_loc, lambda_node->closing_loc);
     }
 
-    default: break;
+    default: return false;
   }
-
-  pm_visit_child_nodes(node, search_then_keywords, analyzed);
-
-  return false;
 }
 
-static bool is_postfix_conditional(const pm_statements_node_t* statements, pm_location_t keyword_location) {
-  if (statements == NULL) { return false; }
+// Keeps the first `then` in pre-order, like the separate search this replaced, which stopped at its first match.
+static void record_then_keyword_location(ruby_search_context_T* context, pm_location_t then_keyword_loc) {
+  analyzed_ruby_T* analyzed = context->analyzed;
 
-  return statements->base.location.start < keyword_location.start;
-}
+  if (analyzed->has_then_keyword_location || !has_location(then_keyword_loc)) { return; }
 
-bool search_unclosed_control_flows(const pm_node_t* node, void* data) {
-  analyzed_ruby_T* analyzed = (analyzed_ruby_T*) data;
+  analyzed->has_then_keyword_location = true;
+  analyzed->then_keyword_start = (uint32_t) (then_keyword_loc.start - context->source_start);
+  analyzed->then_keyword_end = (uint32_t) (then_keyword_loc.end - context->source_start);
+}
 
-  if (analyzed->unclosed_control_flow_count >= 2) { return false; }
+bool search_ruby_nodes(const pm_node_t* node, void* data) {
+  ruby_search_context_T* context = (ruby_search_context_T*) data;
+  analyzed_ruby_T* analyzed = context->analyzed;
 
   switch (node->type) {
     case PM_IF_NODE: {
       const pm_if_node_t* if_node = (const pm_if_node_t*) node;
 
-      if (has_location(if_node->if_keyword_loc) && !is_end_keyword(if_node->end_keyword_loc)) {
-        if (!is_postfix_conditional(if_node->statements, if_node->if_keyword_loc)) {
-          analyzed->unclosed_control_flow_count++;
-        }
-      }
+      if (has_keyword(if_node->if_keyword_loc) && has_keyword(if_node->end_keyword_loc)) { analyzed->if_node_count++; }
+      if (has_keyword(if_node->then_keyword_loc)) { analyzed->then_keyword_count++; }
+
+      record_then_keyword_location(context, if_node->then_keyword_loc);
 
       break;
     }
@@ -428,101 +250,129 @@ bool search_unclosed_control_flows(const pm_node_t* node, void* data) {
     case PM_UNLESS_NODE: {
       const pm_unless_node_t* unless_node = (const pm_unless_node_t*) node;
 
-      if (has_location(unless_node->keyword_loc) && !is_end_keyword(unless_node->end_keyword_loc)) {
-        if (!is_postfix_conditional(unless_node->statements, unless_node->keyword_loc)) {
-          analyzed->unclosed_control_flow_count++;
-        }
+      if (has_keyword(unless_node->keyword_loc) && has_keyword(unless_node->end_keyword_loc)) {
+        analyzed->unless_node_count++;
       }
 
-      break;
-    }
-
-    case PM_CASE_NODE: {
-      const pm_case_node_t* case_node = (const pm_case_node_t*) node;
+      if (has_keyword(unless_node->then_keyword_loc)) { analyzed->then_keyword_count++; }
 
-      if (has_location(case_node->case_keyword_loc) && !is_end_keyword(case_node->end_keyword_loc)) {
-        analyzed->unclosed_control_flow_count++;
-      }
+      record_then_keyword_location(context, unless_node->then_keyword_loc);
 
       break;
     }
 
-    case PM_CASE_MATCH_NODE: {
-      const pm_case_match_node_t* case_match_node = (const pm_case_match_node_t*) node;
-
-      if (has_location(case_match_node->case_keyword_loc) && !is_end_keyword(case_match_node->end_keyword_loc)) {
-        analyzed->unclosed_control_flow_count++;
-      }
-
-      break;
-    }
-
-    case PM_WHILE_NODE: {
-      const pm_while_node_t* while_node = (const pm_while_node_t*) node;
-
-      if (has_location(while_node->keyword_loc) && !is_end_keyword(while_node->closing_loc)) {
-        analyzed->unclosed_control_flow_count++;
-      }
-
-      break;
-    }
+    case PM_WHEN_NODE: {
+      const pm_when_node_t* when_node = (const pm_when_node_t*) node;
 
-    case PM_UNTIL_NODE: {
-      const pm_until_node_t* until_node = (const pm_until_node_t*) node;
+      analyzed->when_node_count++;
+      if (has_keyword(when_node->then_keyword_loc)) { analyzed->then_keyword_count++; }
 
-      if (has_location(until_node->keyword_loc) && !is_end_keyword(until_node->closing_loc)) {
-        analyzed->unclosed_control_flow_count++;
-      }
+      record_then_keyword_location(context, when_node->then_keyword_loc);
 
       break;
     }
 
-    case PM_FOR_NODE: {
-      const pm_for_node_t* for_node = (const pm_for_node_t*) node;
-
-      if (has_location(for_node->for_keyword_loc) && !is_end_keyword(for_node->end_keyword_loc)) {
-        analyzed->unclosed_control_flow_count++;
-      }
+    case PM_IN_NODE: {
+      const pm_in_node_t* in_node = (const pm_in_node_t*) node;
 
-      break;
-    }
+      analyzed->in_node_count++;
 
-    case PM_BEGIN_NODE: {
-      const pm_begin_node_t* begin_node = (const pm_begin_node_t*) node;
-
-      if (has_location(begin_node->begin_keyword_loc) && !is_end_keyword(begin_node->end_keyword_loc)) {
-        analyzed->unclosed_control_flow_count++;
-      }
+      record_then_keyword_location(context, in_node->then_loc);
 
       break;
     }
 
     case PM_BLOCK_NODE: {
       const pm_block_node_t* block_node = (const pm_block_node_t*) node;
-      bool has_opening = is_do_block(block_node->opening_loc) || is_brace_block(block_node->opening_loc);
 
-      if (has_opening && !has_valid_block_closing(block_node->opening_loc, block_node->closing_loc)) {
-        analyzed->unclosed_control_flow_count++;
-      }
+      if (is_unclosed_block(block_node->opening_loc, block_node->closing_loc)) { analyzed->block_node_count++; }
 
       break;
     }
 
     case PM_LAMBDA_NODE: {
       const pm_lambda_node_t* lambda_node = (const pm_lambda_node_t*) node;
-      bool has_opening = is_do_block(lambda_node->opening_loc) || is_brace_block(lambda_node->opening_loc);
 
-      if (has_opening && !has_valid_block_closing(lambda_node->opening_loc, lambda_node->closing_loc)) {
-        analyzed->unclosed_control_flow_count++;
-      }
+      if (is_unclosed_block(lambda_node->opening_loc, lambda_node->closing_loc)) { analyzed->block_node_count++; }
 
       break;
     }
 
+    case PM_CASE_NODE: analyzed->case_node_count++; break;
+    case PM_CASE_MATCH_NODE: analyzed->case_match_node_count++; break;
+    case PM_WHILE_NODE: analyzed->while_node_count++; break;
+    case PM_FOR_NODE: analyzed->for_node_count++; break;
+    case PM_UNTIL_NODE: analyzed->until_node_count++; break;
+    case PM_BEGIN_NODE: analyzed->begin_node_count++; break;
+    case PM_MATCH_PREDICATE_NODE: analyzed->in_node_count++; break;
+    case PM_YIELD_NODE: analyzed->yield_node_count++; break;
     default: break;
   }
 
-  pm_visit_child_nodes(node, search_unclosed_control_flows, analyzed);
+  // Only invalid snippets need to know about unclosed control flow, and two is already enough to report it.
+  if (!analyzed->valid && analyzed->unclosed_control_flow_count < 2 && is_unclosed_control_flow(node)) {
+    analyzed->unclosed_control_flow_count++;
+  }
+
+  pm_visit_child_nodes(node, search_ruby_nodes, context);
 
   return false;
 }
+
+void search_ruby_errors(const pm_parser_t* parser, analyzed_ruby_T* analyzed) {
+  bool unexpected_elsif = false;
+  bool unexpected_else = false;
+  bool unexpected_end = false;
+  bool unexpected_equals = false;
+  bool unexpected_block_closing = false;
+  bool unexpected_when = false;
+  bool unexpected_in = false;
+  bool unexpected_rescue = false;
+  bool unexpected_ensure = false;
+
+  for (const pm_diagnostic_t* error = (const pm_diagnostic_t*) parser->error_list.head; error != NULL;
+       error = (const pm_diagnostic_t*) error->node.next) {
+    const char* message = error->message;
+
+    if (string_equals(message, "unexpected 'elsif', ignoring it")) {
+      unexpected_elsif = true;
+    } else if (string_equals(message, "unexpected 'else', ignoring it")) {
+      unexpected_else = true;
+    } else if (string_equals(message, "unexpected 'end', ignoring it")) {
+      unexpected_end = true;
+    } else if (string_equals(message, "unexpected '=', ignoring it")) {
+      unexpected_equals = true;
+    } else if (string_equals(message, "unexpected '}', ignoring it")) {
+      unexpected_block_closing = true;
+    } else if (string_equals(message, "unexpected 'when', ignoring it")) {
+      unexpected_when = true;
+    } else if (string_equals(message, "unexpected 'in', ignoring it")) {
+      unexpected_in = true;
+    } else if (string_equals(message, "unexpected 'rescue', ignoring it")) {
+      unexpected_rescue = true;
+    } else if (string_equals(message, "unexpected 'ensure', ignoring it")) {
+      unexpected_ensure = true;
+    } else if (string_equals(message, "embedded document meets end of file")) {
+      analyzed->unterminated_embedded_document = true;
+    } else if (string_equals(message, "Invalid break")) {
+      analyzed->invalid_break = true;
+    } else if (string_equals(message, "Invalid next")) {
+      analyzed->invalid_next = true;
+    } else if (string_equals(message, "Invalid redo")) {
+      analyzed->invalid_redo = true;
+    } else if (string_equals(message, "Invalid retry without rescue")) {
+      analyzed->invalid_retry = true;
+    }
+  }
+
+  analyzed->unexpected_embedded_document_end = unexpected_end && unexpected_equals;
+
+  if (unexpected_elsif) { analyzed->elsif_node_count++; }
+  if (unexpected_else) { analyzed->else_node_count++; }
+  if (unexpected_end && !unexpected_equals) { analyzed->end_count++; } // `=end`
+  if (unexpected_block_closing) { analyzed->block_closing_count++; }
+  if (unexpected_when) { analyzed->when_node_count++; }
+  if (unexpected_in) { analyzed->in_node_count++; }
+  if (unexpected_rescue) { analyzed->rescue_node_count++; }
+  if (unexpected_ensure) { analyzed->ensure_node_count++; }
+}
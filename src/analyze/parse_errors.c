@@ -1,9 +1,13 @@
 #include "../include/analyze/analyze.h"
+#include "../include/analyze/helpers.h"
 #include "../include/ast_node.h"
 #include "../include/ast_nodes.h"
 #include "../include/errors.h"
 #include "../include/extract.h"
+#include "../include/line_offsets.h"
+#include "../include/parse_stats.h"
 #include "../include/prism_helpers.h"
+#include "../include/util/hb_buffer.h"
 
 #include <prism.h>
 #include <string.h>
@@ -12,22 +16,31 @@ static void parse_erb_content_errors(AST_NODE_T* erb_node, const char* source) {
   if (!erb_node || erb_node->type != AST_ERB_CONTENT_NODE) { return; }
   AST_ERB_CONTENT_NODE_T* content_node = (AST_ERB_CONTENT_NODE_T*) erb_node;
 
-  if (!content_node->content || !content_node->content->value) { return; }
+  if (!content_node->content) { return; }
 
-  const char* content = content_node->content->value;
-  if (strlen(content) == 0) { return; }
+  // The tag was already parsed on its own during analysis. A partial script only accepts more than that parse
+  // did, so a tag that was valid there can't produce an error here.
+  if (content_node->analyzed_ruby != NULL && content_node->analyzed_ruby->valid) { return; }
+
+  hb_string_T content = content_node->content->value;
+  if (hb_string_is_empty(content)) { return; }
 
   pm_parser_t parser;
   pm_options_t options = { 0, .partial_script = true };
-  pm_parser_init(&parser, (const uint8_t*) content, strlen(content), &options);
+  pm_parser_init(&parser, (const uint8_t*) content.data, content.length, &options);
 
   pm_node_t* root = pm_parse(&parser);
+  herb_parse_stats_count_prism_parse();
 
   const pm_diagnostic_t* error = (const pm_diagnostic_t*) parser.error_list.head;
 
   if (error != NULL) {
-    RUBY_PARSE_ERROR_T* parse_error =
-      ruby_parse_error_from_prism_error_with_positions(error, erb_node->location.start, erb_node->location.end);
+    RUBY_PARSE_ERROR_T* parse_error = ruby_parse_error_from_prism_error_with_positions(
+      error,
+      erb_node->location.start,
+      erb_node->location.end,
+      erb_node->allocator
+    );
 
     hb_array_append(erb_node->errors, parse_error);
   }
@@ -37,25 +50,64 @@ static void parse_erb_content_errors(AST_NODE_T* erb_node, const char* source) {
   pm_options_free(&options);
 }
 
-void herb_analyze_parse_errors(AST_DOCUMENT_NODE_T* document, const char* source) {
-  char* extracted_ruby = herb_extract_ruby_with_semicolons(source);
+bool herb_analyze_parse_errors_init(parse_errors_context_T* context, const char* source, size_t source_length) {
+  // Every diagnostic needs its offset turned into a position, so index the lines once instead of
+  // rescanning the source from the start for each of them.
+  if (!line_offsets_init(&context->line_offsets, source, source_length)) { return false; }
+
+  context->ruby = malloc(source_length + 1);
+
+  if (!context->ruby || !hb_buffer_init(&context->scratch, 256)) {
+    free(context->ruby);
+    line_offsets_free(&context->line_offsets);
+    return false;
+  }
+
+  memset(context->ruby, ' ', source_length);
+  context->ruby[source_length] = '\0';
+
+  for (size_t line = 1; line < context->line_offsets.count; line++) {
+    size_t newline = context->line_offsets.starts[line] - 1;
+    context->ruby[newline] = source[newline];
+  }
+
+  return true;
+}
+
+bool herb_analyze_parse_errors_collect(const AST_NODE_T* node, const AST_NODE_T* parent, void* data) {
+  (void) parent;
+  parse_errors_context_T* context = (parse_errors_context_T*) data;
+
+  const token_T* tag_opening = NULL;
+  const token_T* content = NULL;
+  const token_T* tag_closing = NULL;
+
+  if (erb_node_tag_tokens(node, &tag_opening, &content, &tag_closing)) {
+    herb_extract_ruby_erb_tag(tag_opening, content, tag_closing, &context->scratch, context->ruby);
+  }
+
+  return true;
+}
 
-  if (!extracted_ruby) { return; }
+void herb_analyze_parse_errors(AST_DOCUMENT_NODE_T* document, const char* source, parse_errors_context_T* context) {
+  size_t source_length = context->line_offsets.source_length;
+  char* extracted_ruby = context->ruby;
 
   pm_parser_t parser;
   pm_options_t options = { 0, .partial_script = true };
-  pm_parser_init(&parser, (const uint8_t*) extracted_ruby, strlen(extracted_ruby), &options);
+  pm_parser_init(&parser, (const uint8_t*) extracted_ruby, source_length, &options);
 
   pm_node_t* root = pm_parse(&parser);
+  herb_parse_stats_count_prism_parse();
 
   for (const pm_diagnostic_t* error = (const pm_diagnostic_t*) parser.error_list.head; error != NULL;
        error = (const pm_diagnostic_t*) error->node.next) {
     size_t error_offset = (size_t) (error->location.start - parser.start);
 
     if (strstr(error->message, "unexpected ';'") != NULL) {
-      if (error_offset < strlen(extracted_ruby) && extracted_ruby[error_offset] == ';') {
-        if (error_offset >= strlen(source) || source[error_offset] != ';') {
-          AST_NODE_T* erb_node = find_erb_content_at_offset(document, source, error_offset);
+      if (error_offset < source_length && extracted_ruby[error_offset] == ';') {
+        if (source[error_offset] != ';') {
+          AST_NODE_T* erb_node = find_erb_content_at_offset(document, &context->line_offsets, error_offset);
 
           if (erb_node) { parse_erb_content_errors(erb_node, source); }
 
@@ -64,12 +116,19 @@ void herb_analyze_parse_errors(AST_DOCUMENT_NODE_T* document, const char* source
       }
     }
 
-    RUBY_PARSE_ERROR_T* parse_error = ruby_parse_error_from_prism_error(error, (AST_NODE_T*) document, source, &parser);
+    RUBY_PARSE_ERROR_T* parse_error = ruby_parse_error_from_prism_error(
+      error,
+      (AST_NODE_T*) document,
+      &context->line_offsets,
+      &parser
+    );
     hb_array_append(document->base.errors, parse_error);
   }
 
   pm_node_destroy(&parser, root);
   pm_parser_free(&parser);
   pm_options_free(&options);
+  line_offsets_free(&context->line_offsets);
+  free(context->scratch.value);
   free(extracted_ruby);
 }
@@ -1,6 +1,7 @@
 #include "include/ast_node.h"
 #include "include/ast_nodes.h"
 #include "include/errors.h"
+#include "include/line_offsets.h"
 #include "include/position.h"
 #include "include/util.h"
 #include "include/visitor.h"
@@ -13,32 +14,76 @@ size_t ast_node_sizeof(void) {
   return sizeof(struct AST_NODE_STRUCT);
 }
 
-void ast_node_init(AST_NODE_T* node, const ast_node_type_T type, position_T start, position_T end, hb_array_T* errors) {
+void* ast_node_allocate(size_t size, hb_arena_T* allocator) {
+  if (allocator == NULL) { return malloc(size); }
+
+  return hb_arena_alloc(allocator, size);
+}
+
+void ast_node_init(
+  AST_NODE_T* node,
+  const ast_node_type_T type,
+  position_T start,
+  position_T end,
+  hb_array_T* errors,
+  hb_arena_T* allocator
+) {
   if (!node) { return; }
 
   node->type = type;
   node->location.start = start;
   node->location.end = end;
+  node->allocator = allocator;
 
   if (errors == NULL) {
-    node->errors = hb_array_init(8);
+    node->errors = hb_array_init_arena(allocator, 8);
   } else {
     node->errors = errors;
   }
 }
 
-AST_LITERAL_NODE_T* ast_literal_node_init_from_token(const token_T* token) {
-  AST_LITERAL_NODE_T* literal = malloc(sizeof(AST_LITERAL_NODE_T));
+static char* ast_node_copy_string(hb_string_T string, hb_arena_T* allocator) {
+  return allocator == NULL ? hb_string_to_c_string_using_malloc(string) : hb_string_to_c_string(allocator, string);
+}
 
-  if (!literal) { return NULL; }
+AST_LITERAL_NODE_T* ast_literal_node_init_from_token(const token_T* token, hb_arena_T* allocator) {
+  return ast_literal_node_init_from_string(token->value, token->location.start, token->location.end, NULL, allocator);
+}
 
-  ast_node_init(&literal->base, AST_LITERAL_NODE, token->location.start, token->location.end, NULL);
+AST_LITERAL_NODE_T* ast_literal_node_init_from_string(
+  hb_string_T content,
+  position_T start,
+  position_T end,
+  hb_array_T* errors,
+  hb_arena_T* allocator
+) {
+  AST_LITERAL_NODE_T* literal = ast_node_allocate(sizeof(AST_LITERAL_NODE_T), allocator);
 
-  literal->content = herb_strdup(token->value);
+  if (!literal) { return NULL; }
+
+  ast_node_init(&literal->base, AST_LITERAL_NODE, start, end, errors, allocator);
+  literal->content = ast_node_copy_string(content, allocator);
 
   return literal;
 }
 
+AST_HTML_TEXT_NODE_T* ast_html_text_node_init_from_string(
+  hb_string_T content,
+  position_T start,
+  position_T end,
+  hb_array_T* errors,
+  hb_arena_T* allocator
+) {
+  AST_HTML_TEXT_NODE_T* text = ast_node_allocate(sizeof(AST_HTML_TEXT_NODE_T), allocator);
+
+  if (!text) { return NULL; }
+
+  ast_node_init(&text->base, AST_HTML_TEXT_NODE, start, end, errors, allocator);
+  text->content = ast_node_copy_string(content, allocator);
+
+  return text;
+}
+
 ast_node_type_T ast_node_type(const AST_NODE_T* node) {
   return node->type;
 }
@@ -98,8 +143,12 @@ static bool find_erb_at_position_visitor(const AST_NODE_T* node, void* data) {
   return true;
 }
 
-AST_NODE_T* find_erb_content_at_offset(AST_DOCUMENT_NODE_T* document, const char* source, size_t offset) {
-  position_T position = position_from_source_with_offset(source, offset);
+AST_NODE_T* find_erb_content_at_offset(
+  AST_DOCUMENT_NODE_T* document,
+  const line_offsets_T* line_offsets,
+  size_t offset
+) {
+  position_T position = line_offsets_position(line_offsets, offset);
   find_erb_at_position_context_T context = { .position = position, .found_node = NULL };
 
   herb_visit_node((AST_NODE_T*) document, find_erb_at_position_visitor, &context);
@@ -0,0 +1,370 @@
+#define _POSIX_C_SOURCE 200809L // Enables `clock_gettime()`, `strdup()` and `getrusage()`
+
+#include "include/bench.h"
+#include "include/extract.h"
+#include "include/herb.h"
+#include "include/io.h"
+#include "include/macros.h"
+#include "include/util/hb_arena.h"
+#include "include/util/hb_array.h"
+#include "include/util/hb_buffer.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define BENCH_ARENA_SIZE MB(1)
+
+typedef struct {
+  char* path;
+  char* source;
+  size_t length;
+} bench_file_T;
+
+typedef struct {
+  hb_arena_T* allocator;
+  hb_buffer_T* output;
+} bench_context_T;
+
+typedef void (*bench_phase_function_T)(const char* source, bench_context_T* context);
+
+typedef struct {
+  const char* name;
+  bench_phase_function_T run;
+  bool uses_arena;
+} bench_phase_T;
+
+typedef struct {
+  double seconds;
+  double p50_us;
+  double p99_us;
+  size_t allocations;
+  size_t arena_bytes;
+} bench_result_T;
+
+static void bench_lex(const char* source, bench_context_T* context) {
+  herb_lex_arena(source, context->allocator);
+}
+
+static void bench_parse(const char* source, bench_context_T* context) {
+  parser_options_T options = HERB_DEFAULT_PARSER_OPTIONS;
+  options.analyze = false;
+
+  herb_parse_arena(source, &options, context->allocator);
+}
+
+static void bench_parse_analyze(const char* source, bench_context_T* context) {
+  herb_parse_arena(source, &HERB_DEFAULT_PARSER_OPTIONS, context->allocator);
+}
+
+static void bench_extract_ruby(const char* source, bench_context_T* context) {
+  hb_buffer_clear(context->output);
+  herb_extract_ruby_to_buffer(source, context->output);
+}
+
+static void bench_extract_html(const char* source, bench_context_T* context) {
+  hb_buffer_clear(context->output);
+  herb_extract_html_to_buffer(source, context->output);
+}
+
+// Lexing and parsing go through the arena entry points, like herb_parse_files(), so every allocation they make
+// is counted and released by rewinding the arena. The extractors allocate with malloc and aren't counted.
+static const bench_phase_T bench_phases[] = {
+  { "lex", bench_lex, true },
+  { "parse", bench_parse, true },
+  { "parse+analyze", bench_parse_analyze, true },
+  { "extract-ruby", bench_extract_ruby, false },
+  { "extract-html", bench_extract_html, false },
+};
+
+#define BENCH_PHASE_COUNT (sizeof(bench_phases) / sizeof(bench_phases[0]))
+
+static bool bench_has_suffix(const char* string, const char* suffix) {
+  size_t string_length = strlen(string);
+  size_t suffix_length = strlen(suffix);
+
+  return string_length >= suffix_length && strcmp(string + string_length - suffix_length, suffix) == 0;
+}
+
+static void bench_collect_directory(const char* directory, hb_array_T* paths) {
+  DIR* handle = opendir(directory);
+  if (handle == NULL) { return; }
+
+  struct dirent* entry;
+
+  while ((entry = readdir(handle)) != NULL) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) { continue; }
+
+    size_t length = strlen(directory) + strlen(entry->d_name) + 2;
+    char* path = malloc(length);
+    if (path == NULL) { continue; }
+
+    snprintf(path, length, "%s/%s", directory, entry->d_name);
+
+    struct stat info;
+
+    if (stat(path, &info) != 0) {
+      free(path);
+    } else if (S_ISDIR(info.st_mode)) {
+      bench_collect_directory(path, paths);
+      free(path);
+    } else if (S_ISREG(info.st_mode) && bench_has_suffix(path, ".erb")) {
+      hb_array_append(paths, path);
+    } else {
+      free(path);
+    }
+  }
+
+  closedir(handle);
+}
+
+static int bench_compare_files(const void* left, const void* right) {
+  return strcmp(((const bench_file_T*) left)->path, ((const bench_file_T*) right)->path);
+}
+
+static int bench_compare_latencies(const void* left, const void* right) {
+  double difference = *(const double*) left - *(const double*) right;
+
+  return (difference > 0) - (difference < 0);
+}
+
+// Reads every template up front, sorted by path so runs over the same corpus are comparable.
+static bench_file_T* bench_load_files(const char* path, size_t* count) {
+  hb_array_T* paths = hb_array_init(64);
+  struct stat info;
+
+  if (stat(path, &info) == 0 && S_ISDIR(info.st_mode)) {
+    bench_collect_directory(path, paths);
+  } else {
+    hb_array_append(paths, strdup(path));
+  }
+
+  bench_file_T* files = calloc(MAX(hb_array_size(paths), 1), sizeof(bench_file_T));
+  *count = 0;
+
+  for (size_t index = 0; index < hb_array_size(paths); index++) {
+    char* file_path = hb_array_get(paths, index);
+    char* source = files != NULL && file_path != NULL ? herb_try_read_file(file_path, NULL) : NULL;
+
+    if (source == NULL) {
+      if (files != NULL && file_path != NULL) { fprintf(stderr, "Could not read file '%s'\n", file_path); }
+      free(file_path);
+
+      continue;
+    }
+
+    files[(*count)++] = (bench_file_T) { .path = file_path, .source = source, .length = strlen(source) };
+  }
+
+  hb_array_free(&paths);
+
+  if (files != NULL) { qsort(files, *count, sizeof(bench_file_T), bench_compare_files); }
+
+  return files;
+}
+
+static double bench_elapsed_us(const struct timespec start, const struct timespec end) {
+  return ((double) end.tv_sec - (double) start.tv_sec) * 1e6 + ((double) end.tv_nsec - (double) start.tv_nsec) / 1e3;
+}
+
+// Nearest-rank percentile of the sorted latencies.
+static double bench_percentile(const double* latencies, size_t count, double percentile) {
+  size_t rank = (size_t) (percentile * (double) count + 0.999999);
+  if (rank < 1) { rank = 1; }
+
+  return latencies[MIN(rank, count) - 1];
+}
+
+static bench_result_T bench_run_phase(
+  const bench_phase_T* phase,
+  const bench_file_T* files,
+  size_t count,
+  size_t iterations,
+  bench_context_T* context,
+  double* latencies
+) {
+  bench_result_T result = { 0 };
+  size_t sample = 0;
+
+  // One untimed pass first, so the timed iterations don't pay for page faults and cold caches.
+  for (size_t index = 0; index < count; index++) {
+    phase->run(files[index].source, context);
+    hb_arena_reset(context->allocator);
+  }
+
+  for (size_t iteration = 0; iteration < iterations; iteration++) {
+    for (size_t index = 0; index < count; index++) {
+      struct timespec start, end;
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      phase->run(files[index].source, context);
+      clock_gettime(CLOCK_MONOTONIC, &end);
+
+      latencies[sample++] = bench_elapsed_us(start, end);
+      result.allocations += context->allocator->allocation_count;
+      result.arena_bytes += hb_arena_position(context->allocator);
+
+      hb_arena_reset(context->allocator);
+    }
+  }
+
+  for (size_t index = 0; index < sample; index++) {
+    result.seconds += latencies[index] / 1e6;
+  }
+
+  qsort(latencies, sample, sizeof(double), bench_compare_latencies);
+
+  result.p50_us = bench_percentile(latencies, sample, 0.50);
+  result.p99_us = bench_percentile(latencies, sample, 0.99);
+
+  return result;
+}
+
+static size_t bench_peak_rss_bytes(void) {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+
+#ifdef __APPLE__
+  return (size_t) usage.ru_maxrss;
+#else
+  return (size_t) usage.ru_maxrss * 1024;
+#endif
+}
+
+static void bench_print_text(
+  const bench_result_T* results,
+  size_t files,
+  size_t bytes,
+  size_t iterations,
+  size_t peak_rss
+) {
+  printf("Herb %s, %zu files (%.2f MB), %zu iterations\n\n", herb_version(), files, (double) bytes / 1e6, iterations);
+  printf("  Phase               MB/s     Files/s    p50 (µs)    p99 (µs)   Allocs/file   Arena KB/file\n");
+
+  for (size_t index = 0; index < BENCH_PHASE_COUNT; index++) {
+    const bench_result_T* result = &results[index];
+    const double runs = (double) (files * iterations);
+
+    printf(
+      "  %-14s %9.2f %11.1f %11.2f %11.2f",
+      bench_phases[index].name,
+      (double) (bytes * iterations) / 1e6 / result->seconds,
+      runs / result->seconds,
+      result->p50_us,
+      result->p99_us
+    );
+
+    if (bench_phases[index].uses_arena) {
+      printf(" %13.1f %15.2f\n", (double) result->allocations / runs, (double) result->arena_bytes / runs / 1024);
+    } else {
+      printf(" %13s %15s\n", "-", "-");
+    }
+  }
+
+  printf("\n  Peak RSS: %.2f MB\n", (double) peak_rss / 1e6);
+}
+
+static void bench_print_json(
+  const bench_result_T* results,
+  size_t files,
+  size_t bytes,
+  size_t iterations,
+  size_t peak_rss
+) {
+  printf("{\n");
+  printf("  \"herb_version\": \"%s\",\n", herb_version());
+  printf("  \"files\": %zu,\n", files);
+  printf("  \"bytes\": %zu,\n", bytes);
+  printf("  \"iterations\": %zu,\n", iterations);
+  printf("  \"peak_rss_bytes\": %zu,\n", peak_rss);
+  printf("  \"phases\": [\n");
+
+  for (size_t index = 0; index < BENCH_PHASE_COUNT; index++) {
+    const bench_result_T* result = &results[index];
+    const double runs = (double) (files * iterations);
+
+    printf("    {\n");
+    printf("      \"name\": \"%s\",\n", bench_phases[index].name);
+    printf("      \"seconds\": %.6f,\n", result->seconds);
+    printf("      \"mb_per_second\": %.3f,\n", (double) (bytes * iterations) / 1e6 / result->seconds);
+    printf("      \"files_per_second\": %.3f,\n", runs / result->seconds);
+    printf("      \"p50_us\": %.3f,\n", result->p50_us);
+    printf("      \"p99_us\": %.3f,\n", result->p99_us);
+
+    if (bench_phases[index].uses_arena) {
+      printf("      \"allocations_per_file\": %.3f,\n", (double) result->allocations / runs);
+      printf("      \"arena_bytes_per_file\": %.3f\n", (double) result->arena_bytes / runs);
+    } else {
+      printf("      \"allocations_per_file\": null,\n");
+      printf("      \"arena_bytes_per_file\": null\n");
+    }
+
+    printf("    }%s\n", index + 1 < BENCH_PHASE_COUNT ? "," : "");
+  }
+
+  printf("  ]\n");
+  printf("}\n");
+}
+
+bool herb_bench(const char* path, const herb_bench_options_T* options) {
+  size_t count = 0;
+  bench_file_T* files = bench_load_files(path, &count);
+
+  if (files == NULL || count == 0) {
+    fprintf(stderr, "No templates to benchmark in '%s'\n", path);
+    free(files);
+
+    return false;
+  }
+
+  size_t iterations = MAX(options->iterations, 1);
+  size_t bytes = 0;
+
+  for (size_t index = 0; index < count; index++) {
+    bytes += files[index].length;
+  }
+
+  hb_arena_T allocator;
+  hb_buffer_T output;
+  double* latencies = malloc(count * iterations * sizeof(double));
+  bool ready = latencies != NULL && hb_arena_init(&allocator, BENCH_ARENA_SIZE);
+
+  if (ready && !hb_buffer_init(&output, 4096)) {
+    hb_arena_free(&allocator);
+    ready = false;
+  }
+
+  if (ready) {
+    bench_context_T context = { .allocator = &allocator, .output = &output };
+    bench_result_T results[BENCH_PHASE_COUNT];
+
+    for (size_t index = 0; index < BENCH_PHASE_COUNT; index++) {
+      results[index] = bench_run_phase(&bench_phases[index], files, count, iterations, &context, latencies);
+    }
+
+    if (options->json) {
+      bench_print_json(results, count, bytes, iterations, bench_peak_rss_bytes());
+    } else {
+      bench_print_text(results, count, bytes, iterations, bench_peak_rss_bytes());
+    }
+
+    hb_arena_free(&allocator);
+    free(output.value);
+  } else {
+    fprintf(stderr, "Could not allocate memory for the benchmark\n");
+  }
+
+  for (size_t index = 0; index < count; index++) {
+    free(files[index].path);
+    free(files[index].source);
+  }
+
+  free(files);
+  free(latencies);
+
+  return ready;
+}
@@ -0,0 +1,34 @@
+#include "include/herb.h"
+#include "include/macros.h"
+#include "include/util/hb_arena.h"
+
+#define HERB_CONTEXT_DEFAULT_ARENA_SIZE MB(1)
+
+HERB_EXPORTED_FUNCTION bool herb_context_init(herb_context_T* context, size_t arena_size) {
+  if (context == NULL) { return false; }
+
+  return hb_arena_init(&context->allocator, arena_size > 0 ? arena_size : HERB_CONTEXT_DEFAULT_ARENA_SIZE);
+}
+
+HERB_EXPORTED_FUNCTION AST_DOCUMENT_NODE_T* herb_context_parse(
+  herb_context_T* context,
+  const char* source,
+  size_t length,
+  const parser_options_T* options
+) {
+  if (context == NULL) { return NULL; }
+
+  return herb_parse_arena_with_length(source, length, options, &context->allocator);
+}
+
+HERB_EXPORTED_FUNCTION void herb_context_reset(herb_context_T* context) {
+  if (context == NULL) { return; }
+
+  hb_arena_reset(&context->allocator);
+}
+
+HERB_EXPORTED_FUNCTION void herb_context_free(herb_context_T* context) {
+  if (context == NULL) { return; }
+
+  hb_arena_free(&context->allocator);
+}
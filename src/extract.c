@@ -1,6 +1,5 @@
 #include "include/herb.h"
 #include "include/io.h"
-#include "include/util/hb_array.h"
 #include "include/util/hb_buffer.h"
 #include "include/util/string.h"
 
@@ -12,152 +11,208 @@ const herb_extract_ruby_options_T HERB_EXTRACT_RUBY_DEFAULT_OPTIONS = { .semicol
                                                                         .comments = false,
                                                                         .preserve_positions = true };
 
-void herb_extract_ruby_to_buffer_with_options(
-  const char* source,
-  hb_buffer_T* output,
-  const herb_extract_ruby_options_T* options
-) {
-  herb_extract_ruby_options_T extract_options = options ? *options : HERB_EXTRACT_RUBY_DEFAULT_OPTIONS;
-
-  hb_array_T* tokens = herb_lex(source);
-  bool skip_erb_content = false;
-  bool is_comment_tag = false;
-  bool is_erb_comment_tag = false;
-  bool need_newline = false;
-
-  for (size_t i = 0; i < hb_array_size(tokens); i++) {
-    const token_T* token = hb_array_get(tokens, i);
-
-    switch (token->type) {
-      case TOKEN_NEWLINE: {
-        hb_buffer_append(output, token->value);
-        need_newline = false;
-        break;
-      }
+typedef struct {
+  hb_buffer_T* output;
+  herb_extract_ruby_options_T options;
+  bool skip_erb_content;
+  bool is_comment_tag;
+  bool is_erb_comment_tag;
+  bool need_newline;
+} extract_ruby_context_T;
+
+static bool extract_ruby_token(const token_T* token, void* user_data) {
+  extract_ruby_context_T* context = user_data;
+  const herb_extract_ruby_options_T* options = &context->options;
+  hb_buffer_T* output = context->output;
+
+  switch (token->type) {
+    case TOKEN_NEWLINE: {
+      hb_buffer_append_string(output, token->value);
+      context->need_newline = false;
+      break;
+    }
+
+    case TOKEN_ERB_START: {
+      context->is_erb_comment_tag = hb_string_equals(token->value, hb_string("<%#"));
+
+      if (context->is_erb_comment_tag) {
+        if (options->comments) {
+          context->skip_erb_content = false;
+          context->is_comment_tag = false;
 
-      case TOKEN_ERB_START: {
-        is_erb_comment_tag = string_equals(token->value, "<%#");
-
-        if (is_erb_comment_tag) {
-          if (extract_options.comments) {
-            skip_erb_content = false;
-            is_comment_tag = false;
-
-            if (extract_options.preserve_positions) {
-              hb_buffer_append_whitespace(output, 2);
-              hb_buffer_append_char(output, '#');
-            } else {
-              if (need_newline) { hb_buffer_append_char(output, '\n'); }
-              hb_buffer_append_char(output, '#');
-              need_newline = true;
-            }
+          if (options->preserve_positions) {
+            hb_buffer_append_whitespace(output, 2);
+            hb_buffer_append_char(output, '#');
           } else {
-            skip_erb_content = true;
-            is_comment_tag = true;
-            if (extract_options.preserve_positions) { hb_buffer_append_whitespace(output, range_length(token->range)); }
+            if (context->need_newline) { hb_buffer_append_char(output, '\n'); }
+            hb_buffer_append_char(output, '#');
+            context->need_newline = true;
           }
-        } else if (string_equals(token->value, "<%%") || string_equals(token->value, "<%%=")
-                   || string_equals(token->value, "<%graphql")) {
-          skip_erb_content = true;
-          is_comment_tag = false;
-          if (extract_options.preserve_positions) { hb_buffer_append_whitespace(output, range_length(token->range)); }
         } else {
-          skip_erb_content = false;
-          is_comment_tag = false;
-
-          if (extract_options.preserve_positions) {
-            hb_buffer_append_whitespace(output, range_length(token->range));
-          } else if (need_newline) {
-            hb_buffer_append_char(output, '\n');
-            need_newline = false;
-          }
+          context->skip_erb_content = true;
+          context->is_comment_tag = true;
+          if (options->preserve_positions) { hb_buffer_append_whitespace(output, range_length(token->range)); }
+        }
+      } else if (hb_string_equals(token->value, hb_string("<%%")) || hb_string_equals(token->value, hb_string("<%%="))
+                 || hb_string_equals(token->value, hb_string("<%graphql"))) {
+        context->skip_erb_content = true;
+        context->is_comment_tag = false;
+        if (options->preserve_positions) { hb_buffer_append_whitespace(output, range_length(token->range)); }
+      } else {
+        context->skip_erb_content = false;
+        context->is_comment_tag = false;
+
+        if (options->preserve_positions) {
+          hb_buffer_append_whitespace(output, range_length(token->range));
+        } else if (context->need_newline) {
+          hb_buffer_append_char(output, '\n');
+          context->need_newline = false;
         }
-
-        break;
       }
 
-      case TOKEN_ERB_CONTENT: {
-        if (skip_erb_content == false) {
-          bool is_inline_comment = false;
+      break;
+    }
 
-          if (!extract_options.comments && !is_comment_tag && token->value != NULL) {
-            const char* content = token->value;
+    case TOKEN_ERB_CONTENT: {
+      if (context->skip_erb_content == false) {
+        bool is_inline_comment = false;
 
-            while (*content == ' ' || *content == '\t') {
-              content++;
-            }
+        if (!options->comments && !context->is_comment_tag) {
+          const char* content = token->value.data;
+          const char* content_end = content + token->value.length;
 
-            if (*content == '#' && token->location.start.line == token->location.end.line) {
-              is_comment_tag = true;
-              is_inline_comment = true;
-            }
+          while (content < content_end && (*content == ' ' || *content == '\t')) {
+            content++;
           }
 
-          if (is_inline_comment) {
-            if (extract_options.preserve_positions) { hb_buffer_append_whitespace(output, range_length(token->range)); }
-          } else {
-            hb_buffer_append(output, token->value);
-            if (!extract_options.preserve_positions) { need_newline = true; }
+          if (content < content_end && *content == '#' && token->location.start.line == token->location.end.line) {
+            context->is_comment_tag = true;
+            is_inline_comment = true;
           }
-        } else {
-          if (extract_options.preserve_positions) { hb_buffer_append_whitespace(output, range_length(token->range)); }
         }
 
-        break;
+        if (is_inline_comment) {
+          if (options->preserve_positions) { hb_buffer_append_whitespace(output, range_length(token->range)); }
+        } else {
+          hb_buffer_append_string(output, token->value);
+          if (!options->preserve_positions) { context->need_newline = true; }
+        }
+      } else {
+        if (options->preserve_positions) { hb_buffer_append_whitespace(output, range_length(token->range)); }
       }
 
-      case TOKEN_ERB_END: {
-        bool was_comment = is_comment_tag;
-        bool was_erb_comment = is_erb_comment_tag;
-        skip_erb_content = false;
-        is_comment_tag = false;
-        is_erb_comment_tag = false;
-
-        if (extract_options.preserve_positions) {
-          if (was_comment) {
-            hb_buffer_append_whitespace(output, range_length(token->range));
-          } else if (was_erb_comment && extract_options.comments) {
-            hb_buffer_append_whitespace(output, range_length(token->range));
-          } else if (extract_options.semicolons) {
-            hb_buffer_append_char(output, ' ');
-            hb_buffer_append_char(output, ';');
-            hb_buffer_append_whitespace(output, range_length(token->range) - 2);
-          } else {
-            hb_buffer_append_whitespace(output, range_length(token->range));
-          }
-        }
+      break;
+    }
 
-        break;
+    case TOKEN_ERB_END: {
+      bool was_comment = context->is_comment_tag;
+      bool was_erb_comment = context->is_erb_comment_tag;
+      context->skip_erb_content = false;
+      context->is_comment_tag = false;
+      context->is_erb_comment_tag = false;
+
+      if (options->preserve_positions) {
+        if (was_comment) {
+          hb_buffer_append_whitespace(output, range_length(token->range));
+        } else if (was_erb_comment && options->comments) {
+          hb_buffer_append_whitespace(output, range_length(token->range));
+        } else if (options->semicolons) {
+          hb_buffer_append_char(output, ' ');
+          hb_buffer_append_char(output, ';');
+          hb_buffer_append_whitespace(output, range_length(token->range) - 2);
+        } else {
+          hb_buffer_append_whitespace(output, range_length(token->range));
+        }
       }
 
-      default: {
-        if (extract_options.preserve_positions) { hb_buffer_append_whitespace(output, range_length(token->range)); }
-      }
+      break;
+    }
+
+    default: {
+      if (options->preserve_positions) { hb_buffer_append_whitespace(output, range_length(token->range)); }
     }
   }
 
-  herb_free_tokens(&tokens);
+  return true;
+}
+
+static extract_ruby_context_T extract_ruby_context(hb_buffer_T* output, const herb_extract_ruby_options_T* options) {
+  return (extract_ruby_context_T) { .output = output,
+                                    .options = options ? *options : HERB_EXTRACT_RUBY_DEFAULT_OPTIONS,
+                                    .skip_erb_content = false,
+                                    .is_comment_tag = false,
+                                    .is_erb_comment_tag = false,
+                                    .need_newline = false };
+}
+
+void herb_extract_ruby_to_buffer_with_options(
+  const char* source,
+  hb_buffer_T* output,
+  const herb_extract_ruby_options_T* options
+) {
+  extract_ruby_context_T context = extract_ruby_context(output, options);
+
+  herb_lex_each(source, extract_ruby_token, &context);
+}
+
+void herb_extract_ruby_to_buffer_with_length(
+  const char* source,
+  size_t length,
+  hb_buffer_T* output,
+  const herb_extract_ruby_options_T* options
+) {
+  extract_ruby_context_T context = extract_ruby_context(output, options);
+
+  herb_lex_each_with_length(source, length, extract_ruby_token, &context);
+}
+
+void herb_extract_ruby_erb_tag(
+  const token_T* tag_opening,
+  const token_T* content,
+  const token_T* tag_closing,
+  hb_buffer_T* scratch,
+  char* output
+) {
+  const token_T* tokens[] = { tag_opening, content, tag_closing };
+  const token_T* first = NULL;
+
+  extract_ruby_context_T context = extract_ruby_context(scratch, NULL);
+
+  hb_buffer_clear(scratch);
+
+  for (size_t index = 0; index < sizeof(tokens) / sizeof(tokens[0]); index++) {
+    if (tokens[index] == NULL) { continue; }
+    if (first == NULL) { first = tokens[index]; }
+
+    extract_ruby_token(tokens[index], &context);
+  }
+
+  if (first != NULL) { memcpy(output + first->range.from, hb_buffer_value(scratch), hb_buffer_length(scratch)); }
 }
 
 void herb_extract_ruby_to_buffer(const char* source, hb_buffer_T* output) {
   herb_extract_ruby_to_buffer_with_options(source, output, NULL);
 }
 
-void herb_extract_html_to_buffer(const char* source, hb_buffer_T* output) {
-  hb_array_T* tokens = herb_lex(source);
-
-  for (size_t i = 0; i < hb_array_size(tokens); i++) {
-    const token_T* token = hb_array_get(tokens, i);
+static bool extract_html_token(const token_T* token, void* user_data) {
+  hb_buffer_T* output = user_data;
 
-    switch (token->type) {
-      case TOKEN_ERB_START:
-      case TOKEN_ERB_CONTENT:
-      case TOKEN_ERB_END: hb_buffer_append_whitespace(output, range_length(token->range)); break;
-      default: hb_buffer_append(output, token->value);
-    }
+  switch (token->type) {
+    case TOKEN_ERB_START:
+    case TOKEN_ERB_CONTENT:
+    case TOKEN_ERB_END: hb_buffer_append_whitespace(output, range_length(token->range)); break;
+    default: hb_buffer_append_string(output, token->value);
   }
 
-  herb_free_tokens(&tokens);
+  return true;
+}
+
+void herb_extract_html_to_buffer(const char* source, hb_buffer_T* output) {
+  herb_lex_each(source, extract_html_token, output);
+}
+
+void herb_extract_html_to_buffer_with_length(const char* source, size_t length, hb_buffer_T* output) {
+  herb_lex_each_with_length(source, length, extract_html_token, output);
 }
 
 char* herb_extract_ruby_with_semicolons(const char* source) {
@@ -178,7 +233,7 @@ char* herb_extract(const char* source, const herb_extract_language_T language) {
   hb_buffer_init(&output, strlen(source));
 
   switch (language) {
-    case HERB_EXTRACT_LANGUAGE_RUBY: herb_extract_ruby_to_buffer(source, &output); break;
+    case HERB_EXTRACT_LANGUAGE_RUBY: herb_extract_ruby_to_buffer_with_options(source, &output, NULL); break;
     case HERB_EXTRACT_LANGUAGE_HTML: herb_extract_html_to_buffer(source, &output); break;
     default: assert(0 && "invalid extract language");
   }
@@ -186,11 +241,26 @@ char* herb_extract(const char* source, const herb_extract_language_T language) {
   return output.value;
 }
 
+char* herb_extract_with_length(const char* source, size_t length, const herb_extract_language_T language) {
+  if (!source) { return NULL; }
+
+  hb_buffer_T output;
+  hb_buffer_init(&output, length);
+
+  switch (language) {
+    case HERB_EXTRACT_LANGUAGE_RUBY: herb_extract_ruby_to_buffer_with_length(source, length, &output, NULL); break;
+    case HERB_EXTRACT_LANGUAGE_HTML: herb_extract_html_to_buffer_with_length(source, length, &output); break;
+    default: assert(0 && "invalid extract language");
+  }
+
+  return output.value;
+}
+
 char* herb_extract_from_file(const char* path, const herb_extract_language_T language) {
-  char* source = herb_read_file(path);
-  char* output = herb_extract(source, language);
+  herb_mapped_file_T file = herb_map_file(path);
+  char* output = herb_extract_with_length(file.data, file.length, language);
 
-  free(source);
+  herb_unmap_file(&file);
 
   return output;
 }
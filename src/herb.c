@@ -4,19 +4,36 @@
 #include "include/lexer.h"
 #include "include/parser.h"
 #include "include/token.h"
+#include "include/macros.h"
+#include "include/parse_stats.h"
+#include "include/util/hb_arena.h"
 #include "include/util/hb_array.h"
 #include "include/util/hb_buffer.h"
 #include "include/version.h"
+#include "include/visitor.h"
 
 #include <prism.h>
 #include <stdlib.h>
+#include <string.h>
 
-HERB_EXPORTED_FUNCTION hb_array_T* herb_lex(const char* source) {
+static size_t herb_source_length(const char* source) {
+  return source != NULL ? strlen(source) : 0;
+}
+
+// Lexing ends at the first NUL byte, so the `_with_length` variants cut `source` there before handing it to the
+// lexer. The C string variants already stop there and skip the scan.
+static size_t herb_source_length_before_nul(const char* source, size_t length) {
+  const char* nul = source != NULL ? memchr(source, '\0', length) : NULL;
+
+  return nul != NULL ? (size_t) (nul - source) : length;
+}
+
+static hb_array_T* herb_lex_source(const char* source, size_t length, hb_arena_T* allocator) {
   lexer_T lexer = { 0 };
-  lexer_init(&lexer, source);
+  lexer_init_arena(&lexer, source, length, allocator);
 
   token_T* token = NULL;
-  hb_array_T* tokens = hb_array_init(128);
+  hb_array_T* tokens = hb_array_init_arena(allocator, 128);
 
   while ((token = lexer_next_token(&lexer))->type != TOKEN_EOF) {
     hb_array_append(tokens, token);
@@ -27,51 +44,174 @@ HERB_EXPORTED_FUNCTION hb_array_T* herb_lex(const char* source) {
   return tokens;
 }
 
-HERB_EXPORTED_FUNCTION AST_DOCUMENT_NODE_T* herb_parse(const char* source, const parser_options_T* options) {
-  if (!source) { source = ""; }
+HERB_EXPORTED_FUNCTION hb_array_T* herb_lex(const char* source) {
+  return herb_lex_source(source, herb_source_length(source), NULL);
+}
+
+HERB_EXPORTED_FUNCTION hb_array_T* herb_lex_with_length(const char* source, size_t length) {
+  return herb_lex_source(source, herb_source_length_before_nul(source, length), NULL);
+}
+
+HERB_EXPORTED_FUNCTION hb_array_T* herb_lex_arena(const char* source, hb_arena_T* allocator) {
+  return herb_lex_source(source, herb_source_length(source), allocator);
+}
+
+HERB_EXPORTED_FUNCTION hb_array_T* herb_lex_arena_with_length(
+  const char* source,
+  size_t length,
+  hb_arena_T* allocator
+) {
+  return herb_lex_source(source, herb_source_length_before_nul(source, length), allocator);
+}
+
+static void herb_lex_each_source(const char* source, size_t length, herb_lex_callback_T callback, void* user_data) {
+  // Every token lives in a small scratch arena that is rewound after the callback returns,
+  // so lexing runs in constant memory regardless of the size of `source`.
+  hb_arena_T allocator;
+  if (!hb_arena_init(&allocator, KB(4))) { return; }
 
   lexer_T lexer = { 0 };
-  lexer_init(&lexer, source);
+  lexer_init_arena(&lexer, source, length, &allocator);
+
+  while (true) {
+    token_T* token = lexer_next_token(&lexer);
+    bool is_eof = token->type == TOKEN_EOF;
+    bool should_continue = callback(token, user_data);
+
+    hb_arena_reset(&allocator);
+
+    if (is_eof || !should_continue) { break; }
+  }
+
+  hb_arena_free(&allocator);
+}
+
+HERB_EXPORTED_FUNCTION void herb_lex_each(const char* source, herb_lex_callback_T callback, void* user_data) {
+  herb_lex_each_source(source, herb_source_length(source), callback, user_data);
+}
+
+HERB_EXPORTED_FUNCTION void herb_lex_each_with_length(
+  const char* source,
+  size_t length,
+  herb_lex_callback_T callback,
+  void* user_data
+) {
+  herb_lex_each_source(source, herb_source_length_before_nul(source, length), callback, user_data);
+}
+
+static bool herb_count_nodes(const AST_NODE_T* node, void* data) {
+  (*(size_t*) data)++;
+
+  return true;
+}
+
+static AST_DOCUMENT_NODE_T* herb_parse_source(
+  const char* source,
+  size_t length,
+  const parser_options_T* options,
+  hb_arena_T* allocator
+) {
+  if (!source) {
+    source = "";
+    length = 0;
+  }
+
+  lexer_T lexer = { 0 };
+  lexer_init_arena(&lexer, source, length, allocator);
   parser_T parser = { 0 };
 
   parser_options_T parser_options = HERB_DEFAULT_PARSER_OPTIONS;
 
   if (options != NULL) { parser_options = *options; }
 
+  herb_parse_stats_T* stats = parser_options.stats;
+  herb_parse_stats_T* previous_stats = herb_parse_stats_swap_current(stats);
+  size_t allocations_before = allocator != NULL ? allocator->allocation_count : 0;
+  uint64_t lex_before = stats != NULL ? stats->nanoseconds[HERB_PARSE_PHASE_LEX] : 0;
+  uint64_t start = stats != NULL ? herb_parse_stats_clock() : 0;
+
+  lexer.stats = stats;
   herb_parser_init(&parser, &lexer, parser_options);
 
   AST_DOCUMENT_NODE_T* document = herb_parser_parse(&parser);
 
   herb_parser_deinit(&parser);
 
-  if (parser_options.analyze) { herb_analyze_parse_tree(document, source, &parser_options); }
+  if (stats != NULL) {
+    uint64_t lex_time = stats->nanoseconds[HERB_PARSE_PHASE_LEX] - lex_before;
+    stats->nanoseconds[HERB_PARSE_PHASE_PARSE] += herb_parse_stats_clock() - start - lex_time;
+  }
+
+  if (parser_options.analyze) { herb_analyze_parse_tree(document, source, lexer.source.length, &parser_options); }
+
+  if (stats != NULL) {
+    herb_visit_node((AST_NODE_T*) document, herb_count_nodes, &stats->nodes);
+
+    if (allocator != NULL) { stats->allocations += allocator->allocation_count - allocations_before; }
+  }
+
+  herb_parse_stats_swap_current(previous_stats);
 
   return document;
 }
 
+HERB_EXPORTED_FUNCTION AST_DOCUMENT_NODE_T* herb_parse(const char* source, const parser_options_T* options) {
+  return herb_parse_source(source, herb_source_length(source), options, NULL);
+}
+
+HERB_EXPORTED_FUNCTION AST_DOCUMENT_NODE_T* herb_parse_with_length(
+  const char* source,
+  size_t length,
+  const parser_options_T* options
+) {
+  return herb_parse_source(source, herb_source_length_before_nul(source, length), options, NULL);
+}
+
+HERB_EXPORTED_FUNCTION AST_DOCUMENT_NODE_T* herb_parse_arena(
+  const char* source,
+  const parser_options_T* options,
+  hb_arena_T* allocator
+) {
+  return herb_parse_source(source, herb_source_length(source), options, allocator);
+}
+
+HERB_EXPORTED_FUNCTION AST_DOCUMENT_NODE_T* herb_parse_arena_with_length(
+  const char* source,
+  size_t length,
+  const parser_options_T* options,
+  hb_arena_T* allocator
+) {
+  return herb_parse_source(source, herb_source_length_before_nul(source, length), options, allocator);
+}
+
 HERB_EXPORTED_FUNCTION hb_array_T* herb_lex_file(const char* path) {
-  char* source = herb_read_file(path);
-  hb_array_T* tokens = herb_lex(source);
+  herb_mapped_file_T file = herb_map_file(path);
+  hb_array_T* tokens = herb_lex_with_length(file.data, file.length);
+
+  // The tokens are views into the file, so copy their values before unmapping it.
+  for (size_t i = 0; i < hb_array_size(tokens); i++) {
+    token_own_value(hb_array_get(tokens, i), NULL);
+  }
 
-  free(source);
+  herb_unmap_file(&file);
 
   return tokens;
 }
 
-HERB_EXPORTED_FUNCTION void herb_lex_to_buffer(const char* source, hb_buffer_T* output) {
-  hb_array_T* tokens = herb_lex(source);
+static bool herb_lex_to_buffer_callback(const token_T* token, void* user_data) {
+  hb_buffer_T* output = user_data;
 
-  for (size_t i = 0; i < hb_array_size(tokens); i++) {
-    token_T* token = hb_array_get(tokens, i);
+  hb_string_T type = token_to_string(token);
+  hb_buffer_append_string(output, type);
+  free(type.data);
 
-    hb_string_T type = token_to_string(token);
-    hb_buffer_append_string(output, type);
-    free(type.data);
+  hb_buffer_append(output, "\n");
 
-    hb_buffer_append(output, "\n");
-  }
+  return true;
+}
 
-  herb_free_tokens(&tokens);
+HERB_EXPORTED_FUNCTION void herb_lex_to_buffer(const char* source, hb_buffer_T* output) {
+  herb_lex_each(source, herb_lex_to_buffer_callback, output);
 }
 
 HERB_EXPORTED_FUNCTION void herb_free_tokens(hb_array_T** tokens) {
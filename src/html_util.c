@@ -5,190 +5,211 @@
 #include <ctype.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
-// https://developer.mozilla.org/en-US/docs/Glossary/Void_element
-bool is_void_element(hb_string_T tag_name) {
-  if (hb_string_is_empty(tag_name)) { return false; }
-
-  hb_string_T void_tags[14] = {
-    hb_string("area"),  hb_string("base"),   hb_string("br"),    hb_string("col"),  hb_string("embed"),
-    hb_string("hr"),    hb_string("img"),    hb_string("input"), hb_string("link"), hb_string("meta"),
-    hb_string("param"), hb_string("source"), hb_string("track"), hb_string("wbr"),
-  };
-
-  for (size_t i = 0; i < 14; i++) {
-    if (hb_string_equals_case_insensitive(tag_name, void_tags[i])) { return true; }
-  }
+#define HTML_TAG_BIT(tag) ((uint64_t) 1 << (tag))
+
+static const char* html_tag_names[HTML_TAG_COUNT] = {
+  [HTML_TAG_UNKNOWN] = "",
+  [HTML_TAG_ADDRESS] = "address",
+  [HTML_TAG_AREA] = "area",
+  [HTML_TAG_ARTICLE] = "article",
+  [HTML_TAG_ASIDE] = "aside",
+  [HTML_TAG_BASE] = "base",
+  [HTML_TAG_BLOCKQUOTE] = "blockquote",
+  [HTML_TAG_BODY] = "body",
+  [HTML_TAG_BR] = "br",
+  [HTML_TAG_COL] = "col",
+  [HTML_TAG_COLGROUP] = "colgroup",
+  [HTML_TAG_DATALIST] = "datalist",
+  [HTML_TAG_DD] = "dd",
+  [HTML_TAG_DETAILS] = "details",
+  [HTML_TAG_DIV] = "div",
+  [HTML_TAG_DL] = "dl",
+  [HTML_TAG_DT] = "dt",
+  [HTML_TAG_EMBED] = "embed",
+  [HTML_TAG_FIELDSET] = "fieldset",
+  [HTML_TAG_FIGCAPTION] = "figcaption",
+  [HTML_TAG_FIGURE] = "figure",
+  [HTML_TAG_FOOTER] = "footer",
+  [HTML_TAG_FORM] = "form",
+  [HTML_TAG_H1] = "h1",
+  [HTML_TAG_H2] = "h2",
+  [HTML_TAG_H3] = "h3",
+  [HTML_TAG_H4] = "h4",
+  [HTML_TAG_H5] = "h5",
+  [HTML_TAG_H6] = "h6",
+  [HTML_TAG_HEADER] = "header",
+  [HTML_TAG_HGROUP] = "hgroup",
+  [HTML_TAG_HR] = "hr",
+  [HTML_TAG_IMG] = "img",
+  [HTML_TAG_INPUT] = "input",
+  [HTML_TAG_LI] = "li",
+  [HTML_TAG_LINK] = "link",
+  [HTML_TAG_MAIN] = "main",
+  [HTML_TAG_MENU] = "menu",
+  [HTML_TAG_META] = "meta",
+  [HTML_TAG_NAV] = "nav",
+  [HTML_TAG_OL] = "ol",
+  [HTML_TAG_OPTGROUP] = "optgroup",
+  [HTML_TAG_OPTION] = "option",
+  [HTML_TAG_P] = "p",
+  [HTML_TAG_PARAM] = "param",
+  [HTML_TAG_PRE] = "pre",
+  [HTML_TAG_RP] = "rp",
+  [HTML_TAG_RT] = "rt",
+  [HTML_TAG_RUBY] = "ruby",
+  [HTML_TAG_SECTION] = "section",
+  [HTML_TAG_SELECT] = "select",
+  [HTML_TAG_SOURCE] = "source",
+  [HTML_TAG_TABLE] = "table",
+  [HTML_TAG_TBODY] = "tbody",
+  [HTML_TAG_TD] = "td",
+  [HTML_TAG_TEMPLATE] = "template",
+  [HTML_TAG_TFOOT] = "tfoot",
+  [HTML_TAG_TH] = "th",
+  [HTML_TAG_THEAD] = "thead",
+  [HTML_TAG_TR] = "tr",
+  [HTML_TAG_TRACK] = "track",
+  [HTML_TAG_UL] = "ul",
+  [HTML_TAG_WBR] = "wbr",
+};
 
-  return false;
-}
+// https://developer.mozilla.org/en-US/docs/Glossary/Void_element
+static const uint64_t html_void_tags =
+  HTML_TAG_BIT(HTML_TAG_AREA) | HTML_TAG_BIT(HTML_TAG_BASE) | HTML_TAG_BIT(HTML_TAG_BR)
+  | HTML_TAG_BIT(HTML_TAG_COL) | HTML_TAG_BIT(HTML_TAG_EMBED) | HTML_TAG_BIT(HTML_TAG_HR)
+  | HTML_TAG_BIT(HTML_TAG_IMG) | HTML_TAG_BIT(HTML_TAG_INPUT) | HTML_TAG_BIT(HTML_TAG_LINK)
+  | HTML_TAG_BIT(HTML_TAG_META) | HTML_TAG_BIT(HTML_TAG_PARAM) | HTML_TAG_BIT(HTML_TAG_SOURCE)
+  | HTML_TAG_BIT(HTML_TAG_TRACK) | HTML_TAG_BIT(HTML_TAG_WBR);
 
 // https://html.spec.whatwg.org/multipage/syntax.html#optional-tags
-bool has_optional_end_tag(hb_string_T tag_name) {
-  if (hb_string_is_empty(tag_name)) { return false; }
-
-  hb_string_T optional_end_tags[15] = {
-    hb_string("li"),    hb_string("dt"),       hb_string("dd"),     hb_string("p"),     hb_string("rt"),
-    hb_string("rp"),    hb_string("optgroup"), hb_string("option"), hb_string("thead"), hb_string("tbody"),
-    hb_string("tfoot"), hb_string("tr"),       hb_string("td"),     hb_string("th"),    hb_string("colgroup"),
-  };
-
-  for (size_t i = 0; i < 15; i++) {
-    if (hb_string_equals_case_insensitive(tag_name, optional_end_tags[i])) { return true; }
+static const uint64_t html_optional_end_tags =
+  HTML_TAG_BIT(HTML_TAG_LI) | HTML_TAG_BIT(HTML_TAG_DT) | HTML_TAG_BIT(HTML_TAG_DD) | HTML_TAG_BIT(HTML_TAG_P)
+  | HTML_TAG_BIT(HTML_TAG_RT) | HTML_TAG_BIT(HTML_TAG_RP) | HTML_TAG_BIT(HTML_TAG_OPTGROUP)
+  | HTML_TAG_BIT(HTML_TAG_OPTION) | HTML_TAG_BIT(HTML_TAG_THEAD) | HTML_TAG_BIT(HTML_TAG_TBODY)
+  | HTML_TAG_BIT(HTML_TAG_TFOOT) | HTML_TAG_BIT(HTML_TAG_TR) | HTML_TAG_BIT(HTML_TAG_TD)
+  | HTML_TAG_BIT(HTML_TAG_TH) | HTML_TAG_BIT(HTML_TAG_COLGROUP);
+
+// The tags whose opening implicitly closes the indexed tag.
+static const uint64_t html_implicit_closers[HTML_TAG_COUNT] = {
+  [HTML_TAG_LI] = HTML_TAG_BIT(HTML_TAG_LI),
+  [HTML_TAG_DT] = HTML_TAG_BIT(HTML_TAG_DT) | HTML_TAG_BIT(HTML_TAG_DD),
+  [HTML_TAG_DD] = HTML_TAG_BIT(HTML_TAG_DD) | HTML_TAG_BIT(HTML_TAG_DT),
+  [HTML_TAG_P] = HTML_TAG_BIT(HTML_TAG_ADDRESS) | HTML_TAG_BIT(HTML_TAG_ARTICLE) | HTML_TAG_BIT(HTML_TAG_ASIDE)
+    | HTML_TAG_BIT(HTML_TAG_BLOCKQUOTE) | HTML_TAG_BIT(HTML_TAG_DETAILS) | HTML_TAG_BIT(HTML_TAG_DIV)
+    | HTML_TAG_BIT(HTML_TAG_DL) | HTML_TAG_BIT(HTML_TAG_FIELDSET) | HTML_TAG_BIT(HTML_TAG_FIGCAPTION)
+    | HTML_TAG_BIT(HTML_TAG_FIGURE) | HTML_TAG_BIT(HTML_TAG_FOOTER) | HTML_TAG_BIT(HTML_TAG_FORM)
+    | HTML_TAG_BIT(HTML_TAG_H1) | HTML_TAG_BIT(HTML_TAG_H2) | HTML_TAG_BIT(HTML_TAG_H3)
+    | HTML_TAG_BIT(HTML_TAG_H4) | HTML_TAG_BIT(HTML_TAG_H5) | HTML_TAG_BIT(HTML_TAG_H6)
+    | HTML_TAG_BIT(HTML_TAG_HEADER) | HTML_TAG_BIT(HTML_TAG_HGROUP) | HTML_TAG_BIT(HTML_TAG_HR)
+    | HTML_TAG_BIT(HTML_TAG_MAIN) | HTML_TAG_BIT(HTML_TAG_MENU) | HTML_TAG_BIT(HTML_TAG_NAV)
+    | HTML_TAG_BIT(HTML_TAG_OL) | HTML_TAG_BIT(HTML_TAG_P) | HTML_TAG_BIT(HTML_TAG_PRE)
+    | HTML_TAG_BIT(HTML_TAG_SECTION) | HTML_TAG_BIT(HTML_TAG_TABLE) | HTML_TAG_BIT(HTML_TAG_UL),
+  [HTML_TAG_RT] = HTML_TAG_BIT(HTML_TAG_RT) | HTML_TAG_BIT(HTML_TAG_RP),
+  [HTML_TAG_RP] = HTML_TAG_BIT(HTML_TAG_RP) | HTML_TAG_BIT(HTML_TAG_RT),
+  [HTML_TAG_OPTGROUP] = HTML_TAG_BIT(HTML_TAG_OPTGROUP),
+  [HTML_TAG_OPTION] = HTML_TAG_BIT(HTML_TAG_OPTION) | HTML_TAG_BIT(HTML_TAG_OPTGROUP),
+  [HTML_TAG_THEAD] = HTML_TAG_BIT(HTML_TAG_TBODY) | HTML_TAG_BIT(HTML_TAG_TFOOT),
+  [HTML_TAG_TBODY] = HTML_TAG_BIT(HTML_TAG_TBODY) | HTML_TAG_BIT(HTML_TAG_TFOOT),
+  [HTML_TAG_TR] = HTML_TAG_BIT(HTML_TAG_TR),
+  [HTML_TAG_TD] = HTML_TAG_BIT(HTML_TAG_TD) | HTML_TAG_BIT(HTML_TAG_TH),
+  [HTML_TAG_TH] = HTML_TAG_BIT(HTML_TAG_TH) | HTML_TAG_BIT(HTML_TAG_TD),
+  [HTML_TAG_COLGROUP] = ~HTML_TAG_BIT(HTML_TAG_COL),
+};
+
+// The tags whose closing tag implicitly closes the indexed tag.
+static const uint64_t html_parent_closers[HTML_TAG_COUNT] = {
+  [HTML_TAG_LI] = HTML_TAG_BIT(HTML_TAG_UL) | HTML_TAG_BIT(HTML_TAG_OL) | HTML_TAG_BIT(HTML_TAG_MENU),
+  [HTML_TAG_DT] = HTML_TAG_BIT(HTML_TAG_DL),
+  [HTML_TAG_DD] = HTML_TAG_BIT(HTML_TAG_DL),
+  [HTML_TAG_P] = HTML_TAG_BIT(HTML_TAG_ARTICLE) | HTML_TAG_BIT(HTML_TAG_ASIDE) | HTML_TAG_BIT(HTML_TAG_BLOCKQUOTE)
+    | HTML_TAG_BIT(HTML_TAG_BODY) | HTML_TAG_BIT(HTML_TAG_DETAILS) | HTML_TAG_BIT(HTML_TAG_DIV)
+    | HTML_TAG_BIT(HTML_TAG_FIELDSET) | HTML_TAG_BIT(HTML_TAG_FIGCAPTION) | HTML_TAG_BIT(HTML_TAG_FIGURE)
+    | HTML_TAG_BIT(HTML_TAG_FOOTER) | HTML_TAG_BIT(HTML_TAG_FORM) | HTML_TAG_BIT(HTML_TAG_HEADER)
+    | HTML_TAG_BIT(HTML_TAG_MAIN) | HTML_TAG_BIT(HTML_TAG_NAV) | HTML_TAG_BIT(HTML_TAG_SECTION)
+    | HTML_TAG_BIT(HTML_TAG_TD) | HTML_TAG_BIT(HTML_TAG_TH) | HTML_TAG_BIT(HTML_TAG_LI)
+    | HTML_TAG_BIT(HTML_TAG_DD) | HTML_TAG_BIT(HTML_TAG_TEMPLATE),
+  [HTML_TAG_RT] = HTML_TAG_BIT(HTML_TAG_RUBY),
+  [HTML_TAG_RP] = HTML_TAG_BIT(HTML_TAG_RUBY),
+  [HTML_TAG_OPTGROUP] = HTML_TAG_BIT(HTML_TAG_SELECT) | HTML_TAG_BIT(HTML_TAG_DATALIST),
+  [HTML_TAG_OPTION] = HTML_TAG_BIT(HTML_TAG_SELECT) | HTML_TAG_BIT(HTML_TAG_DATALIST),
+  [HTML_TAG_THEAD] = HTML_TAG_BIT(HTML_TAG_TABLE),
+  [HTML_TAG_TBODY] = HTML_TAG_BIT(HTML_TAG_TABLE),
+  [HTML_TAG_TFOOT] = HTML_TAG_BIT(HTML_TAG_TABLE),
+  [HTML_TAG_TR] = HTML_TAG_BIT(HTML_TAG_THEAD) | HTML_TAG_BIT(HTML_TAG_TBODY) | HTML_TAG_BIT(HTML_TAG_TFOOT)
+    | HTML_TAG_BIT(HTML_TAG_TABLE),
+  [HTML_TAG_TD] = HTML_TAG_BIT(HTML_TAG_TR),
+  [HTML_TAG_TH] = HTML_TAG_BIT(HTML_TAG_TR),
+  [HTML_TAG_COLGROUP] = HTML_TAG_BIT(HTML_TAG_TABLE),
+};
+
+static int html_tag_name_compare(hb_string_T tag_name, const char* known_name) {
+  size_t known_length = strlen(known_name);
+  size_t length = tag_name.length < known_length ? tag_name.length : known_length;
+
+  for (size_t i = 0; i < length; i++) {
+    int difference = tolower((unsigned char) tag_name.data[i]) - (unsigned char) known_name[i];
+    if (difference != 0) { return difference; }
   }
 
-  return false;
+  return (tag_name.length > known_length) - (tag_name.length < known_length);
 }
 
-static bool tag_in_list(hb_string_T tag_name, hb_string_T* list, size_t count) {
-  for (size_t i = 0; i < count; i++) {
-    if (hb_string_equals_case_insensitive(tag_name, list[i])) { return true; }
-  }
-
-  return false;
-}
+html_tag_T html_tag_from_name(hb_string_T tag_name) {
+  if (hb_string_is_empty(tag_name)) { return HTML_TAG_UNKNOWN; }
 
-bool should_implicitly_close(hb_string_T open_tag_name, hb_string_T next_tag_name) {
-  if (hb_string_is_empty(open_tag_name)) { return false; }
+  size_t low = HTML_TAG_UNKNOWN + 1;
+  size_t high = HTML_TAG_COUNT;
 
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("li"))) {
-    return hb_string_equals_case_insensitive(next_tag_name, hb_string("li"));
-  }
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    int comparison = html_tag_name_compare(tag_name, html_tag_names[middle]);
 
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("dt"))) {
-    return hb_string_equals_case_insensitive(next_tag_name, hb_string("dt"))
-        || hb_string_equals_case_insensitive(next_tag_name, hb_string("dd"));
-  }
+    if (comparison == 0) { return (html_tag_T) middle; }
 
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("dd"))) {
-    return hb_string_equals_case_insensitive(next_tag_name, hb_string("dd"))
-        || hb_string_equals_case_insensitive(next_tag_name, hb_string("dt"));
+    if (comparison < 0) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
   }
 
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("p"))) {
-    hb_string_T p_closers[30] = {
-      hb_string("address"), hb_string("article"), hb_string("aside"),    hb_string("blockquote"), hb_string("details"),
-      hb_string("div"),     hb_string("dl"),      hb_string("fieldset"), hb_string("figcaption"), hb_string("figure"),
-      hb_string("footer"),  hb_string("form"),    hb_string("h1"),       hb_string("h2"),         hb_string("h3"),
-      hb_string("h4"),      hb_string("h5"),      hb_string("h6"),       hb_string("header"),     hb_string("hgroup"),
-      hb_string("hr"),      hb_string("main"),    hb_string("menu"),     hb_string("nav"),        hb_string("ol"),
-      hb_string("p"),       hb_string("pre"),     hb_string("section"),  hb_string("table"),      hb_string("ul"),
-    };
-
-    return tag_in_list(next_tag_name, p_closers, 30);
-  }
-
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("rt"))) {
-    return hb_string_equals_case_insensitive(next_tag_name, hb_string("rt"))
-        || hb_string_equals_case_insensitive(next_tag_name, hb_string("rp"));
-  }
-
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("rp"))) {
-    return hb_string_equals_case_insensitive(next_tag_name, hb_string("rp"))
-        || hb_string_equals_case_insensitive(next_tag_name, hb_string("rt"));
-  }
-
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("optgroup"))) {
-    return hb_string_equals_case_insensitive(next_tag_name, hb_string("optgroup"));
-  }
-
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("option"))) {
-    return hb_string_equals_case_insensitive(next_tag_name, hb_string("option"))
-        || hb_string_equals_case_insensitive(next_tag_name, hb_string("optgroup"));
-  }
+  return HTML_TAG_UNKNOWN;
+}
 
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("thead"))) {
-    return hb_string_equals_case_insensitive(next_tag_name, hb_string("tbody"))
-        || hb_string_equals_case_insensitive(next_tag_name, hb_string("tfoot"));
-  }
+bool html_tag_is_void(html_tag_T tag) {
+  return tag != HTML_TAG_UNKNOWN && (html_void_tags & HTML_TAG_BIT(tag)) != 0;
+}
 
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("tbody"))) {
-    return hb_string_equals_case_insensitive(next_tag_name, hb_string("tbody"))
-        || hb_string_equals_case_insensitive(next_tag_name, hb_string("tfoot"));
-  }
+bool html_tag_has_optional_end(html_tag_T tag) {
+  return tag != HTML_TAG_UNKNOWN && (html_optional_end_tags & HTML_TAG_BIT(tag)) != 0;
+}
 
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("tr"))) {
-    return hb_string_equals_case_insensitive(next_tag_name, hb_string("tr"));
-  }
+bool html_tag_implicitly_closed_by(html_tag_T open_tag, html_tag_T next_tag) {
+  return (html_implicit_closers[open_tag] & HTML_TAG_BIT(next_tag)) != 0;
+}
 
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("td"))) {
-    return hb_string_equals_case_insensitive(next_tag_name, hb_string("td"))
-        || hb_string_equals_case_insensitive(next_tag_name, hb_string("th"));
-  }
+bool html_tag_closed_by_parent(html_tag_T open_tag, html_tag_T parent_close_tag) {
+  return (html_parent_closers[open_tag] & HTML_TAG_BIT(parent_close_tag)) != 0;
+}
 
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("th"))) {
-    return hb_string_equals_case_insensitive(next_tag_name, hb_string("th"))
-        || hb_string_equals_case_insensitive(next_tag_name, hb_string("td"));
-  }
+bool is_void_element(hb_string_T tag_name) {
+  return html_tag_is_void(html_tag_from_name(tag_name));
+}
 
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("colgroup"))) {
-    return !hb_string_equals_case_insensitive(next_tag_name, hb_string("col"));
-  }
+bool has_optional_end_tag(hb_string_T tag_name) {
+  return html_tag_has_optional_end(html_tag_from_name(tag_name));
+}
 
-  return false;
+bool should_implicitly_close(hb_string_T open_tag_name, hb_string_T next_tag_name) {
+  return html_tag_implicitly_closed_by(html_tag_from_name(open_tag_name), html_tag_from_name(next_tag_name));
 }
 
 bool parent_closes_element(hb_string_T open_tag_name, hb_string_T parent_close_tag_name) {
-  if (hb_string_is_empty(open_tag_name)) { return false; }
-
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("li"))) {
-    return hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("ul"))
-        || hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("ol"))
-        || hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("menu"));
-  }
-
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("dt"))
-      || hb_string_equals_case_insensitive(open_tag_name, hb_string("dd"))) {
-    return hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("dl"));
-  }
-
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("p"))) {
-    hb_string_T p_parent_closers[20] = {
-      hb_string("article"), hb_string("aside"),    hb_string("blockquote"), hb_string("body"),   hb_string("details"),
-      hb_string("div"),     hb_string("fieldset"), hb_string("figcaption"), hb_string("figure"), hb_string("footer"),
-      hb_string("form"),    hb_string("header"),   hb_string("main"),       hb_string("nav"),    hb_string("section"),
-      hb_string("td"),      hb_string("th"),       hb_string("li"),         hb_string("dd"),     hb_string("template"),
-    };
-
-    return tag_in_list(parent_close_tag_name, p_parent_closers, 20);
-  }
-
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("rt"))
-      || hb_string_equals_case_insensitive(open_tag_name, hb_string("rp"))) {
-    return hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("ruby"));
-  }
-
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("optgroup"))
-      || hb_string_equals_case_insensitive(open_tag_name, hb_string("option"))) {
-    return hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("select"))
-        || hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("datalist"));
-  }
-
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("thead"))
-      || hb_string_equals_case_insensitive(open_tag_name, hb_string("tbody"))
-      || hb_string_equals_case_insensitive(open_tag_name, hb_string("tfoot"))) {
-    return hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("table"));
-  }
-
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("tr"))) {
-    return hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("thead"))
-        || hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("tbody"))
-        || hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("tfoot"))
-        || hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("table"));
-  }
-
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("td"))
-      || hb_string_equals_case_insensitive(open_tag_name, hb_string("th"))) {
-    return hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("tr"));
-  }
-
-  if (hb_string_equals_case_insensitive(open_tag_name, hb_string("colgroup"))) {
-    return hb_string_equals_case_insensitive(parent_close_tag_name, hb_string("table"));
-  }
-
-  return false;
+  return html_tag_closed_by_parent(html_tag_from_name(open_tag_name), html_tag_from_name(parent_close_tag_name));
 }
 
 /**
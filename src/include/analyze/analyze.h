@@ -3,46 +3,54 @@
 
 #include "analyzed_ruby.h"
 #include "../ast_nodes.h"
+#include "../line_offsets.h"
 #include "../parser.h"
 #include "../util/hb_array.h"
+#include "../util/hb_buffer.h"
+
+#include <stdbool.h>
+#include <stddef.h>
 
 typedef struct ANALYZE_RUBY_CONTEXT_STRUCT {
   AST_DOCUMENT_NODE_T* document;
-  AST_NODE_T* parent;
-  hb_array_T* ruby_context_stack;
+  const parser_options_T* options;
+  size_t element_tag_depth;
 } analyze_ruby_context_T;
 
-typedef enum {
-  CONTROL_TYPE_IF,
-  CONTROL_TYPE_ELSIF,
-  CONTROL_TYPE_ELSE,
-  CONTROL_TYPE_END,
-  CONTROL_TYPE_CASE,
-  CONTROL_TYPE_CASE_MATCH,
-  CONTROL_TYPE_WHEN,
-  CONTROL_TYPE_IN,
-  CONTROL_TYPE_BEGIN,
-  CONTROL_TYPE_RESCUE,
-  CONTROL_TYPE_ENSURE,
-  CONTROL_TYPE_UNLESS,
-  CONTROL_TYPE_WHILE,
-  CONTROL_TYPE_UNTIL,
-  CONTROL_TYPE_FOR,
-  CONTROL_TYPE_BLOCK,
-  CONTROL_TYPE_BLOCK_CLOSE,
-  CONTROL_TYPE_YIELD,
-  CONTROL_TYPE_UNKNOWN
-} control_type_t;
+// A check run on the nodes of the second walk in herb_analyze_parse_tree(), next to the others. Returning false
+// from `enter` skips the node's children for this check only. `leave`, if set, runs after them.
+typedef struct ANALYZE_HOOK_STRUCT {
+  bool (*enter)(const AST_NODE_T* node, const AST_NODE_T* parent, void* data);
+  void (*leave)(const AST_NODE_T* node, const AST_NODE_T* parent, void* data);
+  void* data;
+} analyze_hook_T;
 
 typedef struct {
   int loop_depth;
   int rescue_depth;
 } invalid_erb_context_T;
 
-void herb_analyze_parse_errors(AST_DOCUMENT_NODE_T* document, const char* source);
-void herb_analyze_parse_tree(AST_DOCUMENT_NODE_T* document, const char* source, const parser_options_T* options);
+// The Ruby of the whole template, as herb_extract_ruby_with_semicolons() would produce it, but collected from
+// the ERB nodes the parser already built instead of lexing the source a second time.
+typedef struct {
+  line_offsets_T line_offsets;
+  hb_buffer_T scratch;
+  char* ruby;
+} parse_errors_context_T;
+
+bool herb_analyze_parse_errors_init(parse_errors_context_T* context, const char* source, size_t source_length);
+bool herb_analyze_parse_errors_collect(const AST_NODE_T* node, const AST_NODE_T* parent, void* data);
+void herb_analyze_parse_errors(AST_DOCUMENT_NODE_T* document, const char* source, parse_errors_context_T* context);
+
+void herb_analyze_parse_tree(
+  AST_DOCUMENT_NODE_T* document,
+  const char* source,
+  size_t source_length,
+  const parser_options_T* options
+);
 
 hb_array_T* rewrite_node_array(AST_NODE_T* node, hb_array_T* array, analyze_ruby_context_T* context);
+void transform_conditionals_in_array(const AST_NODE_T* node, hb_array_T* array, analyze_ruby_context_T* context);
 bool transform_erb_nodes(const AST_NODE_T* node, void* data);
 
 #endif
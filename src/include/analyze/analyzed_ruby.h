@@ -1,14 +1,38 @@
 #ifndef HERB_ANALYZED_RUBY_H
 #define HERB_ANALYZED_RUBY_H
 
-#include "../util/hb_array.h"
+#include "../util/hb_arena.h"
 #include "../util/hb_string.h"
 
-#include <prism.h>
+#include <stdbool.h>
+#include <stdint.h>
 
+typedef enum {
+  CONTROL_TYPE_IF,
+  CONTROL_TYPE_ELSIF,
+  CONTROL_TYPE_ELSE,
+  CONTROL_TYPE_END,
+  CONTROL_TYPE_CASE,
+  CONTROL_TYPE_CASE_MATCH,
+  CONTROL_TYPE_WHEN,
+  CONTROL_TYPE_IN,
+  CONTROL_TYPE_BEGIN,
+  CONTROL_TYPE_RESCUE,
+  CONTROL_TYPE_ENSURE,
+  CONTROL_TYPE_UNLESS,
+  CONTROL_TYPE_WHILE,
+  CONTROL_TYPE_UNTIL,
+  CONTROL_TYPE_FOR,
+  CONTROL_TYPE_BLOCK,
+  CONTROL_TYPE_BLOCK_CLOSE,
+  CONTROL_TYPE_YIELD,
+  CONTROL_TYPE_UNKNOWN
+} control_type_t;
+
+// The facts derived from parsing an ERB tag's Ruby code with Prism.
+// The Prism parser and tree are released as soon as these have been collected.
 typedef struct ANALYZED_RUBY_STRUCT {
-  pm_parser_t parser;
-  pm_node_t* root;
+  hb_arena_T* allocator;
   bool valid;
   bool parsed;
   int if_node_count;
@@ -31,9 +55,19 @@ typedef struct ANALYZED_RUBY_STRUCT {
   int yield_node_count;
   int then_keyword_count;
   int unclosed_control_flow_count;
+  bool unterminated_embedded_document;
+  bool unexpected_embedded_document_end;
+  bool invalid_break;
+  bool invalid_next;
+  bool invalid_redo;
+  bool invalid_retry;
+  bool has_then_keyword_location;
+  uint32_t then_keyword_start;
+  uint32_t then_keyword_end;
+  control_type_t earliest_control_type;
 } analyzed_ruby_T;
 
-analyzed_ruby_T* init_analyzed_ruby(hb_string_T source);
+analyzed_ruby_T* init_analyzed_ruby(hb_arena_T* allocator);
 void free_analyzed_ruby(analyzed_ruby_T* analyzed);
 const char* erb_keyword_from_analyzed_ruby(const analyzed_ruby_T* analyzed);
 
@@ -2,7 +2,10 @@
 #define HERB_ANALYZE_CONDITIONAL_ELEMENTS_H
 
 #include "../ast_nodes.h"
+#include "../util/hb_array.h"
 
-void herb_transform_conditional_elements(AST_DOCUMENT_NODE_T* document);
+// Turns `<% if %><div><% end %> ... <% if %></div><% end %>` in the array into conditional elements. The
+// arrays nested inside of it have to be transformed first.
+void herb_transform_conditional_elements_in_array(hb_array_T* nodes, hb_array_T* document_errors);
 
 #endif
@@ -2,7 +2,15 @@
 #define HERB_ANALYZE_CONDITIONAL_OPEN_TAGS_H
 
 #include "../ast_nodes.h"
+#include "../util/hb_array.h"
 
-void herb_transform_conditional_open_tags(AST_DOCUMENT_NODE_T* document);
+// Wraps an `<% if %>` that opens the same tag in every branch, and the close tag after it, into an element.
+// Expects the arrays nested inside of it to be transformed already, except for the branches of its `if` and
+// `unless` nodes, which it transforms first.
+void herb_transform_conditional_open_tags_in_array(hb_array_T* array, hb_array_T* document_errors);
+
+// Transforms only the branches of the `if` and `unless` nodes in the array, and the bodies of its conditional
+// elements, for arrays that aren't transformed themselves.
+void herb_transform_conditional_open_tags_in_branches(hb_array_T* array, hb_array_T* document_errors);
 
 #endif
@@ -4,9 +4,12 @@
 #include "analyze.h"
 #include "../ast_nodes.h"
 
+#include <prism.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 control_type_t detect_control_type(AST_ERB_CONTENT_NODE_T* erb_node);
+control_type_t find_earliest_control_keyword(const pm_node_t* root, const uint8_t* source_start);
 bool is_subsequent_type(control_type_t parent_type, control_type_t child_type);
 bool is_terminator_type(control_type_t parent_type, control_type_t child_type);
 bool is_compound_control_type(control_type_t type);
@@ -3,6 +3,7 @@
 
 #include <prism.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "analyzed_ruby.h"
 #include "../ast_node.h"
@@ -28,37 +29,27 @@ bool has_yield_node(analyzed_ruby_T* analyzed);
 bool has_then_keyword(analyzed_ruby_T* analyzed);
 bool has_inline_case_condition(analyzed_ruby_T* analyzed);
 
-bool has_error_message(analyzed_ruby_T* anlayzed, const char* message);
-
 bool is_do_block(pm_location_t opening_location);
 bool is_brace_block(pm_location_t opening_location);
 bool is_closing_brace(pm_location_t location);
 bool has_valid_block_closing(pm_location_t opening_loc, pm_location_t closing_loc);
 
-bool search_begin_nodes(const pm_node_t* node, void* data);
-bool search_block_nodes(const pm_node_t* node, void* data);
-bool search_case_match_nodes(const pm_node_t* node, void* data);
-bool search_case_nodes(const pm_node_t* node, void* data);
-bool search_for_nodes(const pm_node_t* node, void* data);
-bool search_if_nodes(const pm_node_t* node, void* data);
-bool search_in_nodes(const pm_node_t* node, void* data);
-bool search_then_keywords(const pm_node_t* node, void* data);
-bool search_unclosed_control_flows(const pm_node_t* node, void* data);
-bool search_unless_nodes(const pm_node_t* node, void* data);
-bool search_until_nodes(const pm_node_t* node, void* data);
-bool search_when_nodes(const pm_node_t* node, void* data);
-bool search_while_nodes(const pm_node_t* node, void* data);
-bool search_yield_nodes(const pm_node_t* node, void* data);
+typedef struct {
+  analyzed_ruby_T* analyzed;
+  const uint8_t* source_start;
+} ruby_search_context_T;
 
-bool search_unexpected_block_closing_nodes(analyzed_ruby_T* analyzed);
-bool search_unexpected_else_nodes(analyzed_ruby_T* analyzed);
-bool search_unexpected_elsif_nodes(analyzed_ruby_T* analyzed);
-bool search_unexpected_end_nodes(analyzed_ruby_T* analyzed);
-bool search_unexpected_ensure_nodes(analyzed_ruby_T* analyzed);
-bool search_unexpected_in_nodes(analyzed_ruby_T* analyzed);
-bool search_unexpected_rescue_nodes(analyzed_ruby_T* analyzed);
-bool search_unexpected_when_nodes(analyzed_ruby_T* analyzed);
+bool search_ruby_nodes(const pm_node_t* node, void* data);
+void search_ruby_errors(const pm_parser_t* parser, analyzed_ruby_T* analyzed);
 
 void check_erb_node_for_missing_end(const AST_NODE_T* node);
 
+// Fetches the `<%`, content and `%>` tokens of any ERB node; false for every other node type.
+bool erb_node_tag_tokens(
+  const AST_NODE_T* node,
+  const token_T** tag_opening,
+  const token_T** content,
+  const token_T** tag_closing
+);
+
 #endif
@@ -6,6 +6,7 @@
 
 #include <stdbool.h>
 
-bool detect_invalid_erb_structures(const AST_NODE_T* node, void* data);
+bool detect_invalid_erb_structures(const AST_NODE_T* node, const AST_NODE_T* parent, void* data);
+void detect_invalid_erb_structures_leave(const AST_NODE_T* node, const AST_NODE_T* parent, void* data);
 
 #endif
@@ -3,13 +3,40 @@
 
 #include "ast_nodes.h"
 #include "errors.h"
+#include "line_offsets.h"
 #include "position.h"
 #include "token_struct.h"
+#include "util/hb_string.h"
 
-void ast_node_init(AST_NODE_T* node, ast_node_type_T type, position_T start, position_T end, hb_array_T* errors);
+void* ast_node_allocate(size_t size, hb_arena_T* allocator);
+void ast_node_init(
+  AST_NODE_T* node,
+  ast_node_type_T type,
+  position_T start,
+  position_T end,
+  hb_array_T* errors,
+  hb_arena_T* allocator
+);
 void ast_node_free(AST_NODE_T* node);
 
-AST_LITERAL_NODE_T* ast_literal_node_init_from_token(const token_T* token);
+AST_LITERAL_NODE_T* ast_literal_node_init_from_token(const token_T* token, hb_arena_T* allocator);
+
+// Like the generated initializers, but `content` doesn't have to be null-terminated, so it can be a view into the
+// source. It's copied exactly once, into the allocator (or with malloc when there is none).
+AST_LITERAL_NODE_T* ast_literal_node_init_from_string(
+  hb_string_T content,
+  position_T start,
+  position_T end,
+  hb_array_T* errors,
+  hb_arena_T* allocator
+);
+AST_HTML_TEXT_NODE_T* ast_html_text_node_init_from_string(
+  hb_string_T content,
+  position_T start,
+  position_T end,
+  hb_array_T* errors,
+  hb_arena_T* allocator
+);
 
 size_t ast_node_sizeof(void);
 size_t ast_node_child_count(AST_NODE_T* node);
@@ -32,6 +59,10 @@ void ast_node_set_positions_from_token(AST_NODE_T* node, const token_T* token);
 
 bool ast_node_is(const AST_NODE_T* node, ast_node_type_T type);
 
-AST_NODE_T* find_erb_content_at_offset(AST_DOCUMENT_NODE_T* document, const char* source, size_t offset);
+AST_NODE_T* find_erb_content_at_offset(
+  AST_DOCUMENT_NODE_T* document,
+  const line_offsets_T* line_offsets,
+  size_t offset
+);
 
 #endif
@@ -0,0 +1,31 @@
+#ifndef HERB_AST_RELOCATE_H
+#define HERB_AST_RELOCATE_H
+
+#include "ast_node.h"
+#include "ast_nodes.h"
+#include "range.h"
+#include "util/hb_string.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Describes how to move a subtree from the source it was parsed from into another one.
+// Token values that view into `from_source` are rebased onto `to_source`, ranges move by `offset_delta`
+// and lines by `line_delta`. Columns only move (by `column_delta`) on `first_line`, as counted before the move.
+typedef struct {
+  hb_string_T from_source;
+  const char* to_source;
+  int64_t offset_delta;
+  int64_t line_delta;
+  uint32_t first_line;
+  int64_t column_delta;
+} ast_relocation_T;
+
+// Relocates `node` and everything it owns. Errors attached to the nodes are left as they are.
+// Tokens from an arena may be shared between nodes, so they are replaced by relocated copies in the same arena.
+void ast_node_relocate(AST_NODE_T* node, const ast_relocation_T* relocation);
+
+// Computes the byte range covered by the tokens of `node` and its descendants; false when it has no tokens.
+bool ast_node_source_range(const AST_NODE_T* node, range_T* range);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef HERB_AST_SERIALIZE_H
+#define HERB_AST_SERIALIZE_H
+
+#include "ast_nodes.h"
+#include "util/hb_buffer.h"
+#include "util/hb_string.h"
+
+#include <stdint.h>
+
+// Binary layout written by herb_serialize(), so a binding can take a whole document across the FFI boundary
+// as one flat buffer and decode it on its own terms. Bump HERB_SERIALIZE_VERSION whenever the layout changes,
+// which includes adding, removing or reordering node and error types or fields in config.yml.
+//
+// Integers are unsigned 32-bit little-endian unless noted otherwise.
+//
+//   document := "HERB" u32(version) u32(source length) node
+//   node     := u32(type) u32(byte length of the whole record) location errors field* | u32(NULL)
+//   error    := u32(type) location string(message) field*
+//   errors   := u32(count) error*
+//   array    := u32(count) node*
+//   token    := u32(type) string(value) u32(range from) u32(range to) location | u32(NULL)
+//   string   := u32(offset into the source) u32(length) | u32(INLINE) u32(length) byte* | u32(NULL)
+//   location := position(start) position(end)
+//   position := u32(line) u32(column)
+//   boolean  := u8
+//   size_t   := u64
+//
+// Fields follow in config.yml order. Location fields are a boolean followed by the location when it is set;
+// element sources are strings. Prism nodes, analyzed Ruby and other parser state are not written.
+// Node and error types are the values of ast_node_type_T and error_type_T.
+
+#define HERB_SERIALIZE_VERSION 1
+
+#define HERB_SERIALIZE_NULL UINT32_MAX
+#define HERB_SERIALIZE_INLINE (UINT32_MAX - 1)
+
+// Appends `node` and everything below it to `output`; string values viewing into `source` are written as offsets.
+void ast_serialize_node(const AST_NODE_T* node, hb_string_T source, hb_buffer_T* output);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef HERB_BENCH_H
+#define HERB_BENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+  size_t iterations;
+  bool json;
+} herb_bench_options_T;
+
+// Runs every benchmarked phase over `path` (a template, or a directory searched recursively for `.erb` files)
+// and prints throughput, latency percentiles, arena allocations and peak RSS to stdout.
+// Returns false, after printing why to stderr, when there is nothing to benchmark.
+bool herb_bench(const char* path, const herb_bench_options_T* options);
+
+#endif
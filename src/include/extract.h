@@ -1,9 +1,11 @@
 #ifndef HERB_EXTRACT_H
 #define HERB_EXTRACT_H
 
+#include "token_struct.h"
 #include "util/hb_buffer.h"
 
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef enum {
   HERB_EXTRACT_LANGUAGE_RUBY,
@@ -24,6 +26,26 @@ void herb_extract_ruby_to_buffer_with_options(
   const herb_extract_ruby_options_T* options
 );
 void herb_extract_ruby_to_buffer(const char* source, hb_buffer_T* output);
+
+// Like their C string counterparts, for `length` bytes of a `source` that doesn't need to be NUL-terminated.
+void herb_extract_ruby_to_buffer_with_length(
+  const char* source,
+  size_t length,
+  hb_buffer_T* output,
+  const herb_extract_ruby_options_T* options
+);
+void herb_extract_html_to_buffer_with_length(const char* source, size_t length, hb_buffer_T* output);
+char* herb_extract_with_length(const char* source, size_t length, herb_extract_language_T language);
+
+// Writes the Ruby of one already lexed ERB tag over `output` at the tag's own offsets, exactly as
+// herb_extract_ruby_to_buffer() would with the default options. `scratch` is reused between calls.
+void herb_extract_ruby_erb_tag(
+  const token_T* tag_opening,
+  const token_T* content,
+  const token_T* tag_closing,
+  hb_buffer_T* scratch,
+  char* output
+);
 void herb_extract_html_to_buffer(const char* source, hb_buffer_T* output);
 
 char* herb_extract_ruby_with_semicolons(const char* source);
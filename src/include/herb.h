@@ -4,10 +4,14 @@
 #include "ast_node.h"
 #include "extract.h"
 #include "macros.h"
+#include "parse_stats.h"
 #include "parser.h"
+#include "token_struct.h"
+#include "util/hb_arena.h"
 #include "util/hb_array.h"
 #include "util/hb_buffer.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -19,7 +23,140 @@ HERB_EXPORTED_FUNCTION void herb_lex_to_buffer(const char* source, hb_buffer_T*
 HERB_EXPORTED_FUNCTION hb_array_T* herb_lex(const char* source);
 HERB_EXPORTED_FUNCTION hb_array_T* herb_lex_file(const char* path);
 
+// The `_with_length` variants read `length` bytes of `source`, which doesn't need to be NUL-terminated, so
+// bindings can pass the buffers of host strings and mapped files without copying them. Lexing still ends at
+// the first NUL byte, like it does for the C string variants. Locations are 32-bit, so sources are read up to
+// UINT32_MAX bytes and anything after that is ignored.
+HERB_EXPORTED_FUNCTION hb_array_T* herb_lex_with_length(const char* source, size_t length);
+
+// Calls `callback` for every token up to and including TOKEN_EOF; returning false stops lexing early.
+// Tokens are only valid for the duration of the callback, so copy anything that needs to outlive it.
+typedef bool (*herb_lex_callback_T)(const token_T* token, void* user_data);
+HERB_EXPORTED_FUNCTION void herb_lex_each(const char* source, herb_lex_callback_T callback, void* user_data);
+HERB_EXPORTED_FUNCTION void herb_lex_each_with_length(
+  const char* source,
+  size_t length,
+  herb_lex_callback_T callback,
+  void* user_data
+);
+
 HERB_EXPORTED_FUNCTION AST_DOCUMENT_NODE_T* herb_parse(const char* source, const parser_options_T* options);
+HERB_EXPORTED_FUNCTION AST_DOCUMENT_NODE_T* herb_parse_with_length(
+  const char* source,
+  size_t length,
+  const parser_options_T* options
+);
+
+// Allocates tokens and nodes from `allocator` (malloc when NULL); release them with hb_arena_free().
+HERB_EXPORTED_FUNCTION hb_array_T* herb_lex_arena(const char* source, hb_arena_T* allocator);
+HERB_EXPORTED_FUNCTION hb_array_T* herb_lex_arena_with_length(
+  const char* source,
+  size_t length,
+  hb_arena_T* allocator
+);
+HERB_EXPORTED_FUNCTION AST_DOCUMENT_NODE_T* herb_parse_arena(
+  const char* source,
+  const parser_options_T* options,
+  hb_arena_T* allocator
+);
+HERB_EXPORTED_FUNCTION AST_DOCUMENT_NODE_T* herb_parse_arena_with_length(
+  const char* source,
+  size_t length,
+  const parser_options_T* options,
+  hb_arena_T* allocator
+);
+
+// Owns the arena documents are parsed into, so a worker parsing template after template keeps reusing the same
+// warm pages instead of going back to malloc for every token and node. herb_context_reset() releases every
+// document parsed since the previous reset at once; call it as soon as they are no longer needed.
+typedef struct HERB_CONTEXT_STRUCT {
+  hb_arena_T allocator;
+} herb_context_T;
+
+// Starts with an `arena_size` byte page (a default size when 0); the arena grows as needed and keeps its pages.
+HERB_EXPORTED_FUNCTION bool herb_context_init(herb_context_T* context, size_t arena_size);
+HERB_EXPORTED_FUNCTION AST_DOCUMENT_NODE_T* herb_context_parse(
+  herb_context_T* context,
+  const char* source,
+  size_t length,
+  const parser_options_T* options
+);
+HERB_EXPORTED_FUNCTION void herb_context_reset(herb_context_T* context);
+HERB_EXPORTED_FUNCTION void herb_context_free(herb_context_T* context);
+
+// A single text replacement, in bytes: `[start, old_end)` of the old source became `[start, new_end)` of the new one.
+typedef struct HERB_EDIT_STRUCT {
+  uint32_t start;
+  uint32_t old_end;
+  uint32_t new_end;
+} herb_edit_T;
+
+// Brings `document`, parsed from `old_source` with the same `options`, up to date with `new_source`.
+// Only the top-level nodes touched by `edit` are reparsed; the others keep their analysis and get new locations.
+// Falls back to a full parse whenever reuse can't be shown to match it, e.g. when either version has errors.
+// `document` is consumed and the returned one views into `new_source`, so `old_source` can be released.
+// For a document parsed with herb_parse_arena(), the new nodes come from the same arena and the replaced ones
+// can't be given back to it, so the arena grows with every reparse. Callers that keep reparsing, like an editor
+// session, should do a full parse into a fresh or reset arena from time to time, e.g. once it has doubled in size.
+HERB_EXPORTED_FUNCTION AST_DOCUMENT_NODE_T* herb_reparse(
+  AST_DOCUMENT_NODE_T* document,
+  const char* old_source,
+  const char* new_source,
+  const herb_edit_T* edit,
+  const parser_options_T* options
+);
+
+// Called once per path, from whichever worker thread parsed it, so it has to be thread-safe.
+// `source` and `document` are NULL when the file couldn't be read. Both are released once the callback
+// returns: the document lives in the worker's herb_context_T, which is reset before the next file.
+typedef void (*herb_parse_files_callback_T)(
+  size_t index,
+  const char* path,
+  const char* source,
+  AST_DOCUMENT_NODE_T* document,
+  void* user_data
+);
+
+// Parses `count` files on `threads` threads (one per online CPU when 0), the calling thread included.
+// Each thread parses into its own herb_context_T; returns after the callback has run for every path.
+// When `options` collect stats, all files are parsed on the calling thread and their stats are summed up.
+HERB_EXPORTED_FUNCTION void herb_parse_files(
+  const char* const* paths,
+  size_t count,
+  const parser_options_T* options,
+  size_t threads,
+  herb_parse_files_callback_T callback,
+  void* user_data
+);
+
+// Appends `document` to `output` in the binary layout described in ast_serialize.h. Token values are written as
+// offsets into `source`, which a binding already holds, so only strings that were copied while parsing are inlined.
+HERB_EXPORTED_FUNCTION void herb_serialize(AST_DOCUMENT_NODE_T* document, const char* source, hb_buffer_T* output);
+HERB_EXPORTED_FUNCTION void herb_serialize_with_length(
+  AST_DOCUMENT_NODE_T* document,
+  const char* source,
+  size_t length,
+  hb_buffer_T* output
+);
+
+// Appends the serialized document for `source` to `output`, like herb_parse() followed by herb_serialize().
+// When `cache_directory` is set, the result is stored there, keyed by a hash of the source, `options` and the
+// libherb, Prism and layout versions, and later calls with the same inputs read it back instead of parsing.
+// Returns true on a cache hit. The directory has to exist; if it can't be read or written, the call still parses.
+// Nothing is parsed on a hit, so `options->stats` is left untouched.
+HERB_EXPORTED_FUNCTION bool herb_parse_to_buffer_cached(
+  const char* source,
+  const parser_options_T* options,
+  const char* cache_directory,
+  hb_buffer_T* output
+);
+HERB_EXPORTED_FUNCTION bool herb_parse_to_buffer_cached_with_length(
+  const char* source,
+  size_t length,
+  const parser_options_T* options,
+  const char* cache_directory,
+  hb_buffer_T* output
+);
 
 HERB_EXPORTED_FUNCTION const char* herb_version(void);
 HERB_EXPORTED_FUNCTION const char* herb_prism_version(void);
@@ -4,6 +4,80 @@
 #include "util/hb_string.h"
 #include <stdbool.h>
 
+// Tag names the HTML helpers below know about, in alphabetical order. Every other name maps to HTML_TAG_UNKNOWN.
+typedef enum {
+  HTML_TAG_UNKNOWN = 0,
+  HTML_TAG_ADDRESS,
+  HTML_TAG_AREA,
+  HTML_TAG_ARTICLE,
+  HTML_TAG_ASIDE,
+  HTML_TAG_BASE,
+  HTML_TAG_BLOCKQUOTE,
+  HTML_TAG_BODY,
+  HTML_TAG_BR,
+  HTML_TAG_COL,
+  HTML_TAG_COLGROUP,
+  HTML_TAG_DATALIST,
+  HTML_TAG_DD,
+  HTML_TAG_DETAILS,
+  HTML_TAG_DIV,
+  HTML_TAG_DL,
+  HTML_TAG_DT,
+  HTML_TAG_EMBED,
+  HTML_TAG_FIELDSET,
+  HTML_TAG_FIGCAPTION,
+  HTML_TAG_FIGURE,
+  HTML_TAG_FOOTER,
+  HTML_TAG_FORM,
+  HTML_TAG_H1,
+  HTML_TAG_H2,
+  HTML_TAG_H3,
+  HTML_TAG_H4,
+  HTML_TAG_H5,
+  HTML_TAG_H6,
+  HTML_TAG_HEADER,
+  HTML_TAG_HGROUP,
+  HTML_TAG_HR,
+  HTML_TAG_IMG,
+  HTML_TAG_INPUT,
+  HTML_TAG_LI,
+  HTML_TAG_LINK,
+  HTML_TAG_MAIN,
+  HTML_TAG_MENU,
+  HTML_TAG_META,
+  HTML_TAG_NAV,
+  HTML_TAG_OL,
+  HTML_TAG_OPTGROUP,
+  HTML_TAG_OPTION,
+  HTML_TAG_P,
+  HTML_TAG_PARAM,
+  HTML_TAG_PRE,
+  HTML_TAG_RP,
+  HTML_TAG_RT,
+  HTML_TAG_RUBY,
+  HTML_TAG_SECTION,
+  HTML_TAG_SELECT,
+  HTML_TAG_SOURCE,
+  HTML_TAG_TABLE,
+  HTML_TAG_TBODY,
+  HTML_TAG_TD,
+  HTML_TAG_TEMPLATE,
+  HTML_TAG_TFOOT,
+  HTML_TAG_TH,
+  HTML_TAG_THEAD,
+  HTML_TAG_TR,
+  HTML_TAG_TRACK,
+  HTML_TAG_UL,
+  HTML_TAG_WBR,
+  HTML_TAG_COUNT
+} html_tag_T;
+
+html_tag_T html_tag_from_name(hb_string_T tag_name);
+bool html_tag_is_void(html_tag_T tag);
+bool html_tag_has_optional_end(html_tag_T tag);
+bool html_tag_implicitly_closed_by(html_tag_T open_tag, html_tag_T next_tag);
+bool html_tag_closed_by_parent(html_tag_T open_tag, html_tag_T parent_close_tag);
+
 bool is_void_element(hb_string_T tag_name);
 bool has_optional_end_tag(hb_string_T tag_name);
 bool should_implicitly_close(hb_string_T open_tag_name, hb_string_T next_tag_name);
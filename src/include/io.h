@@ -1,9 +1,30 @@
 #ifndef HERB_IO_H
 #define HERB_IO_H
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 char* herb_read_file(const char* filename);
 
+// Like herb_read_file(), but returns NULL instead of exiting when the file can't be read. When `length` isn't
+// NULL it receives the number of bytes read, which also counts any NUL bytes in the file.
+char* herb_try_read_file(const char* filename, size_t* length);
+
+// The contents of a file, memory-mapped when possible so nothing is copied. `data` is NUL-terminated either way:
+// files are only mapped when their size isn't a multiple of the page size, as the rest of the last page is zeroed.
+typedef struct HERB_MAPPED_FILE_STRUCT {
+  const char* data;
+  size_t length;
+  size_t mapped_length;
+} herb_mapped_file_T;
+
+// Like herb_read_file(), but maps the file instead of reading it. Release it with herb_unmap_file().
+herb_mapped_file_T herb_map_file(const char* filename);
+
+// Like herb_map_file(), but returns false instead of exiting when the file can't be read.
+bool herb_try_map_file(const char* filename, herb_mapped_file_T* file);
+
+void herb_unmap_file(herb_mapped_file_T* file);
+
 #endif
@@ -5,7 +5,15 @@
 #include "token_struct.h"
 
 void lexer_init(lexer_T* lexer, const char* source);
+// `source` doesn't need to be NUL-terminated; lexing stops after `length` bytes or at the first NUL byte.
+void lexer_init_with_length(lexer_T* lexer, const char* source, size_t length);
+// Unlike lexer_init_with_length(), trusts that `source` has no NUL byte in its first `length` bytes.
+void lexer_init_arena(lexer_T* lexer, const char* source, size_t length, hb_arena_T* allocator);
 token_T* lexer_next_token(lexer_T* lexer);
+
+// Advances past the next token like lexer_next_token() but without allocating it. The token lives in `lexer`
+// and is overwritten by the next scan, so this is meant for lookahead on a copy of the parser's lexer.
+const token_T* lexer_scan_token(lexer_T* lexer);
 token_T* lexer_error(lexer_T* lexer, const char* message);
 
 #endif
@@ -20,6 +20,11 @@ typedef struct {
   lexer_state_T state;
 } lexer_state_snapshot_T;
 
+// Reads past the end of the source as '\0', like the terminator of a C string, so sources don't need one.
+static inline char lexer_char_at(const lexer_T* lexer, uint32_t position) {
+  return position < lexer->source.length ? lexer->source.data[position] : '\0';
+}
+
 char lexer_peek(const lexer_T* lexer, uint32_t offset);
 bool lexer_peek_for_doctype(const lexer_T* lexer, uint32_t offset);
 bool lexer_peek_for_xml_declaration(const lexer_T* lexer, uint32_t offset);
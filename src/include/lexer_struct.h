@@ -1,6 +1,9 @@
 #ifndef HERB_LEXER_STRUCT_H
 #define HERB_LEXER_STRUCT_H
 
+#include "parse_stats.h"
+#include "token_struct.h"
+#include "util/hb_arena.h"
 #include "util/hb_string.h"
 
 #include <stdbool.h>
@@ -15,6 +18,7 @@ typedef enum {
 
 typedef struct LEXER_STRUCT {
   hb_string_T source;
+  hb_arena_T* allocator;
 
   uint32_t current_line;
   uint32_t current_column;
@@ -29,6 +33,13 @@ typedef struct LEXER_STRUCT {
   uint32_t stall_counter;
   uint32_t last_position;
   bool stalled;
+
+  // Set while lexer_scan_token() runs, so the token is built in `scan_token` instead of being allocated.
+  bool scanning;
+  token_T scan_token;
+
+  // Set while parsing with stats, so lexer_next_token() times itself.
+  herb_parse_stats_T* stats;
 } lexer_T;
 
 #endif
@@ -0,0 +1,30 @@
+#ifndef HERB_LINE_OFFSETS_H
+#define HERB_LINE_OFFSETS_H
+
+#include "macros.h"
+#include "position.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Byte offset at which every line of a source starts, so offsets and positions convert in O(log n).
+// Lines are split the same way as position_from_source_with_offset() splits them: on every '\n' and '\r'.
+typedef struct LINE_OFFSETS_STRUCT {
+  uint32_t* starts;
+  size_t count;
+  size_t source_length;
+} line_offsets_T;
+
+HERB_EXPORTED_FUNCTION bool line_offsets_init(line_offsets_T* line_offsets, const char* source, size_t length);
+HERB_EXPORTED_FUNCTION void line_offsets_free(line_offsets_T* line_offsets);
+
+HERB_EXPORTED_FUNCTION size_t line_offsets_line_count(const line_offsets_T* line_offsets);
+
+// Offsets past the end of the source are clamped to it.
+HERB_EXPORTED_FUNCTION position_T line_offsets_position(const line_offsets_T* line_offsets, size_t offset);
+
+// Columns past the end of their line are clamped to it, lines past the last one to the end of the source.
+HERB_EXPORTED_FUNCTION size_t line_offsets_offset(const line_offsets_T* line_offsets, position_T position);
+
+#endif
@@ -17,6 +17,12 @@
 
 #define MB(mb) (1024 * KB(mb))
 
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#  define HERB_THREAD_LOCAL _Thread_local
+#else
+#  define HERB_THREAD_LOCAL __thread
+#endif
+
 #define unlikely(x) __builtin_expect(!!(x), 0)
 
 #endif
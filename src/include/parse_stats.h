@@ -0,0 +1,41 @@
+#ifndef HERB_PARSE_STATS_H
+#define HERB_PARSE_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+  HERB_PARSE_PHASE_LEX,
+  HERB_PARSE_PHASE_PARSE,
+  HERB_PARSE_PHASE_TRANSFORM,
+  HERB_PARSE_PHASE_MATCH_TAGS,
+  HERB_PARSE_PHASE_PARSE_ERRORS,
+  HERB_PARSE_PHASE_COUNT,
+} herb_parse_phase_T;
+
+// Filled in by herb_parse() and friends when `parser_options_T.stats` points to one. Values are added to what
+// the struct already holds, so zero it first, or keep it around to sum up several parses.
+//
+// Lexing happens on demand while parsing, so the lex phase is the time spent inside the lexer and the parse
+// phase excludes it. The transform phase is the walk that analyzes the Ruby in ERB tags and builds control flow
+// and conditional elements. The match tags phase is the walk after it, which also checks for invalid structures
+// and collects the Ruby for the parse errors phase. `tokens` includes the tokens lexed while looking ahead.
+// `allocations` are only counted when parsing into an arena.
+typedef struct HERB_PARSE_STATS_STRUCT {
+  uint64_t nanoseconds[HERB_PARSE_PHASE_COUNT];
+  size_t tokens;
+  size_t nodes;
+  size_t prism_parses;
+  size_t allocations;
+} herb_parse_stats_T;
+
+const char* herb_parse_phase_name(herb_parse_phase_T phase);
+
+uint64_t herb_parse_stats_clock(void);
+
+// Stats of the parse running on the current thread, so Prism parses deep in the analysis can be counted
+// without passing the options down. Returns the previous value.
+herb_parse_stats_T* herb_parse_stats_swap_current(herb_parse_stats_T* stats);
+void herb_parse_stats_count_prism_parse(void);
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "ast_node.h"
 #include "lexer.h"
+#include "parse_stats.h"
 #include "util/hb_array.h"
 
 typedef enum {
@@ -19,10 +20,10 @@ typedef struct PARSER_OPTIONS_STRUCT {
   bool track_whitespace;
   bool analyze;
   bool strict;
+  herb_parse_stats_T* stats;
 } parser_options_T;
 
 typedef struct MATCH_TAGS_CONTEXT_STRUCT {
-  hb_array_T* errors;
   const parser_options_T* options;
 } match_tags_context_T;
 
@@ -30,6 +31,7 @@ extern const parser_options_T HERB_DEFAULT_PARSER_OPTIONS;
 
 typedef struct PARSER_STRUCT {
   lexer_T* lexer;
+  hb_arena_T* allocator;
   token_T* current_token;
   hb_array_T* open_tags_stack;
   parser_state_T state;
@@ -45,10 +47,9 @@ void herb_parser_init(parser_T* parser, lexer_T* lexer, parser_options_T options
 
 AST_DOCUMENT_NODE_T* herb_parser_parse(parser_T* parser);
 
-void herb_parser_match_html_tags_post_analyze(AST_DOCUMENT_NODE_T* document, const parser_options_T* options);
 void herb_parser_deinit(parser_T* parser);
 
-void match_tags_in_node_array(hb_array_T* nodes, hb_array_T* errors, const parser_options_T* options);
-bool match_tags_visitor(const AST_NODE_T* node, void* data);
+void match_tags_in_node_array(hb_array_T* nodes, const parser_options_T* options);
+bool match_tags_visitor(const AST_NODE_T* node, const AST_NODE_T* parent, void* data);
 
 #endif
@@ -31,9 +31,25 @@ void parser_append_unexpected_error_string(
 );
 void parser_append_unexpected_token_error(parser_T* parser, token_type_T expected_type, hb_array_T* errors);
 
-void parser_append_literal_node_from_buffer(
+// Collects the values of consecutive tokens. Lexed tokens are views that follow each other in the source, so the
+// text stays a view into it and is only copied into `buffer` once a token doesn't continue where the last one ended
+// or owns its value.
+typedef struct {
+  hb_string_T view;
+  hb_buffer_T buffer;
+  bool buffered;
+} parser_text_T;
+
+void parser_text_init(parser_text_T* text);
+void parser_text_append(parser_text_T* text, const token_T* token);
+hb_string_T parser_text_value(const parser_text_T* text);
+bool parser_text_is_empty(const parser_text_T* text);
+void parser_text_clear(parser_text_T* text);
+void parser_text_free(parser_text_T* text);
+
+void parser_append_literal_node_from_text(
   const parser_T* parser,
-  hb_buffer_T* buffer,
+  parser_text_T* text,
   hb_array_T* children,
   position_T start
 );
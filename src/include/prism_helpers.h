@@ -4,6 +4,7 @@
 #include "analyze/analyzed_ruby.h"
 #include "ast_nodes.h"
 #include "errors.h"
+#include "line_offsets.h"
 #include "location.h"
 #include "position.h"
 
@@ -14,14 +15,15 @@ const char* pm_error_level_to_string(pm_error_level_t level);
 RUBY_PARSE_ERROR_T* ruby_parse_error_from_prism_error(
   const pm_diagnostic_t* error,
   const AST_NODE_T* node,
-  const char* source,
+  const line_offsets_T* line_offsets,
   pm_parser_t* parser
 );
 
 RUBY_PARSE_ERROR_T* ruby_parse_error_from_prism_error_with_positions(
   const pm_diagnostic_t* error,
   position_T start,
-  position_T end
+  position_T end,
+  hb_arena_T* allocator
 );
 
 location_T* get_then_keyword_location(analyzed_ruby_T* analyzed, const char* source);
@@ -18,9 +18,12 @@ char* token_types_to_friendly_string_valist(token_type_T first_token, va_list ar
 #define token_types_to_friendly_string(...) token_types_to_friendly_string_va(__VA_ARGS__, TOKEN_SENTINEL)
 
 token_T* token_copy(token_T* token);
+token_T* token_copy_arena(token_T* token, hb_arena_T* allocator);
 
 void token_free(token_T* token);
 
+bool token_own_value(token_T* token, hb_arena_T* allocator);
+char* token_value_to_c_string(const token_T* token);
 bool token_value_empty(const token_T* token);
 
 #endif
@@ -3,6 +3,10 @@
 
 #include "location.h"
 #include "range.h"
+#include "util/hb_arena.h"
+#include "util/hb_string.h"
+
+#include <stdbool.h>
 
 typedef enum {
   TOKEN_WHITESPACE, // ' '
@@ -52,11 +56,15 @@ typedef enum {
 // Sentinel value for variadic functions
 #define TOKEN_SENTINEL 99999999
 
+// `value` is a view into the lexed source unless `owns_value` is set,
+// so the source must outlive every token (and node) that references it.
 typedef struct TOKEN_STRUCT {
-  char* value;
+  hb_arena_T* allocator;
+  hb_string_T value;
   range_T range;
   location_T location;
   token_type_T type;
+  bool owns_value;
 } token_T;
 
 #endif
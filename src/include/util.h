@@ -1,6 +1,7 @@
 #ifndef HERB_UTIL_H
 #define HERB_UTIL_H
 
+#include "util/hb_arena.h"
 #include "util/hb_string.h"
 #include <stdbool.h>
 #include <stdlib.h>
@@ -12,5 +13,6 @@ const char* skip_whitespace(const char* pointer);
 hb_string_T escape_newlines(hb_string_T input);
 hb_string_T quoted_string(hb_string_T input);
 char* herb_strdup(const char* s);
+char* herb_strdup_arena(hb_arena_T* allocator, const char* s);
 
 #endif
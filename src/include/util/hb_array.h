@@ -1,16 +1,20 @@
 #ifndef HERB_ARRAY_H
 #define HERB_ARRAY_H
 
+#include "hb_arena.h"
+
 #include <stdbool.h>
 #include <stdlib.h>
 
 typedef struct HB_ARRAY_STRUCT {
+  hb_arena_T* allocator;
   void** items;
   size_t size;
   size_t capacity;
 } hb_array_T;
 
 hb_array_T* hb_array_init(size_t capacity);
+hb_array_T* hb_array_init_arena(hb_arena_T* allocator, size_t capacity);
 
 void* hb_array_get(const hb_array_T* array, size_t index);
 void* hb_array_first(hb_array_T* array);
@@ -0,0 +1,261 @@
+#include "include/ast_node.h"
+#include "include/ast_nodes.h"
+#include "include/ast_relocate.h"
+#include "include/herb.h"
+#include "include/parser.h"
+#include "include/util/hb_array.h"
+#include "include/util/hb_string.h"
+#include "include/visitor.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static bool find_errors_visitor(const AST_NODE_T* node, void* data) {
+  bool* has_errors = (bool*) data;
+
+  if (*has_errors) { return false; }
+
+  if (ast_node_errors_count(node) > 0) {
+    *has_errors = true;
+    return false;
+  }
+
+  return true;
+}
+
+static bool document_has_errors(const AST_DOCUMENT_NODE_T* document) {
+  bool has_errors = false;
+
+  herb_visit_node((const AST_NODE_T*) document, find_errors_visitor, &has_errors);
+
+  return has_errors;
+}
+
+// A top-level node is a boundary when its own tokens fix where it starts and ends, so whatever is parsed
+// next to it can neither merge into it nor change its extent. CDATA sections and XML declarations don't
+// qualify because text content running into them swallows them.
+static bool is_boundary_node(const AST_NODE_T* node) {
+  if (node == NULL) { return false; }
+
+  switch (node->type) {
+    case AST_CDATA_NODE:
+    case AST_XML_DECLARATION_NODE:
+    case AST_LITERAL_NODE:
+    case AST_HTML_TEXT_NODE:
+    case AST_WHITESPACE_NODE:
+    case AST_HTML_OPEN_TAG_NODE:
+    case AST_HTML_CLOSE_TAG_NODE:
+    case AST_HTML_OMITTED_CLOSE_TAG_NODE:
+    case AST_HTML_CONDITIONAL_OPEN_TAG_NODE:
+    case AST_HTML_CONDITIONAL_ELEMENT_NODE: return false;
+
+    case AST_HTML_ELEMENT_NODE: {
+      const AST_HTML_ELEMENT_NODE_T* element = (const AST_HTML_ELEMENT_NODE_T*) node;
+
+      if (element->is_void) { return true; }
+
+      return element->close_tag != NULL && element->close_tag->type == AST_HTML_CLOSE_TAG_NODE;
+    }
+
+    default: return true;
+  }
+}
+
+static bool is_text_node(const AST_NODE_T* node) {
+  return node != NULL
+      && (node->type == AST_LITERAL_NODE || node->type == AST_HTML_TEXT_NODE || node->type == AST_WHITESPACE_NODE);
+}
+
+// Every top-level node of a reparsed region has to be text or a boundary, otherwise an element left open at the
+// end of the region could have extended into the nodes that follow it in a full parse.
+static bool region_is_self_contained(const AST_DOCUMENT_NODE_T* region) {
+  if (document_has_errors(region)) { return false; }
+
+  for (size_t index = 0; index < hb_array_size(region->children); index++) {
+    AST_NODE_T* child = hb_array_get(region->children, index);
+
+    if (child != NULL && !is_text_node(child) && !is_boundary_node(child)) { return false; }
+  }
+
+  return true;
+}
+
+static bool edit_is_valid(const herb_edit_T* edit, hb_string_T old_source, hb_string_T new_source) {
+  if (edit == NULL) { return false; }
+  if (edit->start > edit->old_end || edit->start > edit->new_end) { return false; }
+  if (edit->old_end > old_source.length || edit->new_end > new_source.length) { return false; }
+
+  return old_source.length - edit->old_end == new_source.length - edit->new_end;
+}
+
+static void relocate_nodes(hb_array_T* nodes, size_t from, size_t to, const ast_relocation_T* relocation) {
+  for (size_t index = from; index < to; index++) {
+    ast_node_relocate(hb_array_get(nodes, index), relocation);
+  }
+}
+
+static void append_nodes(hb_array_T* destination, hb_array_T* nodes, size_t from, size_t to) {
+  for (size_t index = from; index < to; index++) {
+    AST_NODE_T* node = hb_array_get(nodes, index);
+
+    if (node != NULL) { hb_array_append(destination, node); }
+  }
+}
+
+// Reparses the top-level nodes between the last boundary node before the edit and the first one after it,
+// splicing the result into `document`. Returns false, with `document` untouched, when a full parse is needed.
+static bool reparse_affected_nodes(
+  AST_DOCUMENT_NODE_T* document,
+  hb_string_T old_source,
+  hb_string_T new_source,
+  const herb_edit_T* edit,
+  const parser_options_T* options
+) {
+  if (!edit_is_valid(edit, old_source, new_source)) { return false; }
+  if (document->children == NULL || document_has_errors(document)) { return false; }
+
+  hb_array_T* children = document->children;
+  size_t count = hb_array_size(children);
+
+  size_t prefix_count = 0;
+  uint32_t region_start = 0;
+  position_T region_start_position = { .line = 1, .column = 0 };
+
+  for (size_t index = 0; index < count; index++) {
+    AST_NODE_T* child = hb_array_get(children, index);
+    range_T range;
+
+    if (!is_boundary_node(child) || !ast_node_source_range(child, &range)) { continue; }
+    if (range.to >= edit->start) { break; }
+
+    prefix_count = index + 1;
+    region_start = range.to;
+    region_start_position = child->location.end;
+  }
+
+  size_t suffix_start = count;
+  uint32_t old_region_end = old_source.length;
+
+  for (size_t index = count; index > prefix_count; index--) {
+    AST_NODE_T* child = hb_array_get(children, index - 1);
+    range_T range;
+
+    if (!is_boundary_node(child) || !ast_node_source_range(child, &range)) { continue; }
+    if (range.from <= edit->old_end) { break; }
+
+    suffix_start = index - 1;
+    old_region_end = range.from;
+  }
+
+  if (prefix_count == 0 && suffix_start == count) { return false; }
+
+  uint32_t new_region_end = old_region_end - edit->old_end + edit->new_end;
+  char* region_source = hb_string_to_c_string_using_malloc(hb_string_range(new_source, region_start, new_region_end));
+
+  if (!region_source) { return false; }
+
+  hb_arena_T* allocator = document->base.allocator;
+  AST_DOCUMENT_NODE_T* region = herb_parse_arena(region_source, options, allocator);
+
+  if (!region || !region_is_self_contained(region)) {
+    if (region) { ast_node_free((AST_NODE_T*) region); }
+    free(region_source);
+
+    return false;
+  }
+
+  position_T region_end_position = region->base.location.end;
+
+  if (region_end_position.line == 1) { region_end_position.column += region_start_position.column; }
+  region_end_position.line += region_start_position.line - 1;
+
+  ast_relocation_T region_relocation = { .from_source = hb_string(region_source),
+                                         .to_source = new_source.data,
+                                         .offset_delta = region_start,
+                                         .line_delta = (int64_t) region_start_position.line - 1,
+                                         .first_line = 1,
+                                         .column_delta = region_start_position.column };
+
+  relocate_nodes(region->children, 0, hb_array_size(region->children), &region_relocation);
+
+  if (old_source.data != new_source.data) {
+    ast_relocation_T prefix_relocation = { .from_source = old_source, .to_source = new_source.data };
+
+    relocate_nodes(children, 0, prefix_count, &prefix_relocation);
+  }
+
+  position_T document_end = region_end_position;
+
+  if (suffix_start < count) {
+    position_T old_suffix_start = ((AST_NODE_T*) hb_array_get(children, suffix_start))->location.start;
+
+    ast_relocation_T suffix_relocation = {
+      .from_source = old_source,
+      .to_source = new_source.data,
+      .offset_delta = (int64_t) edit->new_end - edit->old_end,
+      .line_delta = (int64_t) region_end_position.line - old_suffix_start.line,
+      .first_line = old_suffix_start.line,
+      .column_delta = (int64_t) region_end_position.column - old_suffix_start.column,
+    };
+
+    relocate_nodes(children, suffix_start, count, &suffix_relocation);
+
+    document_end = document->base.location.end;
+
+    if (document_end.line == suffix_relocation.first_line) {
+      document_end.column = (uint32_t) ((int64_t) document_end.column + suffix_relocation.column_delta);
+    }
+
+    document_end.line = (uint32_t) ((int64_t) document_end.line + suffix_relocation.line_delta);
+  }
+
+  size_t region_count = hb_array_size(region->children);
+  hb_array_T* spliced = hb_array_init_arena(allocator, prefix_count + region_count + (count - suffix_start));
+
+  append_nodes(spliced, children, 0, prefix_count);
+  append_nodes(spliced, region->children, 0, region_count);
+  append_nodes(spliced, children, suffix_start, count);
+
+  for (size_t index = prefix_count; index < suffix_start; index++) {
+    AST_NODE_T* child = hb_array_get(children, index);
+    if (child) { ast_node_free(child); }
+  }
+
+  hb_array_free(&document->children);
+  document->children = spliced;
+  document->base.location.end = document_end;
+
+  hb_array_free(&region->children);
+  ast_node_free((AST_NODE_T*) region);
+  free(region_source);
+
+  return true;
+}
+
+HERB_EXPORTED_FUNCTION AST_DOCUMENT_NODE_T* herb_reparse(
+  AST_DOCUMENT_NODE_T* document,
+  const char* old_source,
+  const char* new_source,
+  const herb_edit_T* edit,
+  const parser_options_T* options
+) {
+  if (!new_source) { new_source = ""; }
+
+  parser_options_T parser_options = HERB_DEFAULT_PARSER_OPTIONS;
+
+  if (options != NULL) { parser_options = *options; }
+
+  if (document == NULL) { return herb_parse(new_source, &parser_options); }
+
+  if (old_source != NULL
+      && reparse_affected_nodes(document, hb_string(old_source), hb_string(new_source), edit, &parser_options)) {
+    return document;
+  }
+
+  hb_arena_T* allocator = document->base.allocator;
+
+  ast_node_free((AST_NODE_T*) document);
+
+  return herb_parse_arena(new_source, &parser_options, allocator);
+}
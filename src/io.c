@@ -1,24 +1,46 @@
+#define _POSIX_C_SOURCE 200809L // Enables `fileno()`, `mmap()` and `sysconf()`
+
 #include "include/io.h"
 #include "include/util/hb_buffer.h"
 
 #include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define FILE_READ_CHUNK 4096
 
 char* herb_read_file(const char* filename) {
   if (!filename) { return NULL; }
 
-  FILE* fp = fopen(filename, "rb");
+  char* source = herb_try_read_file(filename, NULL);
 
-  if (fp == NULL) {
+  if (source == NULL) {
     fprintf(stderr, "Could not read file '%s'\n", filename);
     exit(1);
   }
 
+  return source;
+}
+
+char* herb_try_read_file(const char* filename, size_t* length) {
+  if (!filename) { return NULL; }
+
+  FILE* fp = fopen(filename, "rb");
+
+  if (fp == NULL) { return NULL; }
+
   hb_buffer_T buffer;
-  hb_buffer_init(&buffer, 4096);
+
+  if (!hb_buffer_init(&buffer, 4096)) {
+    fclose(fp);
+    return NULL;
+  }
 
   char chunk[FILE_READ_CHUNK];
   size_t bytes_read;
@@ -27,7 +49,78 @@ char* herb_read_file(const char* filename) {
     hb_buffer_append_with_length(&buffer, chunk, bytes_read);
   }
 
+  bool failed = ferror(fp) != 0;
   fclose(fp);
 
+  if (failed) {
+    free(hb_buffer_value(&buffer));
+    return NULL;
+  }
+
+  if (length != NULL) { *length = hb_buffer_length(&buffer); }
+
   return hb_buffer_value(&buffer);
 }
+
+herb_mapped_file_T herb_map_file(const char* filename) {
+  herb_mapped_file_T file;
+
+  if (!herb_try_map_file(filename, &file)) {
+    fprintf(stderr, "Could not read file '%s'\n", filename);
+    exit(1);
+  }
+
+  return file;
+}
+
+static bool herb_map_file_read(const char* filename, herb_mapped_file_T* file) {
+  size_t length = 0;
+  char* source = herb_try_read_file(filename, &length);
+  if (source == NULL) { return false; }
+
+  *file = (herb_mapped_file_T) { .data = source, .length = length, .mapped_length = 0 };
+
+  return true;
+}
+
+bool herb_try_map_file(const char* filename, herb_mapped_file_T* file) {
+  if (!filename || !file) { return false; }
+
+  int descriptor = open(filename, O_RDONLY);
+  if (descriptor < 0) { return false; }
+
+  struct stat info;
+  long page_size = sysconf(_SC_PAGESIZE);
+
+  // Empty files, and ones filling their last page completely, have no zeroed byte after them to terminate
+  // the mapping, and anything that isn't a regular file might change size under it, so those are read instead.
+  if (fstat(descriptor, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0 || page_size <= 0
+      || info.st_size % page_size == 0) {
+    close(descriptor);
+    return herb_map_file_read(filename, file);
+  }
+
+  size_t length = (size_t) info.st_size;
+  void* data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  close(descriptor);
+
+  if (data == MAP_FAILED) { return herb_map_file_read(filename, file); }
+
+  *file = (herb_mapped_file_T) { .data = data, .length = length, .mapped_length = length };
+
+  return true;
+}
+
+void herb_unmap_file(herb_mapped_file_T* file) {
+  if (!file || !file->data) { return; }
+
+  if (file->mapped_length > 0) {
+    munmap((void*) file->data, file->mapped_length);
+  } else {
+    free((void*) file->data);
+  }
+
+  file->data = NULL;
+  file->length = 0;
+  file->mapped_length = 0;
+}
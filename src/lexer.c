@@ -1,4 +1,7 @@
+#include "include/lexer.h"
 #include "include/lexer_peek_helpers.h"
+#include "include/macros.h"
+#include "include/parse_stats.h"
 #include "include/token.h"
 #include "include/utf8.h"
 #include "include/util.h"
@@ -7,6 +10,10 @@
 #include <ctype.h>
 #include <string.h>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 #define LEXER_STALL_LIMIT 5
 
 static bool lexer_eof(const lexer_T* lexer) {
@@ -30,14 +37,16 @@ static bool lexer_stalled(lexer_T* lexer) {
   return lexer->stalled;
 }
 
-void lexer_init(lexer_T* lexer, const char* source) {
+// Positions are 32-bit, so anything past the first 4 GiB of `source` is left out. `length` must not extend past
+// a NUL byte, as lexing ends there and the bulk scanners don't look for one.
+static void lexer_init_source(lexer_T* lexer, const char* source, size_t length) {
   if (source != NULL) {
-    lexer->source = hb_string(source);
+    lexer->source = (hb_string_T) { .data = (char*) source, .length = (uint32_t) MIN(length, UINT32_MAX) };
   } else {
     lexer->source = hb_string("");
   }
 
-  lexer->current_character = lexer->source.data[0];
+  lexer->current_character = lexer_char_at(lexer, 0);
   lexer->state = STATE_DATA;
 
   lexer->current_line = 1;
@@ -51,6 +60,26 @@ void lexer_init(lexer_T* lexer, const char* source) {
   lexer->stall_counter = 0;
   lexer->last_position = 0;
   lexer->stalled = false;
+  lexer->scanning = false;
+  lexer->stats = NULL;
+
+  lexer->allocator = NULL;
+}
+
+void lexer_init(lexer_T* lexer, const char* source) {
+  lexer_init_source(lexer, source, source != NULL ? strlen(source) : 0);
+}
+
+void lexer_init_with_length(lexer_T* lexer, const char* source, size_t length) {
+  const char* nul = source != NULL ? memchr(source, '\0', length) : NULL;
+
+  lexer_init_source(lexer, source, nul != NULL ? (size_t) (nul - source) : length);
+}
+
+void lexer_init_arena(lexer_T* lexer, const char* source, size_t length, hb_arena_T* allocator) {
+  lexer_init_source(lexer, source, length);
+
+  lexer->allocator = allocator;
 }
 
 token_T* lexer_error(lexer_T* lexer, const char* message) {
@@ -66,7 +95,13 @@ token_T* lexer_error(lexer_T* lexer, const char* message) {
     lexer->current_column
   );
 
-  return token_init(hb_string(error_message), TOKEN_ERROR, lexer);
+  // A scanned token doesn't outlive the next scan, so it can keep the caller's message instead of a copy.
+  if (lexer->scanning) { return token_init(hb_string(message), TOKEN_ERROR, lexer); }
+
+  token_T* token = token_init(hb_string(error_message), TOKEN_ERROR, lexer);
+  token_own_value(token, lexer->allocator);
+
+  return token;
 }
 
 static void lexer_advance(lexer_T* lexer) {
@@ -74,7 +109,7 @@ static void lexer_advance(lexer_T* lexer) {
     if (!is_newline(lexer->current_character)) { lexer->current_column++; }
 
     lexer->current_position++;
-    lexer->current_character = lexer->source.data[lexer->current_position];
+    lexer->current_character = lexer_char_at(lexer, lexer->current_position);
   }
 }
 
@@ -90,7 +125,7 @@ static void lexer_advance_utf8_bytes(lexer_T* lexer, int byte_count) {
       lexer->current_position = lexer->source.length;
       lexer->current_character = '\0';
     } else {
-      lexer->current_character = lexer->source.data[lexer->current_position];
+      lexer->current_character = lexer_char_at(lexer, lexer->current_position);
     }
   }
 }
@@ -102,8 +137,11 @@ static void lexer_advance_by(lexer_T* lexer, const size_t count) {
 }
 
 static token_T* lexer_advance_with(lexer_T* lexer, hb_string_T value, const token_type_T type) {
+  uint32_t start_position = lexer->current_position;
+
   lexer_advance_by(lexer, value.length);
-  return token_init(value, type, lexer);
+
+  return token_init(hb_string_range(lexer->source, start_position, lexer->current_position), type, lexer);
 }
 
 static token_T* lexer_advance_with_next(lexer_T* lexer, size_t count, token_type_T type) {
@@ -119,11 +157,7 @@ static token_T* lexer_advance_with_next(lexer_T* lexer, size_t count, token_type
 }
 
 static token_T* lexer_advance_current(lexer_T* lexer, const token_type_T type) {
-  char buffer[2];
-  buffer[0] = lexer->current_character;
-  buffer[1] = '\0';
-
-  return lexer_advance_with(lexer, hb_string(buffer), type);
+  return lexer_advance_with_next(lexer, 1, type);
 }
 
 static token_T* lexer_advance_utf8_character(lexer_T* lexer, const token_type_T type) {
@@ -168,12 +202,18 @@ static token_T* lexer_parse_whitespace(lexer_T* lexer) {
 static token_T* lexer_parse_identifier(lexer_T* lexer) {
   uint32_t start_position = lexer->current_position;
 
-  while ((isalnum(lexer->current_character) || lexer->current_character == '-' || lexer->current_character == '_'
-          || lexer->current_character == ':')
-         && !lexer_peek_for_html_comment_end(lexer, 0) && !lexer_peek_for_html_comment_invalid_end(lexer, 0)
-         && !lexer_eof(lexer)) {
+  while (!lexer_eof(lexer)) {
+    const char character = lexer->current_character;
 
-    lexer_advance(lexer);
+    if (character == '-') {
+      if (lexer_peek_for_html_comment_end(lexer, 0) || lexer_peek_for_html_comment_invalid_end(lexer, 0)) { break; }
+    } else if (!isalnum(character) && character != '_' && character != ':') {
+      break;
+    }
+
+    lexer->current_column++;
+    lexer->current_position++;
+    lexer->current_character = lexer_char_at(lexer, lexer->current_position);
   }
 
   token_T* token =
@@ -198,9 +238,78 @@ static token_T* lexer_parse_erb_open(lexer_T* lexer) {
   return lexer_error(lexer, "Unexpected ERB start");
 }
 
+// Returns the index of the first byte at or after `position` that can end a plain run of ERB content: a `%` (closing
+// tags), a `<` (a nested `<%`) or a newline. Returns `length` when there is none.
+static uint32_t lexer_find_erb_content_delimiter(const char* data, uint32_t position, uint32_t length) {
+#if defined(__AVX2__)
+  const __m256i percent = _mm256_set1_epi8('%');
+  const __m256i less_than = _mm256_set1_epi8('<');
+  const __m256i line_feed = _mm256_set1_epi8('\n');
+  const __m256i carriage_return = _mm256_set1_epi8('\r');
+
+  while (length - position >= 32) {
+    const __m256i chunk = _mm256_loadu_si256((const __m256i*) (data + position));
+    const __m256i matches = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, percent), _mm256_cmpeq_epi8(chunk, less_than)),
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, line_feed), _mm256_cmpeq_epi8(chunk, carriage_return))
+    );
+    const uint32_t mask = (uint32_t) _mm256_movemask_epi8(matches);
+
+    if (mask != 0) { return position + (uint32_t) __builtin_ctz(mask); }
+
+    position += 32;
+  }
+#endif
+
+#if defined(__SSE2__)
+  const __m128i percent_128 = _mm_set1_epi8('%');
+  const __m128i less_than_128 = _mm_set1_epi8('<');
+  const __m128i line_feed_128 = _mm_set1_epi8('\n');
+  const __m128i carriage_return_128 = _mm_set1_epi8('\r');
+
+  while (length - position >= 16) {
+    const __m128i chunk = _mm_loadu_si128((const __m128i*) (data + position));
+    const __m128i matches = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, percent_128), _mm_cmpeq_epi8(chunk, less_than_128)),
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, line_feed_128), _mm_cmpeq_epi8(chunk, carriage_return_128))
+    );
+    const uint32_t mask = (uint32_t) _mm_movemask_epi8(matches);
+
+    if (mask != 0) { return position + (uint32_t) __builtin_ctz(mask); }
+
+    position += 16;
+  }
+#endif
+
+  while (position < length) {
+    const char character = data[position];
+
+    if (character == '%' || character == '<' || is_newline(character)) { return position; }
+
+    position++;
+  }
+
+  return length;
+}
+
+// Skips ahead over ERB content that cannot start `<%` or any closing tag, stopping one byte early before a `%` so
+// that `-%>` and `=%>` are still seen by `lexer_peek_erb_end`.
+static void lexer_skip_erb_content_run(lexer_T* lexer) {
+  uint32_t end = lexer_find_erb_content_delimiter(lexer->source.data, lexer->current_position, lexer->source.length);
+
+  if (end < lexer->source.length && lexer->source.data[end] == '%' && end > lexer->current_position) { end--; }
+  if (end <= lexer->current_position) { return; }
+
+  lexer->current_column += end - lexer->current_position;
+  lexer->current_position = end;
+  lexer->current_character = lexer_char_at(lexer, end);
+}
+
 static token_T* lexer_parse_erb_content(lexer_T* lexer) {
   uint32_t start_position = lexer->current_position;
 
+  lexer_skip_erb_content_run(lexer);
+
   while (!lexer_peek_erb_end(lexer, 0)) {
     if (lexer_eof(lexer)) {
       token_T* token =
@@ -226,7 +335,9 @@ static token_T* lexer_parse_erb_content(lexer_T* lexer) {
     }
 
     lexer->current_position++;
-    lexer->current_character = lexer->source.data[lexer->current_position];
+    lexer->current_character = lexer_char_at(lexer, lexer->current_position);
+
+    lexer_skip_erb_content_run(lexer);
   }
 
   lexer->state = STATE_ERB_CLOSE;
@@ -249,7 +360,7 @@ static token_T* lexer_parse_erb_close(lexer_T* lexer) {
 
 // ===== Tokenizing Function
 
-token_T* lexer_next_token(lexer_T* lexer) {
+static token_T* lexer_lex_token(lexer_T* lexer) {
   if (lexer_eof(lexer)) { return token_init(hb_string(""), TOKEN_EOF, lexer); }
   if (lexer_stalled(lexer)) { return lexer_error(lexer, "Lexer stalled after 5 iterations"); }
 
@@ -342,3 +453,25 @@ token_T* lexer_next_token(lexer_T* lexer) {
     }
   }
 }
+
+token_T* lexer_next_token(lexer_T* lexer) {
+  if (unlikely(lexer->stats != NULL)) {
+    uint64_t start = herb_parse_stats_clock();
+    token_T* token = lexer_lex_token(lexer);
+
+    lexer->stats->nanoseconds[HERB_PARSE_PHASE_LEX] += herb_parse_stats_clock() - start;
+    lexer->stats->tokens++;
+
+    return token;
+  }
+
+  return lexer_lex_token(lexer);
+}
+
+const token_T* lexer_scan_token(lexer_T* lexer) {
+  lexer->scanning = true;
+  const token_T* token = lexer_next_token(lexer);
+  lexer->scanning = false;
+
+  return token;
+}
@@ -9,11 +9,11 @@
 #include <stdbool.h>
 
 char lexer_backtrack(const lexer_T* lexer, uint32_t offset) {
-  return lexer->source.data[MAX(lexer->current_position - offset, 0)];
+  return lexer_char_at(lexer, MAX(lexer->current_position - offset, 0));
 }
 
 char lexer_peek(const lexer_T* lexer, uint32_t offset) {
-  return lexer->source.data[MIN(lexer->current_position + offset, lexer->source.length)];
+  return lexer_char_at(lexer, lexer->current_position + offset);
 }
 
 bool lexer_peek_for(const lexer_T* lexer, uint32_t offset, hb_string_T pattern, const bool case_insensitive) {
@@ -0,0 +1,155 @@
+#include "include/line_offsets.h"
+#include "include/util.h"
+
+#include <stdlib.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#  include <immintrin.h>
+#endif
+
+// Returns the offset of the next '\n' or '\r' at or after `position`, or `length` when there is none.
+static size_t line_offsets_find_newline(const char* source, size_t position, size_t length) {
+#if defined(__AVX2__)
+  const __m256i line_feed = _mm256_set1_epi8('\n');
+  const __m256i carriage_return = _mm256_set1_epi8('\r');
+
+  while (position + 32 <= length) {
+    const __m256i chunk = _mm256_loadu_si256((const __m256i*) (source + position));
+    const __m256i matches =
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, line_feed), _mm256_cmpeq_epi8(chunk, carriage_return));
+    const uint32_t mask = (uint32_t) _mm256_movemask_epi8(matches);
+
+    if (mask != 0) { return position + (size_t) __builtin_ctz(mask); }
+
+    position += 32;
+  }
+#endif
+
+#if defined(__SSE2__)
+  const __m128i line_feed_128 = _mm_set1_epi8('\n');
+  const __m128i carriage_return_128 = _mm_set1_epi8('\r');
+
+  while (position + 16 <= length) {
+    const __m128i chunk = _mm_loadu_si128((const __m128i*) (source + position));
+    const __m128i matches =
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, line_feed_128), _mm_cmpeq_epi8(chunk, carriage_return_128));
+    const uint32_t mask = (uint32_t) _mm_movemask_epi8(matches);
+
+    if (mask != 0) { return position + (size_t) __builtin_ctz(mask); }
+
+    position += 16;
+  }
+#endif
+
+  while (position < length && !is_newline(source[position])) {
+    position++;
+  }
+
+  return position;
+}
+
+static size_t line_offsets_count_newlines(const char* source, size_t length) {
+  size_t count = 0;
+  size_t position = 0;
+
+#if defined(__AVX2__)
+  const __m256i line_feed = _mm256_set1_epi8('\n');
+  const __m256i carriage_return = _mm256_set1_epi8('\r');
+
+  for (; position + 32 <= length; position += 32) {
+    const __m256i chunk = _mm256_loadu_si256((const __m256i*) (source + position));
+    const __m256i matches =
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, line_feed), _mm256_cmpeq_epi8(chunk, carriage_return));
+
+    count += (size_t) __builtin_popcount((uint32_t) _mm256_movemask_epi8(matches));
+  }
+#endif
+
+#if defined(__SSE2__)
+  const __m128i line_feed_128 = _mm_set1_epi8('\n');
+  const __m128i carriage_return_128 = _mm_set1_epi8('\r');
+
+  for (; position + 16 <= length; position += 16) {
+    const __m128i chunk = _mm_loadu_si128((const __m128i*) (source + position));
+    const __m128i matches =
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, line_feed_128), _mm_cmpeq_epi8(chunk, carriage_return_128));
+
+    count += (size_t) __builtin_popcount((uint32_t) _mm_movemask_epi8(matches));
+  }
+#endif
+
+  for (; position < length; position++) {
+    if (is_newline(source[position])) { count++; }
+  }
+
+  return count;
+}
+
+bool line_offsets_init(line_offsets_T* line_offsets, const char* source, size_t length) {
+  if (source == NULL) { length = 0; }
+
+  // Sized exactly up front, so the starts are filled in without ever growing the array.
+  size_t count = 1 + (length > 0 ? line_offsets_count_newlines(source, length) : 0);
+
+  line_offsets->starts = malloc(sizeof(uint32_t) * count);
+  line_offsets->count = 0;
+  line_offsets->source_length = length;
+
+  if (line_offsets->starts == NULL) { return false; }
+
+  line_offsets->starts[line_offsets->count++] = 0;
+
+  for (size_t position = line_offsets_find_newline(source, 0, length); position < length;
+       position = line_offsets_find_newline(source, position + 1, length)) {
+    line_offsets->starts[line_offsets->count++] = (uint32_t) (position + 1);
+  }
+
+  return true;
+}
+
+void line_offsets_free(line_offsets_T* line_offsets) {
+  if (line_offsets == NULL) { return; }
+
+  free(line_offsets->starts);
+
+  line_offsets->starts = NULL;
+  line_offsets->count = 0;
+  line_offsets->source_length = 0;
+}
+
+size_t line_offsets_line_count(const line_offsets_T* line_offsets) {
+  return line_offsets->count;
+}
+
+position_T line_offsets_position(const line_offsets_T* line_offsets, size_t offset) {
+  if (line_offsets->count == 0) { return (position_T) { .line = 1, .column = 0 }; }
+  if (offset > line_offsets->source_length) { offset = line_offsets->source_length; }
+
+  // Finds the last line starting at or before `offset`.
+  size_t low = 0;
+  size_t high = line_offsets->count;
+
+  while (high - low > 1) {
+    size_t middle = low + (high - low) / 2;
+
+    if (line_offsets->starts[middle] <= offset) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+
+  return (position_T) { .line = (uint32_t) (low + 1), .column = (uint32_t) (offset - line_offsets->starts[low]) };
+}
+
+size_t line_offsets_offset(const line_offsets_T* line_offsets, position_T position) {
+  if (line_offsets->count == 0 || position.line == 0) { return 0; }
+  if (position.line > line_offsets->count) { return line_offsets->source_length; }
+
+  size_t line_start = line_offsets->starts[position.line - 1];
+  size_t line_end =
+    position.line < line_offsets->count ? line_offsets->starts[position.line] - 1 : line_offsets->source_length;
+  size_t offset = line_start + position.column;
+
+  return offset < line_end ? offset : line_end;
+}
@@ -2,6 +2,7 @@
 
 #include "include/ast_node.h"
 #include "include/ast_nodes.h"
+#include "include/bench.h"
 
 #ifndef HERB_EXCLUDE_PRETTYPRINT
 #  include "include/ast_pretty_print.h"
@@ -10,6 +11,8 @@
 #include "include/extract.h"
 #include "include/herb.h"
 #include "include/io.h"
+#include "include/macros.h"
+#include "include/parse_stats.h"
 #include "include/ruby_parser.h"
 #include "include/util/hb_buffer.h"
 #include "include/util/string.h"
@@ -37,6 +40,20 @@ void print_time_diff(const struct timespec start, const struct timespec end, con
   printf("  %8.6f  s\n\n", s);
 }
 
+void print_parse_stats(const herb_parse_stats_T* stats) {
+  printf("Parse stats:\n\n");
+
+  for (int phase = 0; phase < HERB_PARSE_PHASE_COUNT; phase++) {
+    printf("  %-24s %10.0f µs\n", herb_parse_phase_name((herb_parse_phase_T) phase), stats->nanoseconds[phase] / 1e3);
+  }
+
+  printf("\n");
+  printf("  %-24s %10zu\n", "tokens", stats->tokens);
+  printf("  %-24s %10zu\n", "nodes", stats->nodes);
+  printf("  %-24s %10zu\n", "prism parses", stats->prism_parses);
+  printf("  %-24s %10zu\n\n", "arena allocations", stats->allocations);
+}
+
 int main(const int argc, char* argv[]) {
   if (argc < 2) {
     puts("./herb [command] [options]\n");
@@ -44,10 +61,12 @@ int main(const int argc, char* argv[]) {
     puts("Herb 🌿 Powerful and seamless HTML-aware ERB parsing and tooling.\n");
 
     puts("./herb lex [file]      -  Lex a file");
-    puts("./herb parse [file]    -  Parse a file");
+    puts("./herb parse [file]    -  Parse a file [--silent] [--stats]");
     puts("./herb ruby [file]     -  Extract Ruby from a file");
     puts("./herb html [file]     -  Extract HTML from a file");
     puts("./herb prism [file]    -  Extract Ruby from a file and parse the Ruby source with Prism");
+    puts("./herb bench [path]    -  Benchmark lexing, parsing and extraction over a file or directory");
+    puts("                          [--iterations N] [--json]");
 
     return EXIT_FAILURE;
   }
@@ -57,6 +76,28 @@ int main(const int argc, char* argv[]) {
     return EXIT_FAILURE;
   }
 
+  if (string_equals(argv[1], "bench")) {
+    herb_bench_options_T options = { .iterations = 10, .json = false };
+
+    for (int index = 3; index < argc; index++) {
+      if (string_equals(argv[index], "--json")) {
+        options.json = true;
+      } else if (string_equals(argv[index], "--iterations") && index + 1 < argc) {
+        options.iterations = strtoul(argv[++index], NULL, 10);
+      } else {
+        printf("Unknown option: %s\n", argv[index]);
+        return EXIT_FAILURE;
+      }
+    }
+
+    if (options.iterations == 0) {
+      puts("Please specify a positive number of iterations.");
+      return EXIT_FAILURE;
+    }
+
+    return herb_bench(argv[2], &options) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
   hb_buffer_T output;
 
   if (!hb_buffer_init(&output, 4096)) { return 1; }
@@ -80,12 +121,28 @@ int main(const int argc, char* argv[]) {
   }
 
   if (string_equals(argv[1], "parse")) {
-    AST_DOCUMENT_NODE_T* root = herb_parse(source, NULL);
+    int silent = 0;
+    int stats = 0;
 
-    clock_gettime(CLOCK_MONOTONIC, &end);
+    for (int index = 3; index < argc; index++) {
+      if (string_equals(argv[index], "--silent")) { silent = 1; }
+      if (string_equals(argv[index], "--stats")) { stats = 1; }
+    }
 
-    int silent = 0;
-    if (argc > 3 && string_equals(argv[3], "--silent")) { silent = 1; }
+    // With --stats the document is parsed into an arena, so its allocations are counted too.
+    herb_parse_stats_T parse_stats = { 0 };
+    parser_options_T options = HERB_DEFAULT_PARSER_OPTIONS;
+    hb_arena_T allocator;
+    hb_arena_T* arena = NULL;
+
+    if (stats) {
+      options.stats = &parse_stats;
+      if (hb_arena_init(&allocator, MB(1))) { arena = &allocator; }
+    }
+
+    AST_DOCUMENT_NODE_T* root = herb_parse_arena(source, &options, arena);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
 
     if (!silent) {
 #ifndef HERB_EXCLUDE_PRETTYPRINT
@@ -96,7 +153,14 @@ int main(const int argc, char* argv[]) {
       print_time_diff(start, end, "parsing");
     }
 
-    ast_node_free((AST_NODE_T*) root);
+    if (stats) { print_parse_stats(&parse_stats); }
+
+    if (arena != NULL) {
+      hb_arena_free(arena);
+    } else {
+      ast_node_free((AST_NODE_T*) root);
+    }
+
     free(output.value);
     free(source);
 
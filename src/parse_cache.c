@@ -0,0 +1,188 @@
+#include "include/ast_serialize.h"
+#include "include/herb.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PARSE_CACHE_CHUNK 4096
+
+#define PARSE_CACHE_MURMUR_MULTIPLIER 0xc6a4a7935bd1e995ULL
+
+// Cache entries are named after a 64-bit FNV-1a hash of everything that determines the serialized document.
+// Every entry starts with the source length and a MurmurHash64A-style hash of the same inputs, which shares
+// nothing with FNV-1a, so an entry is only used when two unrelated hashes and the length all match.
+typedef struct {
+  uint64_t name;
+  uint64_t check;
+  uint64_t check_word;
+  uint64_t source_length;
+  size_t check_word_length;
+} parse_cache_key_T;
+
+typedef struct {
+  uint64_t check;
+  uint64_t source_length;
+} parse_cache_header_T;
+
+static uint64_t parse_cache_murmur_mix(uint64_t hash, uint64_t word) {
+  word *= PARSE_CACHE_MURMUR_MULTIPLIER;
+  word ^= word >> 47;
+  word *= PARSE_CACHE_MURMUR_MULTIPLIER;
+
+  return (hash ^ word) * PARSE_CACHE_MURMUR_MULTIPLIER;
+}
+
+static void parse_cache_hash(parse_cache_key_T* key, const void* data, size_t length) {
+  const unsigned char* bytes = (const unsigned char*) data;
+
+  for (size_t index = 0; index < length; index++) {
+    key->name = (key->name ^ bytes[index]) * 0x100000001b3ULL;
+    key->check_word |= (uint64_t) bytes[index] << (8 * key->check_word_length);
+
+    if (++key->check_word_length == sizeof(key->check_word)) {
+      key->check = parse_cache_murmur_mix(key->check, key->check_word);
+      key->check_word = 0;
+      key->check_word_length = 0;
+    }
+  }
+}
+
+static void parse_cache_hash_finish(parse_cache_key_T* key) {
+  uint64_t hash = parse_cache_murmur_mix(key->check, key->check_word ^ key->check_word_length);
+
+  hash ^= hash >> 47;
+  hash *= PARSE_CACHE_MURMUR_MULTIPLIER;
+  hash ^= hash >> 47;
+
+  key->check = hash;
+}
+
+static parse_cache_key_T parse_cache_key(const char* source, size_t length, const parser_options_T* options) {
+  parse_cache_key_T key = { .name = 0xcbf29ce484222325ULL, .check = 0x9e3779b97f4a7c15ULL, .source_length = length };
+  const uint32_t serialize_version = HERB_SERIALIZE_VERSION;
+  const unsigned char flags[3] = { options->track_whitespace, options->analyze, options->strict };
+
+  // Versions are hashed with their terminators so that, e.g., "0.8.1" + "0" can't match "0.8.10" + "".
+  parse_cache_hash(&key, herb_version(), strlen(herb_version()) + 1);
+  parse_cache_hash(&key, herb_prism_version(), strlen(herb_prism_version()) + 1);
+  parse_cache_hash(&key, &serialize_version, sizeof(serialize_version));
+  parse_cache_hash(&key, flags, sizeof(flags));
+  parse_cache_hash(&key, &length, sizeof(length));
+  parse_cache_hash(&key, source, length);
+  parse_cache_hash_finish(&key);
+
+  return key;
+}
+
+static bool parse_cache_read(FILE* file, const parse_cache_key_T* key, hb_buffer_T* output) {
+  parse_cache_header_T header;
+
+  if (fread(&header, sizeof(header), 1, file) != 1) { return false; }
+  if (header.check != key->check || header.source_length != key->source_length) { return false; }
+
+  size_t start = hb_buffer_length(output);
+  char chunk[PARSE_CACHE_CHUNK];
+  size_t bytes_read;
+
+  while ((bytes_read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    hb_buffer_append_with_length(output, chunk, bytes_read);
+  }
+
+  // A truncated entry, e.g. from a full disk, falls back to parsing like any other miss.
+  if (ferror(file) || hb_buffer_length(output) - start < 4 || memcmp(output->value + start, "HERB", 4) != 0) {
+    output->length = start;
+    output->value[start] = '\0';
+
+    return false;
+  }
+
+  return true;
+}
+
+// Writes to a temporary file first and renames it into place, so concurrent runs only ever see complete entries.
+static void parse_cache_write(
+  const char* directory,
+  const char* path,
+  const parse_cache_key_T* key,
+  const char* document,
+  size_t length,
+  const void* writer
+) {
+  char temporary_path[4096];
+  int written = snprintf(
+    temporary_path,
+    sizeof(temporary_path),
+    "%s/.%016llx.%ld.%p.tmp",
+    directory,
+    (unsigned long long) key->name,
+    (long) getpid(),
+    writer
+  );
+
+  if (written < 0 || (size_t) written >= sizeof(temporary_path)) { return; }
+
+  FILE* file = fopen(temporary_path, "wb");
+  if (file == NULL) { return; }
+
+  parse_cache_header_T header = { .check = key->check, .source_length = key->source_length };
+  bool complete = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(document, 1, length, file) == length;
+
+  if (fclose(file) != 0 || !complete || rename(temporary_path, path) != 0) { remove(temporary_path); }
+}
+
+HERB_EXPORTED_FUNCTION bool herb_parse_to_buffer_cached(
+  const char* source,
+  const parser_options_T* options,
+  const char* cache_directory,
+  hb_buffer_T* output
+) {
+  if (source == NULL) { return false; }
+
+  return herb_parse_to_buffer_cached_with_length(source, strlen(source), options, cache_directory, output);
+}
+
+HERB_EXPORTED_FUNCTION bool herb_parse_to_buffer_cached_with_length(
+  const char* source,
+  size_t length,
+  const parser_options_T* options,
+  const char* cache_directory,
+  hb_buffer_T* output
+) {
+  if (source == NULL || output == NULL) { return false; }
+  if (options == NULL) { options = &HERB_DEFAULT_PARSER_OPTIONS; }
+
+  parse_cache_key_T key = { 0 };
+  char path[4096];
+  bool cacheable = false;
+
+  if (cache_directory != NULL) {
+    key = parse_cache_key(source, length, options);
+    int written = snprintf(path, sizeof(path), "%s/%016llx.herb", cache_directory, (unsigned long long) key.name);
+    cacheable = written > 0 && (size_t) written < sizeof(path);
+  }
+
+  if (cacheable) {
+    FILE* file = fopen(path, "rb");
+
+    if (file != NULL) {
+      bool hit = parse_cache_read(file, &key, output);
+      fclose(file);
+
+      if (hit) { return true; }
+    }
+  }
+
+  size_t start = hb_buffer_length(output);
+  AST_DOCUMENT_NODE_T* document = herb_parse_with_length(source, length, options);
+
+  herb_serialize_with_length(document, source, length, output);
+  ast_node_free((AST_NODE_T*) document);
+
+  if (cacheable) {
+    parse_cache_write(cache_directory, path, &key, output->value + start, hb_buffer_length(output) - start, output);
+  }
+
+  return false;
+}
@@ -0,0 +1,125 @@
+#ifdef __linux__
+#  define _GNU_SOURCE
+#endif
+
+#include "include/herb.h"
+#include "include/io.h"
+#include "include/macros.h"
+#include "include/util/hb_arena.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define PARSE_FILES_ARENA_SIZE MB(1)
+
+typedef struct {
+  const char* const* paths;
+  size_t count;
+  const parser_options_T* options;
+  herb_parse_files_callback_T callback;
+  void* user_data;
+
+  pthread_mutex_t mutex;
+  size_t next_index;
+} parse_files_queue_T;
+
+static bool parse_files_queue_take(parse_files_queue_T* queue, size_t* index) {
+  pthread_mutex_lock(&queue->mutex);
+
+  bool taken = queue->next_index < queue->count;
+  if (taken) { *index = queue->next_index++; }
+
+  pthread_mutex_unlock(&queue->mutex);
+
+  return taken;
+}
+
+static void* parse_files_worker(void* data) {
+  parse_files_queue_T* queue = (parse_files_queue_T*) data;
+
+  herb_context_T context;
+  bool has_context = herb_context_init(&context, PARSE_FILES_ARENA_SIZE);
+
+  size_t index;
+
+  while (parse_files_queue_take(queue, &index)) {
+    const char* path = queue->paths[index];
+    herb_mapped_file_T file = { 0 };
+    const char* source = herb_try_map_file(path, &file) ? file.data : NULL;
+
+    AST_DOCUMENT_NODE_T* document = NULL;
+
+    if (source != NULL) {
+      document = has_context ? herb_context_parse(&context, source, file.length, queue->options)
+                             : herb_parse_with_length(source, file.length, queue->options);
+    }
+
+    queue->callback(index, path, source, document, queue->user_data);
+
+    // Every node and token of the document lives in the context's arena, so resetting it releases the whole tree.
+    if (has_context) {
+      herb_context_reset(&context);
+    } else if (document != NULL) {
+      ast_node_free((AST_NODE_T*) document);
+    }
+
+    if (source != NULL) { herb_unmap_file(&file); }
+  }
+
+  if (has_context) { herb_context_free(&context); }
+
+  return NULL;
+}
+
+static size_t parse_files_default_threads(void) {
+  long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return processors > 0 ? (size_t) processors : 1;
+}
+
+HERB_EXPORTED_FUNCTION void herb_parse_files(
+  const char* const* paths,
+  size_t count,
+  const parser_options_T* options,
+  size_t threads,
+  herb_parse_files_callback_T callback,
+  void* user_data
+) {
+  if (paths == NULL || count == 0 || callback == NULL) { return; }
+
+  parse_files_queue_T queue = { .paths = paths,
+                                .count = count,
+                                .options = options,
+                                .callback = callback,
+                                .user_data = user_data,
+                                .next_index = 0 };
+
+  if (pthread_mutex_init(&queue.mutex, NULL) != 0) { return; }
+
+  if (threads == 0) { threads = parse_files_default_threads(); }
+  if (threads > count) { threads = count; }
+
+  // The stats aren't synchronized, so they are summed up on a single thread.
+  if (options != NULL && options->stats != NULL) { threads = 1; }
+
+  // The calling thread works through the queue as well, so only `threads - 1` workers are spawned.
+  size_t spawned = 0;
+  pthread_t* workers = threads > 1 ? malloc(sizeof(pthread_t) * (threads - 1)) : NULL;
+
+  if (workers != NULL) {
+    while (spawned < threads - 1 && pthread_create(&workers[spawned], NULL, parse_files_worker, &queue) == 0) {
+      spawned++;
+    }
+  }
+
+  parse_files_worker(&queue);
+
+  for (size_t index = 0; index < spawned; index++) {
+    pthread_join(workers[index], NULL);
+  }
+
+  free(workers);
+  pthread_mutex_destroy(&queue.mutex);
+}
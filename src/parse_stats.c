@@ -0,0 +1,41 @@
+#define _POSIX_C_SOURCE 199309L // Enables `clock_gettime()`
+
+#include "include/parse_stats.h"
+#include "include/macros.h"
+
+#include <stddef.h>
+#include <time.h>
+
+static HERB_THREAD_LOCAL herb_parse_stats_T* current_stats = NULL;
+
+static const char* const parse_phase_names[HERB_PARSE_PHASE_COUNT] = {
+  [HERB_PARSE_PHASE_LEX] = "lex",
+  [HERB_PARSE_PHASE_PARSE] = "parse",
+  [HERB_PARSE_PHASE_TRANSFORM] = "transform",
+  [HERB_PARSE_PHASE_MATCH_TAGS] = "match_tags",
+  [HERB_PARSE_PHASE_PARSE_ERRORS] = "parse_errors",
+};
+
+const char* herb_parse_phase_name(herb_parse_phase_T phase) {
+  if (phase >= HERB_PARSE_PHASE_COUNT) { return "unknown"; }
+
+  return parse_phase_names[phase];
+}
+
+uint64_t herb_parse_stats_clock(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+herb_parse_stats_T* herb_parse_stats_swap_current(herb_parse_stats_T* stats) {
+  herb_parse_stats_T* previous = current_stats;
+  current_stats = stats;
+
+  return previous;
+}
+
+void herb_parse_stats_count_prism_parse(void) {
+  if (current_stats != NULL) { current_stats->prism_parses++; }
+}
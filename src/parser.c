@@ -5,15 +5,14 @@
 #include "include/html_util.h"
 #include "include/lexer.h"
 #include "include/lexer_peek_helpers.h"
+#include "include/macros.h"
 #include "include/parser_helpers.h"
 #include "include/token.h"
 #include "include/token_matchers.h"
 #include "include/util.h"
 #include "include/util/hb_array.h"
-#include "include/util/hb_buffer.h"
 #include "include/util/hb_string.h"
 #include "include/util/string.h"
-#include "include/visitor.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -33,7 +32,12 @@ static bool parser_lookahead_erb_is_control_flow(parser_T* parser);
 static void parser_handle_erb_in_open_tag(parser_T* parser, hb_array_T* children);
 static void parser_handle_whitespace_in_open_tag(parser_T* parser, hb_array_T* children);
 
-const parser_options_T HERB_DEFAULT_PARSER_OPTIONS = { .track_whitespace = false, .analyze = true, .strict = true };
+const parser_options_T HERB_DEFAULT_PARSER_OPTIONS = {
+  .track_whitespace = false,
+  .analyze = true,
+  .strict = true,
+  .stats = NULL,
+};
 
 size_t parser_sizeof(void) {
   return sizeof(struct PARSER_STRUCT);
@@ -41,8 +45,9 @@ size_t parser_sizeof(void) {
 
 void herb_parser_init(parser_T* parser, lexer_T* lexer, parser_options_T options) {
   parser->lexer = lexer;
+  parser->allocator = lexer->allocator;
   parser->current_token = lexer_next_token(lexer);
-  parser->open_tags_stack = hb_array_init(16);
+  parser->open_tags_stack = hb_array_init_arena(parser->allocator, 16);
   parser->state = PARSER_STATE_DATA;
   parser->foreign_content_type = FOREIGN_CONTENT_UNKNOWN;
   parser->options = options;
@@ -51,17 +56,17 @@ void herb_parser_init(parser_T* parser, lexer_T* lexer, parser_options_T options
 }
 
 static AST_CDATA_NODE_T* parser_parse_cdata(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
-  hb_array_T* children = hb_array_init(8);
-  hb_buffer_T content;
-  hb_buffer_init(&content, 128);
+  hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
+  hb_array_T* children = hb_array_init_arena(parser->allocator, 8);
+  parser_text_T content;
+  parser_text_init(&content);
 
   token_T* tag_opening = parser_consume_expected(parser, TOKEN_CDATA_START, errors);
   position_T start = parser->current_token->location.start;
 
   while (token_is_none_of(parser, TOKEN_CDATA_END, TOKEN_EOF)) {
     if (token_is(parser, TOKEN_ERB_START)) {
-      parser_append_literal_node_from_buffer(parser, &content, children, start);
+      parser_append_literal_node_from_text(parser, &content, children, start);
       AST_ERB_CONTENT_NODE_T* erb_node = parser_parse_erb_tag(parser);
       hb_array_append(children, erb_node);
       start = parser->current_token->location.start;
@@ -69,11 +74,11 @@ static AST_CDATA_NODE_T* parser_parse_cdata(parser_T* parser) {
     }
 
     token_T* token = parser_advance(parser);
-    hb_buffer_append(&content, token->value);
+    parser_text_append(&content, token);
     token_free(token);
   }
 
-  parser_append_literal_node_from_buffer(parser, &content, children, start);
+  parser_append_literal_node_from_text(parser, &content, children, start);
   token_T* tag_closing = parser_consume_expected(parser, TOKEN_CDATA_END, errors);
 
   AST_CDATA_NODE_T* cdata = ast_cdata_node_init(
@@ -82,10 +87,11 @@ static AST_CDATA_NODE_T* parser_parse_cdata(parser_T* parser) {
     tag_closing,
     tag_opening->location.start,
     tag_closing->location.end,
-    errors
+    errors,
+    parser->allocator
   );
 
-  free(content.value);
+  parser_text_free(&content);
   token_free(tag_opening);
   token_free(tag_closing);
 
@@ -93,17 +99,17 @@ static AST_CDATA_NODE_T* parser_parse_cdata(parser_T* parser) {
 }
 
 static AST_HTML_COMMENT_NODE_T* parser_parse_html_comment(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
-  hb_array_T* children = hb_array_init(8);
+  hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
+  hb_array_T* children = hb_array_init_arena(parser->allocator, 8);
   token_T* comment_start = parser_consume_expected(parser, TOKEN_HTML_COMMENT_START, errors);
   position_T start = parser->current_token->location.start;
 
-  hb_buffer_T comment;
-  hb_buffer_init(&comment, 512);
+  parser_text_T comment;
+  parser_text_init(&comment);
 
   while (token_is_none_of(parser, TOKEN_HTML_COMMENT_END, TOKEN_HTML_COMMENT_INVALID_END, TOKEN_EOF)) {
     if (token_is(parser, TOKEN_ERB_START)) {
-      parser_append_literal_node_from_buffer(parser, &comment, children, start);
+      parser_append_literal_node_from_text(parser, &comment, children, start);
 
       AST_ERB_CONTENT_NODE_T* erb_node = parser_parse_erb_tag(parser);
       hb_array_append(children, erb_node);
@@ -114,11 +120,11 @@ static AST_HTML_COMMENT_NODE_T* parser_parse_html_comment(parser_T* parser) {
     }
 
     token_T* token = parser_advance(parser);
-    hb_buffer_append(&comment, token->value);
+    parser_text_append(&comment, token);
     token_free(token);
   }
 
-  parser_append_literal_node_from_buffer(parser, &comment, children, start);
+  parser_append_literal_node_from_text(parser, &comment, children, start);
 
   token_T* comment_end = NULL;
 
@@ -140,10 +146,11 @@ static AST_HTML_COMMENT_NODE_T* parser_parse_html_comment(parser_T* parser) {
     comment_end,
     comment_start->location.start,
     comment_end->location.end,
-    errors
+    errors,
+    parser->allocator
   );
 
-  free(comment.value);
+  parser_text_free(&comment);
   token_free(comment_start);
   token_free(comment_end);
 
@@ -151,10 +158,10 @@ static AST_HTML_COMMENT_NODE_T* parser_parse_html_comment(parser_T* parser) {
 }
 
 static AST_HTML_DOCTYPE_NODE_T* parser_parse_html_doctype(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
-  hb_array_T* children = hb_array_init(8);
-  hb_buffer_T content;
-  hb_buffer_init(&content, 64);
+  hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
+  hb_array_T* children = hb_array_init_arena(parser->allocator, 8);
+  parser_text_T content;
+  parser_text_init(&content);
 
   token_T* tag_opening = parser_consume_expected(parser, TOKEN_HTML_DOCTYPE, errors);
 
@@ -162,7 +169,7 @@ static AST_HTML_DOCTYPE_NODE_T* parser_parse_html_doctype(parser_T* parser) {
 
   while (token_is_none_of(parser, TOKEN_HTML_TAG_END, TOKEN_EOF)) {
     if (token_is(parser, TOKEN_ERB_START)) {
-      parser_append_literal_node_from_buffer(parser, &content, children, start);
+      parser_append_literal_node_from_text(parser, &content, children, start);
 
       AST_ERB_CONTENT_NODE_T* erb_node = parser_parse_erb_tag(parser);
       hb_array_append(children, erb_node);
@@ -171,11 +178,11 @@ static AST_HTML_DOCTYPE_NODE_T* parser_parse_html_doctype(parser_T* parser) {
     }
 
     token_T* token = parser_consume_expected(parser, parser->current_token->type, errors);
-    hb_buffer_append(&content, token->value);
+    parser_text_append(&content, token);
     token_free(token);
   }
 
-  parser_append_literal_node_from_buffer(parser, &content, children, start);
+  parser_append_literal_node_from_text(parser, &content, children, start);
 
   token_T* tag_closing = parser_consume_expected(parser, TOKEN_HTML_TAG_END, errors);
 
@@ -185,21 +192,22 @@ static AST_HTML_DOCTYPE_NODE_T* parser_parse_html_doctype(parser_T* parser) {
     tag_closing,
     tag_opening->location.start,
     tag_closing->location.end,
-    errors
+    errors,
+    parser->allocator
   );
 
   token_free(tag_opening);
   token_free(tag_closing);
-  free(content.value);
+  parser_text_free(&content);
 
   return doctype;
 }
 
 static AST_XML_DECLARATION_NODE_T* parser_parse_xml_declaration(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
-  hb_array_T* children = hb_array_init(8);
-  hb_buffer_T content;
-  hb_buffer_init(&content, 64);
+  hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
+  hb_array_T* children = hb_array_init_arena(parser->allocator, 8);
+  parser_text_T content;
+  parser_text_init(&content);
 
   token_T* tag_opening = parser_consume_expected(parser, TOKEN_XML_DECLARATION, errors);
 
@@ -207,7 +215,7 @@ static AST_XML_DECLARATION_NODE_T* parser_parse_xml_declaration(parser_T* parser
 
   while (token_is_none_of(parser, TOKEN_XML_DECLARATION_END, TOKEN_EOF)) {
     if (token_is(parser, TOKEN_ERB_START)) {
-      parser_append_literal_node_from_buffer(parser, &content, children, start);
+      parser_append_literal_node_from_text(parser, &content, children, start);
 
       AST_ERB_CONTENT_NODE_T* erb_node = parser_parse_erb_tag(parser);
       hb_array_append(children, erb_node);
@@ -218,11 +226,11 @@ static AST_XML_DECLARATION_NODE_T* parser_parse_xml_declaration(parser_T* parser
     }
 
     token_T* token = parser_advance(parser);
-    hb_buffer_append(&content, token->value);
+    parser_text_append(&content, token);
     token_free(token);
   }
 
-  parser_append_literal_node_from_buffer(parser, &content, children, start);
+  parser_append_literal_node_from_text(parser, &content, children, start);
 
   token_T* tag_closing = parser_consume_expected(parser, TOKEN_XML_DECLARATION_END, errors);
 
@@ -232,12 +240,13 @@ static AST_XML_DECLARATION_NODE_T* parser_parse_xml_declaration(parser_T* parser
     tag_closing,
     tag_opening->location.start,
     tag_closing->location.end,
-    errors
+    errors,
+    parser->allocator
   );
 
   token_free(tag_opening);
   token_free(tag_closing);
-  free(content.value);
+  parser_text_free(&content);
 
   return xml_declaration;
 }
@@ -245,8 +254,8 @@ static AST_XML_DECLARATION_NODE_T* parser_parse_xml_declaration(parser_T* parser
 static AST_HTML_TEXT_NODE_T* parser_parse_text_content(parser_T* parser, hb_array_T* document_errors) {
   position_T start = parser->current_token->location.start;
 
-  hb_buffer_T content;
-  hb_buffer_init(&content, 2048);
+  parser_text_T content;
+  parser_text_init(&content);
 
   while (token_is_none_of(
     parser,
@@ -258,7 +267,7 @@ static AST_HTML_TEXT_NODE_T* parser_parse_text_content(parser_T* parser, hb_arra
     TOKEN_EOF
   )) {
     if (token_is(parser, TOKEN_ERROR)) {
-      free(content.value);
+      parser_text_free(&content);
 
       parser_append_unexpected_error_string(parser, document_errors, "Token Error", "not an error token");
 
@@ -267,55 +276,51 @@ static AST_HTML_TEXT_NODE_T* parser_parse_text_content(parser_T* parser, hb_arra
 
     if (parser->options.strict && parser->current_token->type == TOKEN_PERCENT) {
       lexer_T lexer_copy = *parser->lexer;
-      token_T* peek_token = lexer_next_token(&lexer_copy);
+      const token_T* peek_token = lexer_scan_token(&lexer_copy);
 
-      if (peek_token && peek_token->type == TOKEN_HTML_TAG_END) {
+      if (peek_token->type == TOKEN_HTML_TAG_END) {
         position_T stray_start = parser->current_token->location.start;
         position_T stray_end = peek_token->location.end;
-        token_free(peek_token);
 
         append_strayerb_closing_tag_error(stray_start, stray_end, document_errors);
 
         token_T* percent = parser_advance(parser);
-        hb_buffer_append(&content, percent->value);
+        parser_text_append(&content, percent);
         token_free(percent);
 
         token_T* gt = parser_advance(parser);
-        hb_buffer_append(&content, gt->value);
+        parser_text_append(&content, gt);
         token_free(gt);
 
         continue;
       }
-
-      token_free(peek_token);
     }
 
     token_T* token = parser_advance(parser);
-    hb_buffer_append(&content, token->value);
+    parser_text_append(&content, token);
     token_free(token);
   }
 
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
 
-  AST_HTML_TEXT_NODE_T* text_node = NULL;
-
-  if (hb_buffer_length(&content) > 0) {
-    text_node =
-      ast_html_text_node_init(hb_buffer_value(&content), start, parser->current_token->location.start, errors);
-  } else {
-    text_node = ast_html_text_node_init("", start, parser->current_token->location.start, errors);
-  }
+  AST_HTML_TEXT_NODE_T* text_node = ast_html_text_node_init_from_string(
+    parser_text_value(&content),
+    start,
+    parser->current_token->location.start,
+    errors,
+    parser->allocator
+  );
 
-  free(content.value);
+  parser_text_free(&content);
 
   return text_node;
 }
 
 static AST_HTML_ATTRIBUTE_NAME_NODE_T* parser_parse_html_attribute_name(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
-  hb_array_T* children = hb_array_init(8);
-  hb_buffer_T buffer;
-  hb_buffer_init(&buffer, 128);
+  hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
+  hb_array_T* children = hb_array_init_arena(parser->allocator, 8);
+  parser_text_T buffer;
+  parser_text_init(&buffer);
   position_T start = parser->current_token->location.start;
 
   while (token_is_none_of(
@@ -328,18 +333,17 @@ static AST_HTML_ATTRIBUTE_NAME_NODE_T* parser_parse_html_attribute_name(parser_T
     TOKEN_EOF
   )) {
     if (token_is(parser, TOKEN_ERB_START)) {
-      const char* tag = parser->current_token->value;
-      size_t tag_length = strlen(tag);
-      bool is_output_tag = (tag_length >= 3 && tag[2] == '=');
+      hb_string_T tag = parser->current_token->value;
+      bool is_output_tag = (tag.length >= 3 && tag.data[2] == '=');
 
       if (!is_output_tag) {
         bool is_control_flow = parser_lookahead_erb_is_control_flow(parser);
 
-        if (hb_buffer_is_empty(&buffer) && hb_array_size(children) == 0) { break; }
+        if (parser_text_is_empty(&buffer) && hb_array_size(children) == 0) { break; }
         if (is_control_flow) { break; }
       }
 
-      parser_append_literal_node_from_buffer(parser, &buffer, children, start);
+      parser_append_literal_node_from_text(parser, &buffer, children, start);
 
       AST_ERB_CONTENT_NODE_T* erb_node = parser_parse_erb_tag(parser);
       hb_array_append(children, erb_node);
@@ -349,11 +353,11 @@ static AST_HTML_ATTRIBUTE_NAME_NODE_T* parser_parse_html_attribute_name(parser_T
     }
 
     token_T* token = parser_advance(parser);
-    hb_buffer_append(&buffer, token->value);
+    parser_text_append(&buffer, token);
     token_free(token);
   }
 
-  parser_append_literal_node_from_buffer(parser, &buffer, children, start);
+  parser_append_literal_node_from_text(parser, &buffer, children, start);
 
   position_T node_start = { 0 };
   position_T node_end = { 0 };
@@ -370,9 +374,9 @@ static AST_HTML_ATTRIBUTE_NAME_NODE_T* parser_parse_html_attribute_name(parser_T
   }
 
   AST_HTML_ATTRIBUTE_NAME_NODE_T* attribute_name =
-    ast_html_attribute_name_node_init(children, node_start, node_end, errors);
+    ast_html_attribute_name_node_init(children, node_start, node_end, errors, parser->allocator);
 
-  free(buffer.value);
+  parser_text_free(&buffer);
 
   return attribute_name;
 }
@@ -382,40 +386,35 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
   hb_array_T* children,
   hb_array_T* errors
 ) {
-  hb_buffer_T buffer;
-  hb_buffer_init(&buffer, 512);
+  parser_text_T buffer;
+  parser_text_init(&buffer);
   token_T* opening_quote = parser_consume_expected(parser, TOKEN_QUOTE, errors);
   position_T start = parser->current_token->location.start;
 
   while (!token_is(parser, TOKEN_EOF)
          && !(
            token_is(parser, TOKEN_QUOTE) && opening_quote != NULL
-           && string_equals(parser->current_token->value, opening_quote->value)
+           && hb_string_equals(parser->current_token->value, opening_quote->value)
          )) {
     if (token_is(parser, TOKEN_HTML_TAG_END) || token_is(parser, TOKEN_HTML_TAG_SELF_CLOSE)) {
       lexer_state_snapshot_T saved_state = lexer_save_state(parser->lexer);
       bool found_closing_quote = false;
-      token_T* lookahead = lexer_next_token(parser->lexer);
+      const token_T* lookahead = lexer_scan_token(parser->lexer);
 
-      while (lookahead && lookahead->type != TOKEN_EOF) {
+      while (lookahead->type != TOKEN_EOF) {
         if (lookahead->type == TOKEN_QUOTE && opening_quote != NULL
-            && string_equals(lookahead->value, opening_quote->value)) {
+            && hb_string_equals(lookahead->value, opening_quote->value)) {
           found_closing_quote = true;
-          token_free(lookahead);
           break;
         }
 
-        token_free(lookahead);
-
-        lookahead = lexer_next_token(parser->lexer);
+        lookahead = lexer_scan_token(parser->lexer);
       }
 
-      if (lookahead && !found_closing_quote && lookahead->type == TOKEN_EOF) { token_free(lookahead); }
-
       lexer_restore_state(parser->lexer, saved_state);
 
       if (found_closing_quote) {
-        hb_buffer_append(&buffer, parser->current_token->value);
+        parser_text_append(&buffer, parser->current_token);
         token_free(parser->current_token);
         parser->current_token = lexer_next_token(parser->lexer);
         continue;
@@ -428,8 +427,8 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
         errors
       );
 
-      parser_append_literal_node_from_buffer(parser, &buffer, children, start);
-      free(buffer.value);
+      parser_append_literal_node_from_text(parser, &buffer, children, start);
+      parser_text_free(&buffer);
 
       AST_HTML_ATTRIBUTE_VALUE_NODE_T* attribute_value = ast_html_attribute_value_node_init(
         opening_quote,
@@ -438,7 +437,8 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
         true,
         opening_quote->location.start,
         parser->current_token->location.start,
-        errors
+        errors,
+        parser->allocator
       );
 
       token_free(opening_quote);
@@ -446,21 +446,18 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
       return attribute_value;
     }
 
-    bool buffer_ends_with_whitespace = buffer.length > 0 && is_whitespace(buffer.value[buffer.length - 1]);
+    hb_string_T buffer_value = parser_text_value(&buffer);
+    bool buffer_ends_with_whitespace =
+      buffer_value.length > 0 && is_whitespace(buffer_value.data[buffer_value.length - 1]);
 
     if (token_is(parser, TOKEN_IDENTIFIER) && buffer_ends_with_whitespace) {
       lexer_state_snapshot_T saved_state = lexer_save_state(parser->lexer);
-      token_T* equals_token = lexer_next_token(parser->lexer);
       bool looks_like_new_attribute = false;
 
-      if (equals_token && equals_token->type == TOKEN_EQUALS) {
-        token_T* after_equals = lexer_next_token(parser->lexer);
-        looks_like_new_attribute = (after_equals && after_equals->type == TOKEN_QUOTE);
-
-        if (after_equals) { token_free(after_equals); }
+      if (lexer_scan_token(parser->lexer)->type == TOKEN_EQUALS) {
+        looks_like_new_attribute = lexer_scan_token(parser->lexer)->type == TOKEN_QUOTE;
       }
 
-      if (equals_token) { token_free(equals_token); }
       lexer_restore_state(parser->lexer, saved_state);
 
       if (looks_like_new_attribute) {
@@ -471,8 +468,8 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
           errors
         );
 
-        parser_append_literal_node_from_buffer(parser, &buffer, children, start);
-        free(buffer.value);
+        parser_append_literal_node_from_text(parser, &buffer, children, start);
+        parser_text_free(&buffer);
 
         AST_HTML_ATTRIBUTE_VALUE_NODE_T* attribute_value = ast_html_attribute_value_node_init(
           opening_quote,
@@ -481,7 +478,8 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
           true,
           opening_quote->location.start,
           parser->current_token->location.start,
-          errors
+          errors,
+          parser->allocator
         );
 
         token_free(opening_quote);
@@ -491,7 +489,7 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
     }
 
     if (token_is(parser, TOKEN_ERB_START)) {
-      parser_append_literal_node_from_buffer(parser, &buffer, children, start);
+      parser_append_literal_node_from_text(parser, &buffer, children, start);
 
       hb_array_append(children, parser_parse_erb_tag(parser));
 
@@ -500,45 +498,49 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
       continue;
     }
 
-    hb_buffer_append(&buffer, parser->current_token->value);
+    parser_text_append(&buffer, parser->current_token);
     token_free(parser->current_token);
 
     parser->current_token = lexer_next_token(parser->lexer);
   }
 
   if (token_is(parser, TOKEN_QUOTE) && opening_quote != NULL
-      && string_equals(parser->current_token->value, opening_quote->value)) {
+      && hb_string_equals(parser->current_token->value, opening_quote->value)) {
     lexer_state_snapshot_T saved_state = lexer_save_state(parser->lexer);
 
     token_T* potential_closing = parser->current_token;
     parser->current_token = lexer_next_token(parser->lexer);
 
     if (token_is(parser, TOKEN_IDENTIFIER) || token_is(parser, TOKEN_CHARACTER)) {
+      char* quote = token_value_to_c_string(opening_quote);
+
       append_unexpected_error(
         "Unescaped quote character in attribute value",
         "HTML entity (&apos;/&quot;) or different quote style",
-        opening_quote->value,
+        quote,
         potential_closing->location.start,
         potential_closing->location.end,
         errors
       );
 
+      free(quote);
+
       lexer_restore_state(parser->lexer, saved_state);
 
       token_free(parser->current_token);
       parser->current_token = potential_closing;
 
-      hb_buffer_append(&buffer, parser->current_token->value);
+      parser_text_append(&buffer, parser->current_token);
       token_free(parser->current_token);
       parser->current_token = lexer_next_token(parser->lexer);
 
       while (!token_is(parser, TOKEN_EOF)
              && !(
                token_is(parser, TOKEN_QUOTE) && opening_quote != NULL
-               && string_equals(parser->current_token->value, opening_quote->value)
+               && hb_string_equals(parser->current_token->value, opening_quote->value)
              )) {
         if (token_is(parser, TOKEN_ERB_START)) {
-          parser_append_literal_node_from_buffer(parser, &buffer, children, start);
+          parser_append_literal_node_from_text(parser, &buffer, children, start);
 
           hb_array_append(children, parser_parse_erb_tag(parser));
 
@@ -547,7 +549,7 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
           continue;
         }
 
-        hb_buffer_append(&buffer, parser->current_token->value);
+        parser_text_append(&buffer, parser->current_token);
         token_free(parser->current_token);
 
         parser->current_token = lexer_next_token(parser->lexer);
@@ -560,8 +562,8 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
     }
   }
 
-  parser_append_literal_node_from_buffer(parser, &buffer, children, start);
-  free(buffer.value);
+  parser_append_literal_node_from_text(parser, &buffer, children, start);
+  parser_text_free(&buffer);
 
   token_T* closing_quote = parser_consume_expected(parser, TOKEN_QUOTE, errors);
 
@@ -572,7 +574,8 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
     true,
     opening_quote->location.start,
     closing_quote->location.end,
-    errors
+    errors,
+    parser->allocator
   );
 
   token_free(opening_quote);
@@ -582,8 +585,8 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_quoted_html_attribute_value
 }
 
 static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_html_attribute_value(parser_T* parser) {
-  hb_array_T* children = hb_array_init(8);
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* children = hb_array_init_arena(parser->allocator, 8);
+  hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
 
   // <div id=<%= "home" %>>
   if (token_is(parser, TOKEN_ERB_START)) {
@@ -597,14 +600,15 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_html_attribute_value(parser
       false,
       erb_node->base.location.start,
       erb_node->base.location.end,
-      errors
+      errors,
+      parser->allocator
     );
   }
 
   // <div id=home>
   if (token_is(parser, TOKEN_IDENTIFIER)) {
     token_T* identifier = parser_consume_expected(parser, TOKEN_IDENTIFIER, errors);
-    AST_LITERAL_NODE_T* literal = ast_literal_node_init_from_token(identifier);
+    AST_LITERAL_NODE_T* literal = ast_literal_node_init_from_token(identifier, parser->allocator);
     token_free(identifier);
 
     hb_array_append(children, literal);
@@ -616,7 +620,8 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_html_attribute_value(parser
       false,
       literal->base.location.start,
       literal->base.location.end,
-      errors
+      errors,
+      parser->allocator
     );
   }
 
@@ -638,7 +643,7 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_html_attribute_value(parser
     );
 
     AST_HTML_ATTRIBUTE_VALUE_NODE_T* value =
-      ast_html_attribute_value_node_init(NULL, children, NULL, false, start, end, errors);
+      ast_html_attribute_value_node_init(NULL, children, NULL, false, start, end, errors, parser->allocator);
 
     token_free(token);
 
@@ -665,7 +670,8 @@ static AST_HTML_ATTRIBUTE_VALUE_NODE_T* parser_parse_html_attribute_value(parser
     false,
     parser->current_token->location.start,
     parser->current_token->location.end,
-    errors
+    errors,
+    parser->allocator
   );
 
   return value;
@@ -679,8 +685,6 @@ static AST_HTML_ATTRIBUTE_NODE_T* parser_parse_html_attribute(parser_T* parser)
                    || lexer_peek_for_token_type_after_whitespace(parser->lexer, TOKEN_EQUALS);
 
     if (has_equals) {
-      hb_buffer_T equals_buffer;
-      hb_buffer_init(&equals_buffer, 256);
       position_T equals_start = { 0 };
       position_T equals_end = { 0 };
       uint32_t range_start = 0;
@@ -696,7 +700,6 @@ static AST_HTML_ATTRIBUTE_NODE_T* parser_parse_html_attribute(parser_T* parser)
           range_start = whitespace->range.from;
         }
 
-        hb_buffer_append(&equals_buffer, whitespace->value);
         token_free(whitespace);
       }
 
@@ -708,51 +711,38 @@ static AST_HTML_ATTRIBUTE_NODE_T* parser_parse_html_attribute(parser_T* parser)
         range_start = equals->range.from;
       }
 
-      hb_buffer_append(&equals_buffer, equals->value);
       equals_end = equals->location.end;
       range_end = equals->range.to;
       token_free(equals);
 
       while (token_is_any_of(parser, TOKEN_WHITESPACE, TOKEN_NEWLINE)) {
         token_T* whitespace = parser_advance(parser);
-        hb_buffer_append(&equals_buffer, whitespace->value);
         equals_end = whitespace->location.end;
         range_end = whitespace->range.to;
         token_free(whitespace);
       }
 
-      token_T* equals_with_whitespace = calloc(1, sizeof(token_T));
-
-      if (!equals_with_whitespace) {
-        free(equals_buffer.value);
-
-        return ast_html_attribute_node_init(
-          attribute_name,
-          NULL,
-          NULL,
-          attribute_name->base.location.start,
-          attribute_name->base.location.end,
-          NULL
-        );
-      }
-
-      equals_with_whitespace->type = TOKEN_EQUALS;
-      equals_with_whitespace->value = herb_strdup(equals_buffer.value);
-      equals_with_whitespace->location = (location_T) { .start = equals_start, .end = equals_end };
-      equals_with_whitespace->range = (range_T) { .from = range_start, .to = range_end };
-
-      free(equals_buffer.value);
+      token_T equals_with_whitespace = {
+        .allocator = NULL,
+        .value = hb_string_range(parser->lexer->source, range_start, range_end),
+        .range = (range_T) { .from = range_start, .to = range_end },
+        .location = (location_T) { .start = equals_start, .end = equals_end },
+        .type = TOKEN_EQUALS,
+      };
 
       AST_HTML_ATTRIBUTE_VALUE_NODE_T* attribute_value = parser_parse_html_attribute_value(parser);
 
-      return ast_html_attribute_node_init(
+      AST_HTML_ATTRIBUTE_NODE_T* attribute_node = ast_html_attribute_node_init(
         attribute_name,
-        equals_with_whitespace,
+        &equals_with_whitespace,
         attribute_value,
         attribute_name->base.location.start,
         attribute_value->base.location.end,
-        NULL
+        NULL,
+        parser->allocator
       );
+
+      return attribute_node;
     } else {
       return ast_html_attribute_node_init(
         attribute_name,
@@ -760,7 +750,8 @@ static AST_HTML_ATTRIBUTE_NODE_T* parser_parse_html_attribute(parser_T* parser)
         NULL,
         attribute_name->base.location.start,
         attribute_name->base.location.end,
-        NULL
+        NULL,
+        parser->allocator
       );
     }
   } else {
@@ -774,7 +765,7 @@ static AST_HTML_ATTRIBUTE_NODE_T* parser_parse_html_attribute(parser_T* parser)
 
     // <div class= >
     if (token_is(parser, TOKEN_HTML_TAG_END) || token_is(parser, TOKEN_HTML_TAG_SELF_CLOSE)) {
-      hb_array_T* errors = hb_array_init(8);
+      hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
       char* attribute_name_string = NULL;
 
       if (hb_array_size(attribute_name->children) > 0) {
@@ -794,12 +785,13 @@ static AST_HTML_ATTRIBUTE_NODE_T* parser_parse_html_attribute(parser_T* parser)
 
       AST_HTML_ATTRIBUTE_VALUE_NODE_T* empty_value = ast_html_attribute_value_node_init(
         NULL,
-        hb_array_init(8),
+        hb_array_init_arena(parser->allocator, 8),
         NULL,
         false,
         equals->location.end,
         parser->current_token->location.start,
-        errors
+        errors,
+        parser->allocator
       );
 
       AST_HTML_ATTRIBUTE_NODE_T* attribute_node = ast_html_attribute_node_init(
@@ -808,7 +800,8 @@ static AST_HTML_ATTRIBUTE_NODE_T* parser_parse_html_attribute(parser_T* parser)
         empty_value,
         attribute_name->base.location.start,
         parser->current_token->location.start,
-        NULL
+        NULL,
+        parser->allocator
       );
 
       token_free(equals);
@@ -824,7 +817,8 @@ static AST_HTML_ATTRIBUTE_NODE_T* parser_parse_html_attribute(parser_T* parser)
       attribute_value,
       attribute_name->base.location.start,
       attribute_value->base.location.end,
-      NULL
+      NULL,
+      parser->allocator
     );
 
     token_free(equals);
@@ -838,94 +832,72 @@ static AST_HTML_ATTRIBUTE_NODE_T* parser_parse_html_attribute(parser_T* parser)
     NULL,
     attribute_name->base.location.start,
     attribute_name->base.location.end,
-    NULL
+    NULL,
+    parser->allocator
   );
 }
 
 static void parser_skip_erb_content(lexer_T* lexer) {
-  token_T* token = NULL;
+  token_type_T type;
 
   do {
-    token = lexer_next_token(lexer);
-
-    if (token->type == TOKEN_ERB_END) {
-      token_free(token);
-      break;
-    }
-
-    token_free(token);
-  } while (true);
+    type = lexer_scan_token(lexer)->type;
+  } while (type != TOKEN_ERB_END && type != TOKEN_EOF);
 }
 
 static bool parser_lookahead_erb_is_attribute(lexer_T* lexer) {
-  token_T* after = NULL;
-
   do {
-    after = lexer_next_token(lexer);
+    token_type_T type = lexer_scan_token(lexer)->type;
 
-    if (after->type == TOKEN_EQUALS) {
-      token_free(after);
-      return true;
-    }
+    if (type == TOKEN_EQUALS) { return true; }
 
-    if (after->type == TOKEN_WHITESPACE || after->type == TOKEN_NEWLINE) {
-      token_free(after);
-      continue;
-    }
+    if (type == TOKEN_WHITESPACE || type == TOKEN_NEWLINE) { continue; }
 
-    if (after->type == TOKEN_IDENTIFIER || after->type == TOKEN_CHARACTER || after->type == TOKEN_DASH
-        || after->type == TOKEN_ERB_START) {
+    if (type == TOKEN_IDENTIFIER || type == TOKEN_CHARACTER || type == TOKEN_DASH || type == TOKEN_ERB_START) {
+      if (type == TOKEN_ERB_START) { parser_skip_erb_content(lexer); }
 
-      if (after->type == TOKEN_ERB_START) {
-        token_free(after);
-        parser_skip_erb_content(lexer);
-      } else {
-        token_free(after);
-      }
       continue;
     }
 
-    token_free(after);
     return false;
-
   } while (true);
 }
 
-static bool starts_with_keyword(const char* pointer, const char* keyword) {
-  size_t length = strlen(keyword);
-  if (strncmp(pointer, keyword, length) != 0) { return false; }
+static hb_string_T skip_whitespace_string(hb_string_T string) {
+  while (string.length > 0 && is_whitespace(string.data[0])) {
+    string.data++;
+    string.length--;
+  }
+
+  return string;
+}
 
-  char next = pointer[length];
+static bool starts_with_keyword(hb_string_T string, const char* keyword) {
+  hb_string_T expected = hb_string(keyword);
+  if (!hb_string_starts_with(string, expected)) { return false; }
 
-  return next == '\0' || is_whitespace(next);
+  return string.length == expected.length || is_whitespace(string.data[expected.length]);
 }
 
 // TODO: ideally we could avoid basing this off of strings, and use the step in analyze.c
 static bool parser_lookahead_erb_is_control_flow(parser_T* parser) {
   lexer_T lexer_copy = *parser->lexer;
-  token_T* content = lexer_next_token(&lexer_copy);
+  const token_T* content = lexer_scan_token(&lexer_copy);
 
-  if (content == NULL || content->type != TOKEN_ERB_CONTENT) {
-    if (content) { token_free(content); }
+  if (content->type != TOKEN_ERB_CONTENT) { return false; }
 
-    return false;
-  }
-
-  const char* pointer = skip_whitespace(content->value);
+  hb_string_T pointer = skip_whitespace_string(content->value);
 
   bool is_control_flow = starts_with_keyword(pointer, "end") || starts_with_keyword(pointer, "else")
                       || starts_with_keyword(pointer, "elsif") || starts_with_keyword(pointer, "in")
                       || starts_with_keyword(pointer, "when") || starts_with_keyword(pointer, "rescue")
                       || starts_with_keyword(pointer, "ensure");
 
-  token_free(content);
-
   return is_control_flow;
 }
 
 static void parser_handle_erb_in_open_tag(parser_T* parser, hb_array_T* children) {
-  bool is_output_tag = parser->current_token->value && strlen(parser->current_token->value) >= 3
-                    && strncmp(parser->current_token->value, "<%=", 3) == 0;
+  bool is_output_tag = hb_string_starts_with(parser->current_token->value, hb_string("<%="));
 
   if (!is_output_tag) {
     hb_array_append(children, parser_parse_erb_tag(parser));
@@ -935,8 +907,7 @@ static void parser_handle_erb_in_open_tag(parser_T* parser, hb_array_T* children
 
   lexer_T lexer_copy = *parser->lexer;
 
-  token_T* erb_start = lexer_next_token(&lexer_copy);
-  token_free(erb_start);
+  lexer_scan_token(&lexer_copy);
   parser_skip_erb_content(&lexer_copy);
 
   bool looks_like_attribute = parser_lookahead_erb_is_attribute(&lexer_copy);
@@ -962,8 +933,8 @@ static void parser_handle_whitespace_in_open_tag(parser_T* parser, hb_array_T* c
 }
 
 static AST_HTML_OPEN_TAG_NODE_T* parser_parse_html_open_tag(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
-  hb_array_T* children = hb_array_init(8);
+  hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
+  hb_array_T* children = hb_array_init_arena(parser->allocator, 8);
 
   token_T* tag_start = parser_consume_expected(parser, TOKEN_HTML_TAG_START, errors);
   token_T* tag_name = parser_consume_expected(parser, TOKEN_IDENTIFIER, errors);
@@ -980,7 +951,8 @@ static AST_HTML_OPEN_TAG_NODE_T* parser_parse_html_open_tag(parser_T* parser) {
         false,
         tag_start->location.start,
         parser->current_token->location.start,
-        errors
+        errors,
+        parser->allocator
       );
 
       token_free(tag_start);
@@ -1011,33 +983,28 @@ static AST_HTML_OPEN_TAG_NODE_T* parser_parse_html_open_tag(parser_T* parser) {
 
     if (parser->current_token->type == TOKEN_COLON) {
       lexer_T lexer_copy = *parser->lexer;
-      token_T* next_token = lexer_next_token(&lexer_copy);
 
-      if (next_token && next_token->type == TOKEN_IDENTIFIER) {
-        token_free(next_token);
+      if (lexer_scan_token(&lexer_copy)->type == TOKEN_IDENTIFIER) {
         hb_array_append(children, parser_parse_html_attribute(parser));
 
         continue;
       }
-
-      token_free(next_token);
     }
 
     if (parser->current_token->type == TOKEN_PERCENT) {
       lexer_T lexer_copy = *parser->lexer;
-      token_T* peek_token = lexer_next_token(&lexer_copy);
+      const token_T* peek_token = lexer_scan_token(&lexer_copy);
 
-      if (peek_token && peek_token->type == TOKEN_HTML_TAG_END) {
+      if (peek_token->type == TOKEN_HTML_TAG_END) {
         position_T stray_start = parser->current_token->location.start;
         position_T stray_end = peek_token->location.end;
-        token_free(peek_token);
 
         append_strayerb_closing_tag_error(stray_start, stray_end, errors);
 
         token_T* percent = parser_advance(parser);
         token_T* gt = parser_advance(parser);
 
-        AST_LITERAL_NODE_T* literal = ast_literal_node_init("%>", stray_start, stray_end, NULL);
+        AST_LITERAL_NODE_T* literal = ast_literal_node_init("%>", stray_start, stray_end, NULL, parser->allocator);
         hb_array_append(children, literal);
 
         token_free(percent);
@@ -1045,8 +1012,6 @@ static AST_HTML_OPEN_TAG_NODE_T* parser_parse_html_open_tag(parser_T* parser) {
 
         continue;
       }
-
-      token_free(peek_token);
     }
 
     parser_append_unexpected_error(
@@ -1072,7 +1037,8 @@ static AST_HTML_OPEN_TAG_NODE_T* parser_parse_html_open_tag(parser_T* parser) {
       false,
       tag_start->location.start,
       parser->current_token->location.start,
-      errors
+      errors,
+      parser->allocator
     );
 
     token_free(tag_start);
@@ -1109,7 +1075,8 @@ static AST_HTML_OPEN_TAG_NODE_T* parser_parse_html_open_tag(parser_T* parser) {
     is_self_closing,
     tag_start->location.start,
     tag_end->location.end,
-    errors
+    errors,
+    parser->allocator
   );
 
   token_free(tag_start);
@@ -1120,8 +1087,8 @@ static AST_HTML_OPEN_TAG_NODE_T* parser_parse_html_open_tag(parser_T* parser) {
 }
 
 static AST_HTML_CLOSE_TAG_NODE_T* parser_parse_html_close_tag(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
-  hb_array_T* children = hb_array_init(8);
+  hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
+  hb_array_T* children = hb_array_init_arena(parser->allocator, 8);
 
   token_T* tag_opening = parser_consume_expected(parser, TOKEN_HTML_TAG_START_CLOSE, errors);
 
@@ -1137,10 +1104,10 @@ static AST_HTML_CLOSE_TAG_NODE_T* parser_parse_html_close_tag(parser_T* parser)
     append_unclosed_close_tag_error(tag_name, tag_opening->location.start, tag_name->location.end, errors);
   }
 
-  if (tag_closing != NULL && tag_name != NULL && is_void_element(hb_string(tag_name->value))
+  if (tag_closing != NULL && tag_name != NULL && is_void_element(tag_name->value)
       && parser_in_svg_context(parser) == false) {
-    hb_string_T expected = html_self_closing_tag_string(hb_string(tag_name->value));
-    hb_string_T got = html_closing_tag_string(hb_string(tag_name->value));
+    hb_string_T expected = html_self_closing_tag_string(tag_name->value);
+    hb_string_T got = html_closing_tag_string(tag_name->value);
 
     append_void_element_closing_tag_error(
       tag_name,
@@ -1164,7 +1131,8 @@ static AST_HTML_CLOSE_TAG_NODE_T* parser_parse_html_close_tag(parser_T* parser)
     tag_closing,
     tag_opening->location.start,
     end_position,
-    errors
+    errors,
+    parser->allocator
   );
 
   token_free(tag_opening);
@@ -1188,7 +1156,8 @@ static AST_HTML_ELEMENT_NODE_T* parser_parse_html_self_closing_element(
     ELEMENT_SOURCE_HTML,
     open_tag->base.location.start,
     open_tag->base.location.end,
-    NULL
+    NULL,
+    parser->allocator
   );
 }
 
@@ -1196,13 +1165,13 @@ static AST_HTML_ELEMENT_NODE_T* parser_parse_html_regular_element(
   parser_T* parser,
   AST_HTML_OPEN_TAG_NODE_T* open_tag
 ) {
-  hb_array_T* errors = hb_array_init(8);
-  hb_array_T* body = hb_array_init(8);
+  hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
+  hb_array_T* body = hb_array_init_arena(parser->allocator, 8);
 
   parser_push_open_tag(parser, open_tag->tag_name);
 
-  if (open_tag->tag_name->value && parser_is_foreign_content_tag(hb_string(open_tag->tag_name->value))) {
-    foreign_content_type_T content_type = parser_get_foreign_content_type(hb_string(open_tag->tag_name->value));
+  if (parser_is_foreign_content_tag(open_tag->tag_name->value)) {
+    foreign_content_type_T content_type = parser_get_foreign_content_type(open_tag->tag_name->value);
     parser_enter_foreign_content(parser, content_type);
     parser_parse_foreign_content(parser, body, errors);
   } else {
@@ -1213,19 +1182,19 @@ static AST_HTML_ELEMENT_NODE_T* parser_parse_html_regular_element(
 
   AST_HTML_CLOSE_TAG_NODE_T* close_tag = parser_parse_html_close_tag(parser);
 
-  if (parser_in_svg_context(parser) == false && is_void_element(hb_string(close_tag->tag_name->value))) {
+  if (parser_in_svg_context(parser) == false && is_void_element(close_tag->tag_name->value)) {
     hb_array_push(body, close_tag);
     parser_parse_in_data_state(parser, body, errors);
     close_tag = parser_parse_html_close_tag(parser);
   }
 
-  bool matches_stack = parser_check_matching_tag(parser, hb_string(close_tag->tag_name->value));
+  bool matches_stack = parser_check_matching_tag(parser, close_tag->tag_name->value);
 
   if (matches_stack) {
     token_T* popped_token = parser_pop_open_tag(parser);
     token_free(popped_token);
-  } else if (parser_can_close_ancestor(parser, hb_string(close_tag->tag_name->value))) {
-    size_t depth = parser_find_ancestor_depth(parser, hb_string(close_tag->tag_name->value));
+  } else if (parser_can_close_ancestor(parser, close_tag->tag_name->value)) {
+    size_t depth = parser_find_ancestor_depth(parser, close_tag->tag_name->value);
 
     for (size_t i = 0; i < depth; i++) {
       token_T* unclosed = parser_pop_open_tag(parser);
@@ -1251,7 +1220,8 @@ static AST_HTML_ELEMENT_NODE_T* parser_parse_html_regular_element(
     ELEMENT_SOURCE_HTML,
     open_tag->base.location.start,
     close_tag->base.location.end,
-    errors
+    errors,
+    parser->allocator
   );
 }
 
@@ -1264,11 +1234,11 @@ static AST_NODE_T* parser_parse_html_element(parser_T* parser) {
   if (open_tag->is_void) { return (AST_NODE_T*) parser_parse_html_self_closing_element(parser, open_tag); }
 
   // <tag>, in void element list, and not in inside an <svg> element
-  if (!open_tag->is_void && is_void_element(hb_string(open_tag->tag_name->value)) && !parser_in_svg_context(parser)) {
+  if (!open_tag->is_void && is_void_element(open_tag->tag_name->value) && !parser_in_svg_context(parser)) {
     return (AST_NODE_T*) parser_parse_html_self_closing_element(parser, open_tag);
   }
 
-  if (open_tag->tag_name->value && parser_is_foreign_content_tag(hb_string(open_tag->tag_name->value))) {
+  if (parser_is_foreign_content_tag(open_tag->tag_name->value)) {
     AST_HTML_ELEMENT_NODE_T* regular_element = parser_parse_html_regular_element(parser, open_tag);
 
     if (regular_element != NULL) { return (AST_NODE_T*) regular_element; }
@@ -1278,7 +1248,7 @@ static AST_NODE_T* parser_parse_html_element(parser_T* parser) {
 }
 
 static AST_ERB_CONTENT_NODE_T* parser_parse_erb_tag(parser_T* parser) {
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
 
   token_T* opening_tag = parser_consume_expected(parser, TOKEN_ERB_START, errors);
   token_T* content = parser_consume_expected(parser, TOKEN_ERB_CONTENT, errors);
@@ -1318,7 +1288,8 @@ static AST_ERB_CONTENT_NODE_T* parser_parse_erb_tag(parser_T* parser) {
     false,
     opening_tag->location.start,
     end_position,
-    errors
+    errors,
+    parser->allocator
   );
 
   token_free(opening_tag);
@@ -1329,21 +1300,21 @@ static AST_ERB_CONTENT_NODE_T* parser_parse_erb_tag(parser_T* parser) {
 }
 
 static void parser_parse_foreign_content(parser_T* parser, hb_array_T* children, hb_array_T* errors) {
-  hb_buffer_T content;
-  hb_buffer_init(&content, 1024);
+  parser_text_T content;
+  parser_text_init(&content);
   position_T start = parser->current_token->location.start;
   hb_string_T expected_closing_tag = parser_get_foreign_content_closing_tag(parser->foreign_content_type);
 
   if (hb_string_is_empty(expected_closing_tag)) {
     parser_exit_foreign_content(parser);
-    free(content.value);
+    parser_text_free(&content);
 
     return;
   }
 
   while (!token_is(parser, TOKEN_EOF)) {
     if (token_is(parser, TOKEN_ERB_START)) {
-      parser_append_literal_node_from_buffer(parser, &content, children, start);
+      parser_append_literal_node_from_text(parser, &content, children, start);
 
       AST_ERB_CONTENT_NODE_T* erb_node = parser_parse_erb_tag(parser);
       hb_array_append(children, erb_node);
@@ -1356,36 +1327,34 @@ static void parser_parse_foreign_content(parser_T* parser, hb_array_T* children,
     if (token_is(parser, TOKEN_HTML_TAG_START_CLOSE)) {
       lexer_state_snapshot_T saved_state = lexer_save_state(parser->lexer);
 
-      token_T* next_token = lexer_next_token(parser->lexer);
+      const token_T* next_token = lexer_scan_token(parser->lexer);
       bool is_potential_match = false;
 
-      if (next_token && next_token->type == TOKEN_IDENTIFIER && next_token->value) {
+      if (next_token->type == TOKEN_IDENTIFIER) {
         is_potential_match =
-          parser_is_expected_closing_tag_name(hb_string(next_token->value), parser->foreign_content_type);
+          parser_is_expected_closing_tag_name(next_token->value, parser->foreign_content_type);
       }
 
       lexer_restore_state(parser->lexer, saved_state);
 
-      if (next_token) { token_free(next_token); }
-
       if (is_potential_match) {
-        parser_append_literal_node_from_buffer(parser, &content, children, start);
+        parser_append_literal_node_from_text(parser, &content, children, start);
         parser_exit_foreign_content(parser);
 
-        free(content.value);
+        parser_text_free(&content);
 
         return;
       }
     }
 
     token_T* token = parser_advance(parser);
-    hb_buffer_append(&content, token->value);
+    parser_text_append(&content, token);
     token_free(token);
   }
 
-  parser_append_literal_node_from_buffer(parser, &content, children, start);
+  parser_append_literal_node_from_text(parser, &content, children, start);
   parser_exit_foreign_content(parser);
-  free(content.value);
+  parser_text_free(&content);
 }
 
 static void parser_parse_in_data_state(parser_T* parser, hb_array_T* children, hb_array_T* errors) {
@@ -1489,89 +1458,149 @@ static void parser_parse_in_data_state(parser_T* parser, hb_array_T* children, h
   }
 }
 
-static size_t find_matching_close_tag(hb_array_T* nodes, size_t start_idx, hb_string_T tag_name) {
-  int depth = 0;
+// The unmatched open tags of one tag name, as the index of the most recent one. Older ones are chained through
+// `previous_open`, so every tag name gets its own stack without a separate allocation per name.
+typedef struct {
+  hb_string_T name;
+  size_t top;
+  bool used;
+} open_tag_stack_T;
+
+static uint64_t tag_name_hash(hb_string_T name) {
+  uint64_t hash = 14695981039346656037ULL;
+
+  for (uint32_t i = 0; i < name.length; i++) {
+    unsigned char character = (unsigned char) name.data[i];
+    if (character >= 'A' && character <= 'Z') { character += 'a' - 'A'; }
+
+    hash = (hash ^ character) * 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+// Finds the stack for `name` in the open-addressed table, or the empty slot it would go in.
+static open_tag_stack_T* open_tag_stack_lookup(open_tag_stack_T* stacks, size_t capacity, hb_string_T name) {
+  size_t slot = (size_t) tag_name_hash(name) & (capacity - 1);
+
+  while (stacks[slot].used && !hb_string_equals_case_insensitive(stacks[slot].name, name)) {
+    slot = (slot + 1) & (capacity - 1);
+  }
+
+  return &stacks[slot];
+}
+
+// Pairs every open tag with its closing tag in a single pass. A close tag matches the most recent
+// still-unmatched open tag with the same name, which is the first close tag a forward scan from the
+// open tag would reach at nesting depth zero. Each tag name has its own stack, so every close tag is
+// matched in constant time however many unclosed tags of other names are open. Unmatched entries
+// are `(size_t) -1`. Returns NULL when out of memory.
+static size_t* find_matching_close_tags(hb_array_T* nodes) {
+  size_t size = hb_array_size(nodes);
+  size_t capacity = 16;
+
+  while (capacity < size * 2) {
+    capacity <<= 1;
+  }
+
+  size_t* close_indices = malloc(MAX(size, 1) * sizeof(size_t));
+  size_t* previous_open = malloc(MAX(size, 1) * sizeof(size_t));
+  open_tag_stack_T* stacks = calloc(capacity, sizeof(open_tag_stack_T));
+
+  if (close_indices == NULL || previous_open == NULL || stacks == NULL) {
+    free(close_indices);
+    free(previous_open);
+    free(stacks);
+
+    return NULL;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    close_indices[i] = (size_t) -1;
 
-  for (size_t i = start_idx + 1; i < hb_array_size(nodes); i++) {
     AST_NODE_T* node = (AST_NODE_T*) hb_array_get(nodes, i);
     if (node == NULL) { continue; }
 
     if (node->type == AST_HTML_OPEN_TAG_NODE) {
-      AST_HTML_OPEN_TAG_NODE_T* open = (AST_HTML_OPEN_TAG_NODE_T*) node;
+      hb_string_T name = ((AST_HTML_OPEN_TAG_NODE_T*) node)->tag_name->value;
+      open_tag_stack_T* stack = open_tag_stack_lookup(stacks, capacity, name);
+
+      if (!stack->used) { *stack = (open_tag_stack_T) { .name = name, .top = (size_t) -1, .used = true }; }
 
-      if (hb_string_equals_case_insensitive(hb_string(open->tag_name->value), tag_name)) { depth++; }
+      previous_open[i] = stack->top;
+      stack->top = i;
     } else if (node->type == AST_HTML_CLOSE_TAG_NODE) {
-      AST_HTML_CLOSE_TAG_NODE_T* close = (AST_HTML_CLOSE_TAG_NODE_T*) node;
+      hb_string_T name = ((AST_HTML_CLOSE_TAG_NODE_T*) node)->tag_name->value;
+      open_tag_stack_T* stack = open_tag_stack_lookup(stacks, capacity, name);
 
-      if (hb_string_equals_case_insensitive(hb_string(close->tag_name->value), tag_name)) {
-        if (depth == 0) { return i; }
-        depth--;
-      }
+      if (!stack->used || stack->top == (size_t) -1) { continue; }
+
+      close_indices[stack->top] = i;
+      stack->top = previous_open[stack->top];
     }
   }
 
-  return (size_t) -1;
+  free(previous_open);
+  free(stacks);
+
+  return close_indices;
 }
 
-static size_t find_implicit_close_index(hb_array_T* nodes, size_t start_idx, hb_string_T tag_name) {
-  if (!has_optional_end_tag(tag_name)) { return (size_t) -1; }
+static size_t find_implicit_close_index(hb_array_T* nodes, size_t start_idx, size_t end_idx, hb_string_T tag_name) {
+  html_tag_T tag = html_tag_from_name(tag_name);
 
-  for (size_t i = start_idx + 1; i < hb_array_size(nodes); i++) {
+  if (!html_tag_has_optional_end(tag)) { return (size_t) -1; }
+
+  for (size_t i = start_idx + 1; i < end_idx; i++) {
     AST_NODE_T* node = (AST_NODE_T*) hb_array_get(nodes, i);
     if (node == NULL) { continue; }
 
     if (node->type == AST_HTML_OPEN_TAG_NODE) {
       AST_HTML_OPEN_TAG_NODE_T* open = (AST_HTML_OPEN_TAG_NODE_T*) node;
-      hb_string_T next_tag_name = hb_string(open->tag_name->value);
+      html_tag_T next_tag = html_tag_from_name(open->tag_name->value);
 
-      if (should_implicitly_close(tag_name, next_tag_name)) { return i; }
+      if (html_tag_implicitly_closed_by(tag, next_tag)) { return i; }
     } else if (node->type == AST_HTML_CLOSE_TAG_NODE) {
       AST_HTML_CLOSE_TAG_NODE_T* close = (AST_HTML_CLOSE_TAG_NODE_T*) node;
-      hb_string_T close_tag_name = hb_string(close->tag_name->value);
+      html_tag_T close_tag = html_tag_from_name(close->tag_name->value);
 
-      if (parent_closes_element(tag_name, close_tag_name)) { return i; }
+      if (html_tag_closed_by_parent(tag, close_tag)) { return i; }
     }
   }
 
-  return hb_array_size(nodes);
+  return end_idx;
 }
 
-static hb_array_T* parser_build_elements_from_tags(
-  hb_array_T* nodes,
-  hb_array_T* errors,
-  const parser_options_T* options
-);
-
-static hb_array_T* parser_build_elements_from_tags(
-  hb_array_T* nodes,
-  hb_array_T* errors,
-  const parser_options_T* options
-) {
-  bool strict = options ? options->strict : false;
-  hb_array_T* result = hb_array_init(hb_array_size(nodes));
-
-  for (size_t index = 0; index < hb_array_size(nodes); index++) {
+typedef struct {
+  hb_array_T* nodes;
+  size_t* close_indices;
+  bool strict;
+  hb_arena_T* allocator;
+} element_builder_T;
+
+// Builds elements out of `nodes[start_idx..end_idx)`. Element bodies are built recursively from
+// their own sub-range, so a close tag only pairs with an open tag when both are inside the range.
+static hb_array_T* parser_build_elements_in_range(element_builder_T* builder, size_t start_idx, size_t end_idx) {
+  hb_arena_T* allocator = builder->allocator;
+  hb_array_T* nodes = builder->nodes;
+  hb_array_T* result = hb_array_init_arena(allocator, end_idx - start_idx);
+
+  for (size_t index = start_idx; index < end_idx; index++) {
     AST_NODE_T* node = (AST_NODE_T*) hb_array_get(nodes, index);
     if (node == NULL) { continue; }
 
     if (node->type == AST_HTML_OPEN_TAG_NODE) {
       AST_HTML_OPEN_TAG_NODE_T* open_tag = (AST_HTML_OPEN_TAG_NODE_T*) node;
-      hb_string_T tag_name = hb_string(open_tag->tag_name->value);
+      hb_string_T tag_name = open_tag->tag_name->value;
 
-      size_t close_index = find_matching_close_tag(nodes, index, tag_name);
+      size_t close_index = builder->close_indices[index];
+      if (close_index != (size_t) -1 && close_index >= end_idx) { close_index = (size_t) -1; }
 
       if (close_index == (size_t) -1) {
-        size_t implicit_close_index = find_implicit_close_index(nodes, index, tag_name);
+        size_t implicit_close_index = find_implicit_close_index(nodes, index, end_idx, tag_name);
 
         if (implicit_close_index != (size_t) -1 && implicit_close_index > index + 1) {
-          hb_array_T* body = hb_array_init(implicit_close_index - index - 1);
-
-          for (size_t j = index + 1; j < implicit_close_index; j++) {
-            hb_array_append(body, hb_array_get(nodes, j));
-          }
-
-          hb_array_T* processed_body = parser_build_elements_from_tags(body, errors, options);
-          hb_array_free(&body);
+          hb_array_T* processed_body = parser_build_elements_in_range(builder, index + 1, implicit_close_index);
 
           position_T end_position = open_tag->base.location.end;
 
@@ -1580,9 +1609,9 @@ static hb_array_T* parser_build_elements_from_tags(
             if (last_body_node != NULL) { end_position = last_body_node->location.end; }
           }
 
-          hb_array_T* element_errors = hb_array_init(8);
+          hb_array_T* element_errors = hb_array_init_arena(allocator, 8);
 
-          if (strict) {
+          if (builder->strict) {
             append_omitted_closing_tag_error(
               open_tag->tag_name,
               end_position,
@@ -1592,8 +1621,13 @@ static hb_array_T* parser_build_elements_from_tags(
             );
           }
 
-          AST_HTML_OMITTED_CLOSE_TAG_NODE_T* omitted_close_tag =
-            ast_html_omitted_close_tag_node_init(open_tag->tag_name, end_position, end_position, hb_array_init(8));
+          AST_HTML_OMITTED_CLOSE_TAG_NODE_T* omitted_close_tag = ast_html_omitted_close_tag_node_init(
+            open_tag->tag_name,
+            end_position,
+            end_position,
+            hb_array_init_arena(allocator, 8),
+            allocator
+          );
 
           AST_HTML_ELEMENT_NODE_T* element = ast_html_element_node_init(
             (AST_NODE_T*) open_tag,
@@ -1604,7 +1638,8 @@ static hb_array_T* parser_build_elements_from_tags(
             ELEMENT_SOURCE_HTML,
             open_tag->base.location.start,
             end_position,
-            element_errors
+            element_errors,
+            allocator
           );
 
           hb_array_append(result, element);
@@ -1625,16 +1660,9 @@ static hb_array_T* parser_build_elements_from_tags(
       } else {
         AST_HTML_CLOSE_TAG_NODE_T* close_tag = (AST_HTML_CLOSE_TAG_NODE_T*) hb_array_get(nodes, close_index);
 
-        hb_array_T* body = hb_array_init(close_index - index - 1);
+        hb_array_T* processed_body = parser_build_elements_in_range(builder, index + 1, close_index);
 
-        for (size_t j = index + 1; j < close_index; j++) {
-          hb_array_append(body, hb_array_get(nodes, j));
-        }
-
-        hb_array_T* processed_body = parser_build_elements_from_tags(body, errors, options);
-        hb_array_free(&body);
-
-        hb_array_T* element_errors = hb_array_init(8);
+        hb_array_T* element_errors = hb_array_init_arena(allocator, 8);
 
         AST_HTML_ELEMENT_NODE_T* element = ast_html_element_node_init(
           (AST_NODE_T*) open_tag,
@@ -1645,7 +1673,8 @@ static hb_array_T* parser_build_elements_from_tags(
           ELEMENT_SOURCE_HTML,
           open_tag->base.location.start,
           close_tag->base.location.end,
-          element_errors
+          element_errors,
+          allocator
         );
 
         hb_array_append(result, element);
@@ -1655,7 +1684,7 @@ static hb_array_T* parser_build_elements_from_tags(
     } else if (node->type == AST_HTML_CLOSE_TAG_NODE) {
       AST_HTML_CLOSE_TAG_NODE_T* close_tag = (AST_HTML_CLOSE_TAG_NODE_T*) node;
 
-      if (!is_void_element(hb_string(close_tag->tag_name->value))) {
+      if (!is_void_element(close_tag->tag_name->value)) {
         if (hb_array_size(close_tag->base.errors) == 0) {
           append_missing_opening_tag_error(
             close_tag->tag_name,
@@ -1675,16 +1704,36 @@ static hb_array_T* parser_build_elements_from_tags(
   return result;
 }
 
+static hb_array_T* parser_build_elements_from_tags(
+  hb_array_T* nodes,
+  const parser_options_T* options,
+  hb_arena_T* allocator
+) {
+  element_builder_T builder = { .nodes = nodes,
+                                .close_indices = find_matching_close_tags(nodes),
+                                .strict = options ? options->strict : false,
+                                .allocator = allocator };
+
+  if (builder.close_indices == NULL) { return NULL; }
+
+  hb_array_T* result = parser_build_elements_in_range(&builder, 0, hb_array_size(nodes));
+
+  free(builder.close_indices);
+
+  return result;
+}
+
 static AST_DOCUMENT_NODE_T* parser_parse_document(parser_T* parser) {
-  hb_array_T* children = hb_array_init(8);
-  hb_array_T* errors = hb_array_init(8);
+  hb_array_T* children = hb_array_init_arena(parser->allocator, 8);
+  hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
   position_T start = parser->current_token->location.start;
 
   parser_parse_in_data_state(parser, children, errors);
 
   token_T* eof = parser_consume_expected(parser, TOKEN_EOF, errors);
 
-  AST_DOCUMENT_NODE_T* document_node = ast_document_node_init(children, start, eof->location.end, errors);
+  AST_DOCUMENT_NODE_T* document_node =
+    ast_document_node_init(children, start, eof->location.end, errors, parser->allocator);
 
   token_free(eof);
 
@@ -1697,12 +1746,13 @@ AST_DOCUMENT_NODE_T* herb_parser_parse(parser_T* parser) {
 
 static void parser_handle_whitespace(parser_T* parser, token_T* whitespace_token, hb_array_T* children) {
   if (parser->options.track_whitespace) {
-    hb_array_T* errors = hb_array_init(8);
+    hb_array_T* errors = hb_array_init_arena(parser->allocator, 8);
     AST_WHITESPACE_NODE_T* whitespace_node = ast_whitespace_node_init(
       whitespace_token,
       whitespace_token->location.start,
       whitespace_token->location.end,
-      errors
+      errors,
+      parser->allocator
     );
     hb_array_append(children, whitespace_node);
   }
@@ -1737,10 +1787,11 @@ void herb_parser_deinit(parser_T* parser) {
   }
 }
 
-void match_tags_in_node_array(hb_array_T* nodes, hb_array_T* errors, const parser_options_T* options) {
+void match_tags_in_node_array(hb_array_T* nodes, const parser_options_T* options) {
   if (nodes == NULL || hb_array_size(nodes) == 0) { return; }
 
-  hb_array_T* processed = parser_build_elements_from_tags(nodes, errors, options);
+  hb_array_T* processed = parser_build_elements_from_tags(nodes, options, nodes->allocator);
+  if (processed == NULL) { return; }
 
   nodes->size = 0;
 
@@ -1749,19 +1800,4 @@ void match_tags_in_node_array(hb_array_T* nodes, hb_array_T* errors, const parse
   }
 
   hb_array_free(&processed);
-
-  match_tags_context_T context = { .errors = errors, .options = options };
-
-  for (size_t i = 0; i < hb_array_size(nodes); i++) {
-    AST_NODE_T* node = (AST_NODE_T*) hb_array_get(nodes, i);
-    if (node == NULL) { continue; }
-
-    herb_visit_node(node, match_tags_visitor, &context);
-  }
-}
-
-void herb_parser_match_html_tags_post_analyze(AST_DOCUMENT_NODE_T* document, const parser_options_T* options) {
-  if (document == NULL) { return; }
-
-  match_tags_in_node_array(document->children, document->base.errors, options);
 }
@@ -1,4 +1,5 @@
 #include "include/parser_helpers.h"
+#include "include/ast_node.h"
 #include "include/ast_nodes.h"
 #include "include/errors.h"
 #include "include/lexer.h"
@@ -10,6 +11,7 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 void parser_push_open_tag(const parser_T* parser, token_T* tag_name) {
   token_T* copy = token_copy(tag_name);
@@ -20,9 +22,9 @@ bool parser_check_matching_tag(const parser_T* parser, hb_string_T tag_name) {
   if (hb_array_size(parser->open_tags_stack) == 0) { return false; }
 
   token_T* top_token = hb_array_last(parser->open_tags_stack);
-  if (top_token == NULL || top_token->value == NULL) { return false; };
+  if (top_token == NULL) { return false; };
 
-  return hb_string_equals_case_insensitive(hb_string(top_token->value), tag_name);
+  return hb_string_equals_case_insensitive(top_token->value, tag_name);
 }
 
 token_T* parser_pop_open_tag(const parser_T* parser) {
@@ -45,10 +47,7 @@ bool parser_in_svg_context(const parser_T* parser) {
   for (size_t i = 0; i < stack_size; i++) {
     token_T* tag = (token_T*) hb_array_get(parser->open_tags_stack, i);
 
-    if (tag && tag->value) {
-      hb_string_T tag_value_string = hb_string(tag->value);
-      if (hb_string_equals_case_insensitive(tag_value_string, hb_string("svg"))) { return true; }
-    }
+    if (tag && hb_string_equals_case_insensitive(tag->value, hb_string("svg"))) { return true; }
   }
 
   return false;
@@ -148,19 +147,81 @@ void parser_append_unexpected_token_error(parser_T* parser, token_type_T expecte
   );
 }
 
-void parser_append_literal_node_from_buffer(
+void parser_text_init(parser_text_T* text) {
+  text->view = (hb_string_T) { .data = NULL, .length = 0 };
+  text->buffer = (hb_buffer_T) { .allocator = NULL, .value = NULL, .length = 0, .capacity = 0 };
+  text->buffered = false;
+}
+
+void parser_text_append(parser_text_T* text, const token_T* token) {
+  hb_string_T value = token->value;
+
+  if (value.length == 0) { return; }
+
+  // A value the token owns is gone once the token is freed, so only values that view into the source are kept as is.
+  if (!text->buffered && !token->owns_value) {
+    if (text->view.length == 0) {
+      text->view = value;
+      return;
+    }
+
+    if (text->view.data + text->view.length == value.data) {
+      text->view.length += value.length;
+      return;
+    }
+  }
+
+  if (!text->buffered) {
+    // The buffer is kept across parser_text_clear(), so it's only allocated the first time this happens.
+    if (text->buffer.value == NULL && !hb_buffer_init(&text->buffer, text->view.length + value.length)) { return; }
+
+    hb_buffer_append_string(&text->buffer, text->view);
+    text->buffered = true;
+  }
+
+  hb_buffer_append_string(&text->buffer, value);
+}
+
+hb_string_T parser_text_value(const parser_text_T* text) {
+  if (!text->buffered) { return text->view; }
+
+  return (hb_string_T) { .data = text->buffer.value, .length = (uint32_t) text->buffer.length };
+}
+
+bool parser_text_is_empty(const parser_text_T* text) {
+  return parser_text_value(text).length == 0;
+}
+
+void parser_text_clear(parser_text_T* text) {
+  text->view = (hb_string_T) { .data = NULL, .length = 0 };
+  text->buffered = false;
+
+  if (text->buffer.value != NULL) { hb_buffer_clear(&text->buffer); }
+}
+
+void parser_text_free(parser_text_T* text) {
+  free(text->buffer.value);
+  parser_text_init(text);
+}
+
+void parser_append_literal_node_from_text(
   const parser_T* parser,
-  hb_buffer_T* buffer,
+  parser_text_T* text,
   hb_array_T* children,
   position_T start
 ) {
-  if (hb_buffer_length(buffer) == 0) { return; }
+  if (parser_text_is_empty(text)) { return; }
 
-  AST_LITERAL_NODE_T* literal =
-    ast_literal_node_init(hb_buffer_value(buffer), start, parser->current_token->location.start, NULL);
+  AST_LITERAL_NODE_T* literal = ast_literal_node_init_from_string(
+    parser_text_value(text),
+    start,
+    parser->current_token->location.start,
+    NULL,
+    parser->allocator
+  );
 
   if (children != NULL) { hb_array_append(children, literal); }
-  hb_buffer_clear(buffer);
+  parser_text_clear(text);
 }
 
 token_T* parser_advance(parser_T* parser) {
@@ -207,7 +268,8 @@ AST_HTML_ELEMENT_NODE_T* parser_handle_missing_close_tag(
     ELEMENT_SOURCE_HTML,
     open_tag->base.location.start,
     open_tag->base.location.end,
-    errors
+    errors,
+    open_tag->base.allocator
   );
 }
 
@@ -267,7 +329,7 @@ bool parser_can_close_ancestor(const parser_T* parser, hb_string_T tag_name) {
   for (size_t i = stack_size; i > 0; i--) {
     token_T* open = hb_array_get(parser->open_tags_stack, i - 1);
 
-    if (open && open->value && hb_string_equals_case_insensitive(hb_string(open->value), tag_name)) { return true; }
+    if (open && hb_string_equals_case_insensitive(open->value, tag_name)) { return true; }
   }
 
   return false;
@@ -279,7 +341,7 @@ size_t parser_find_ancestor_depth(const parser_T* parser, hb_string_T tag_name)
   for (size_t i = stack_size; i > 0; i--) {
     token_T* open = hb_array_get(parser->open_tags_stack, i - 1);
 
-    if (open && open->value && hb_string_equals_case_insensitive(hb_string(open->value), tag_name)) {
+    if (open && hb_string_equals_case_insensitive(open->value, tag_name)) {
       return stack_size - i;
     }
   }
@@ -1,7 +1,9 @@
 #include "include/prism_helpers.h"
 #include "include/ast_nodes.h"
 #include "include/errors.h"
+#include "include/line_offsets.h"
 #include "include/location.h"
+#include "include/parse_stats.h"
 #include "include/position.h"
 #include "include/util/hb_buffer.h"
 
@@ -22,35 +24,38 @@ const char* pm_error_level_to_string(pm_error_level_t level) {
 RUBY_PARSE_ERROR_T* ruby_parse_error_from_prism_error(
   const pm_diagnostic_t* error,
   const AST_NODE_T* node,
-  const char* source,
+  const line_offsets_T* line_offsets,
   pm_parser_t* parser
 ) {
   size_t start_offset = (size_t) (error->location.start - parser->start);
   size_t end_offset = (size_t) (error->location.end - parser->start);
 
-  position_T start = position_from_source_with_offset(source, start_offset);
-  position_T end = position_from_source_with_offset(source, end_offset);
+  position_T start = line_offsets_position(line_offsets, start_offset);
+  position_T end = line_offsets_position(line_offsets, end_offset);
 
   return ruby_parse_error_init(
     error->message,
     pm_diagnostic_id_human(error->diag_id),
     pm_error_level_to_string(error->level),
     start,
-    end
+    end,
+    node != NULL ? node->allocator : NULL
   );
 }
 
 RUBY_PARSE_ERROR_T* ruby_parse_error_from_prism_error_with_positions(
   const pm_diagnostic_t* error,
   position_T start,
-  position_T end
+  position_T end,
+  hb_arena_T* allocator
 ) {
   return ruby_parse_error_init(
     error->message,
     pm_diagnostic_id_human(error->diag_id),
     pm_error_level_to_string(error->level),
     start,
-    end
+    end,
+    allocator
   );
 }
 
@@ -118,19 +123,10 @@ static bool search_then_keyword_location(const pm_node_t* node, void* data) {
 }
 
 location_T* get_then_keyword_location(analyzed_ruby_T* analyzed, const char* source) {
-  if (analyzed == NULL || analyzed->root == NULL || source == NULL) { return NULL; }
-
-  then_keyword_search_context_T context = { .then_keyword_loc = { .start = NULL, .end = NULL }, .found = false };
-
-  pm_visit_child_nodes(analyzed->root, search_then_keyword_location, &context);
-
-  if (!context.found) { return NULL; }
-
-  size_t start_offset = (size_t) (context.then_keyword_loc.start - analyzed->parser.start);
-  size_t end_offset = (size_t) (context.then_keyword_loc.end - analyzed->parser.start);
+  if (analyzed == NULL || !analyzed->has_then_keyword_location || source == NULL) { return NULL; }
 
-  position_T start_position = position_from_source_with_offset(source, start_offset);
-  position_T end_position = position_from_source_with_offset(source, end_offset);
+  position_T start_position = position_from_source_with_offset(source, analyzed->then_keyword_start);
+  position_T end_position = position_from_source_with_offset(source, analyzed->then_keyword_end);
 
   return location_create(start_position, end_position);
 }
@@ -146,6 +142,7 @@ static location_T* parse_wrapped_and_find_then_keyword(
   pm_parser_t parser;
   pm_parser_init(&parser, (const uint8_t*) hb_buffer_value(buffer), hb_buffer_length(buffer), NULL);
   pm_node_t* root = pm_parse(&parser);
+  herb_parse_stats_count_prism_parse();
 
   if (root == NULL) {
     pm_parser_free(&parser);
@@ -11,8 +11,24 @@
 #include <stdlib.h>
 #include <string.h>
 
+static token_T* token_allocate(hb_arena_T* allocator) {
+  if (allocator == NULL) { return calloc(1, sizeof(token_T)); }
+
+  token_T* token = hb_arena_alloc(allocator, sizeof(token_T));
+  if (token) { memset(token, 0, sizeof(token_T)); }
+
+  return token;
+}
+
 token_T* token_init(hb_string_T value, const token_type_T type, lexer_T* lexer) {
-  token_T* token = calloc(1, sizeof(token_T));
+  token_T* token = NULL;
+
+  if (lexer->scanning) {
+    token = &lexer->scan_token;
+    memset(token, 0, sizeof(token_T));
+  } else {
+    token = token_allocate(lexer->allocator);
+  }
 
   if (!token) { return NULL; }
 
@@ -21,8 +37,8 @@ token_T* token_init(hb_string_T value, const token_type_T type, lexer_T* lexer)
     lexer->current_column = 0;
   }
 
-  token->value = hb_string_to_c_string_using_malloc(value);
-
+  token->allocator = lexer->scanning ? NULL : lexer->allocator;
+  token->value = value;
   token->type = type;
   token->range = (range_T) { .from = lexer->previous_position, .to = lexer->current_position };
 
@@ -161,9 +177,7 @@ char* token_types_to_friendly_string_va(token_type_T first_token, ...) {
 hb_string_T token_to_string(const token_T* token) {
   const char* type_string = token_type_to_string(token->type);
   const char* template = "#<Herb::Token type=\"%s\" value=\"%.*s\" range=[%u, %u] start=(%u:%u) end=(%u:%u)>";
-  const char* value = token->value ? token->value : "";
-
-  char* string = calloc(strlen(type_string) + strlen(template) + strlen(value) + 16, sizeof(char));
+  char* string = calloc(strlen(type_string) + strlen(template) + token->value.length + 16, sizeof(char));
 
   if (!string) { return hb_string(""); }
 
@@ -172,7 +186,7 @@ hb_string_T token_to_string(const token_T* token) {
   if (token->type == TOKEN_EOF) {
     escaped = hb_string(herb_strdup("<EOF>"));
   } else {
-    escaped = escape_newlines(hb_string(token->value));
+    escaped = escape_newlines(token->value);
   }
 
   sprintf(
@@ -194,24 +208,28 @@ hb_string_T token_to_string(const token_T* token) {
   return hb_string(string);
 }
 
-token_T* token_copy(token_T* token) {
+token_T* token_copy_arena(token_T* token, hb_arena_T* allocator) {
   if (!token) { return NULL; }
 
-  token_T* new_token = calloc(1, sizeof(token_T));
+  // Arena tokens are never mutated or freed on their own, so they can be shared
+  // by everything that lives in the same arena.
+  if (allocator != NULL && token->allocator == allocator) { return token; }
+
+  token_T* new_token = token_allocate(allocator);
 
   if (!new_token) { return NULL; }
 
-  if (token->value) {
-    new_token->value = herb_strdup(token->value);
+  new_token->value = token->value;
+  new_token->owns_value = false;
 
-    if (!new_token->value) {
-      free(new_token);
+  if (token->owns_value) {
+    if (!token_own_value(new_token, allocator)) {
+      if (allocator == NULL) { free(new_token); }
       return NULL;
     }
-  } else {
-    new_token->value = NULL;
   }
 
+  new_token->allocator = allocator;
   new_token->type = token->type;
   new_token->range = token->range;
   new_token->location = token->location;
@@ -219,14 +237,40 @@ token_T* token_copy(token_T* token) {
   return new_token;
 }
 
+token_T* token_copy(token_T* token) {
+  if (!token) { return NULL; }
+
+  return token_copy_arena(token, token->allocator);
+}
+
+bool token_own_value(token_T* token, hb_arena_T* allocator) {
+  if (!token) { return false; }
+
+  char* value = allocator == NULL ? hb_string_to_c_string_using_malloc(token->value)
+                                  : hb_string_to_c_string(allocator, token->value);
+
+  if (!value) { return false; }
+
+  token->value = (hb_string_T) { .data = value, .length = token->value.length };
+  token->owns_value = true;
+
+  return true;
+}
+
+char* token_value_to_c_string(const token_T* token) {
+  if (!token) { return NULL; }
+
+  return hb_string_to_c_string_using_malloc(token->value);
+}
+
 bool token_value_empty(const token_T* token) {
-  return token == NULL || token->value == NULL || token->value[0] == '\0';
+  return token == NULL || hb_string_is_empty(token->value);
 }
 
 void token_free(token_T* token) {
-  if (!token) { return; }
+  if (!token || token->allocator != NULL) { return; }
 
-  if (token->value != NULL) { free(token->value); }
+  if (token->owns_value) { free(token->value.data); }
 
   free(token);
 }
@@ -70,3 +70,9 @@ char* herb_strdup(const char* s) {
 
   return copy;
 }
+
+char* herb_strdup_arena(hb_arena_T* allocator, const char* s) {
+  if (allocator == NULL) { return herb_strdup(s); }
+
+  return hb_string_to_c_string(allocator, hb_string(s));
+}
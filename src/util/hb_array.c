@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "../include/macros.h"
 #include "../include/util/hb_array.h"
@@ -13,6 +14,7 @@ hb_array_T* hb_array_init(const size_t capacity) {
 
   if (!array) { return NULL; }
 
+  array->allocator = NULL;
   array->size = 0;
   array->capacity = capacity;
   array->items = malloc(capacity * sizeof(void*));
@@ -25,6 +27,23 @@ hb_array_T* hb_array_init(const size_t capacity) {
   return array;
 }
 
+hb_array_T* hb_array_init_arena(hb_arena_T* allocator, const size_t capacity) {
+  if (allocator == NULL) { return hb_array_init(capacity); }
+
+  hb_array_T* array = hb_arena_alloc(allocator, hb_array_sizeof());
+
+  if (!array) { return NULL; }
+
+  array->allocator = allocator;
+  array->size = 0;
+  array->capacity = capacity;
+  array->items = capacity > 0 ? hb_arena_alloc(allocator, capacity * sizeof(void*)) : NULL;
+
+  if (capacity > 0 && !array->items) { return NULL; }
+
+  return array;
+}
+
 bool hb_array_append(hb_array_T* array, void* item) {
   if (!array) { return false; }
 
@@ -48,7 +67,14 @@ bool hb_array_append(hb_array_T* array, void* item) {
     }
 
     size_t new_size_bytes = new_capacity * sizeof(void*);
-    void* new_items = realloc(array->items, new_size_bytes);
+    void* new_items = NULL;
+
+    if (array->allocator == NULL) {
+      new_items = realloc(array->items, new_size_bytes);
+    } else {
+      new_items = hb_arena_alloc(array->allocator, new_size_bytes);
+      if (new_items && array->size > 0) { memcpy(new_items, array->items, array->size * sizeof(void*)); }
+    }
 
     if (unlikely(new_items == NULL)) { return false; }
 
@@ -136,8 +162,10 @@ size_t hb_array_capacity(const hb_array_T* array) {
 void hb_array_free(hb_array_T** array) {
   if (!array || !*array) { return; }
 
-  free((*array)->items);
-  free(*array);
+  if ((*array)->allocator == NULL) {
+    free((*array)->items);
+    free(*array);
+  }
 
   *array = NULL;
 }
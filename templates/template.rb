@@ -297,6 +297,12 @@ module Herb
       def c_type
         @struct_type
       end
+
+      def token_value_argument?(argument)
+        token_field_names = fields.select { |field| field.is_a?(TokenField) }.map(&:name)
+
+        token_field_names.any? { |name| argument == "#{name}->value" }
+      end
     end
 
     class NodeType
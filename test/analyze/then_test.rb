@@ -287,5 +287,19 @@ module Analyze
         <% end %>
       HTML
     end
+
+    test "if with nested then keywords reports the first one" do
+      result = Herb.parse(<<~HTML)
+        <% if outer then if inner then value end %>
+          content
+        <% end %>
+      HTML
+
+      then_keyword = result.value.children.first.then_keyword
+
+      assert_equal 1, then_keyword.start.line
+      assert_equal 12, then_keyword.start.column
+      assert_equal 16, then_keyword.end.column
+    end
   end
 end
@@ -0,0 +1,37 @@
+#ifndef SERIALIZE_ASSERTIONS_H
+#define SERIALIZE_ASSERTIONS_H
+
+#include "test.h"
+#include "../../../src/include/herb.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static inline void assert_same_bytes(const hb_buffer_T* expected, const hb_buffer_T* actual) {
+  ck_assert_uint_eq(actual->length, expected->length);
+  ck_assert_int_eq(memcmp(actual->value, expected->value, expected->length), 0);
+}
+
+// Asserts that `document`, parsed from the first `length` bytes of `source`, serializes to the same bytes as
+// `expected_document` parsed from the C string `expected_source`.
+static inline void assert_same_serialization(
+  AST_DOCUMENT_NODE_T* expected_document,
+  const char* expected_source,
+  AST_DOCUMENT_NODE_T* document,
+  const char* source,
+  size_t length
+) {
+  hb_buffer_T expected_output, output;
+  hb_buffer_init(&expected_output, 256);
+  hb_buffer_init(&output, 256);
+
+  herb_serialize(expected_document, expected_source, &expected_output);
+  herb_serialize_with_length(document, source, length, &output);
+
+  assert_same_bytes(&expected_output, &output);
+
+  free(expected_output.value);
+  free(output.value);
+}
+
+#endif
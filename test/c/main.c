@@ -8,8 +8,12 @@ TCase *hb_buffer_tests(void);
 TCase *hb_string_tests(void);
 TCase *herb_tests(void);
 TCase *html_util_tests(void);
+TCase *incremental_tests(void);
 TCase *io_tests(void);
 TCase *lex_tests(void);
+TCase *line_offsets_tests(void);
+TCase *parse_cache_tests(void);
+TCase *serialize_tests(void);
 TCase *token_tests(void);
 TCase *util_tests(void);
 TCase *extract_tests(void);
@@ -24,8 +28,12 @@ Suite *herb_suite(void) {
   suite_add_tcase(suite, hb_string_tests());
   suite_add_tcase(suite, herb_tests());
   suite_add_tcase(suite, html_util_tests());
+  suite_add_tcase(suite, incremental_tests());
   suite_add_tcase(suite, io_tests());
   suite_add_tcase(suite, lex_tests());
+  suite_add_tcase(suite, line_offsets_tests());
+  suite_add_tcase(suite, parse_cache_tests());
+  suite_add_tcase(suite, serialize_tests());
   suite_add_tcase(suite, token_tests());
   suite_add_tcase(suite, util_tests());
   suite_add_tcase(suite, extract_tests());
@@ -1,6 +1,7 @@
 #include "include/test.h"
 
 #include "../../src/include/extract.h"
+#include "../../src/include/herb.h"
 #include "../../src/include/util/hb_buffer.h"
 
 #include <string.h>
@@ -224,6 +225,38 @@ TEST(extract_ruby_with_options_default)
   free(output.value);
 END
 
+TEST(extract_ruby_erb_tag_matches_whole_source_extraction)
+  char* source = "<div><% if x %><%# note %><%= y -%><%% z %></div>";
+  char* expected = herb_extract_ruby_with_semicolons(source);
+
+  size_t length = strlen(source);
+  char* result = malloc(length + 1);
+  memset(result, ' ', length);
+  result[length] = '\0';
+
+  hb_buffer_T scratch;
+  hb_buffer_init(&scratch, 16);
+
+  hb_array_T* tokens = herb_lex(source);
+
+  for (size_t index = 0; index + 2 < hb_array_size(tokens); index++) {
+    token_T* token = hb_array_get(tokens, index);
+    if (token->type != TOKEN_ERB_START) { continue; }
+
+    token_T* content = hb_array_get(tokens, index + 1);
+    token_T* closing = hb_array_get(tokens, index + 2);
+
+    herb_extract_ruby_erb_tag(token, content, closing, &scratch, result);
+  }
+
+  ck_assert_str_eq(result, expected);
+
+  herb_free_tokens(&tokens);
+  free(scratch.value);
+  free(result);
+  free(expected);
+END
+
 TCase *extract_tests(void) {
   TCase *extract = tcase_create("Extract");
 
@@ -247,6 +280,7 @@ TCase *extract_tests(void) {
   tcase_add_test(extract, extract_ruby_with_options_preserve_positions_false);
   tcase_add_test(extract, extract_ruby_with_options_preserve_positions_false_and_comments_true);
   tcase_add_test(extract, extract_ruby_with_options_default);
+  tcase_add_test(extract, extract_ruby_erb_tag_matches_whole_source_extraction);
 
   return extract;
 }
@@ -1,4 +1,5 @@
 #include "include/test.h"
+#include "../../src/include/util/hb_arena.h"
 #include "../../src/include/util/hb_array.h"
 
 // Test array initialization
@@ -107,6 +108,45 @@ TEST(test_hb_array_size)
   hb_array_free(&array);
 END
 
+// Test arena-backed arrays grow inside the arena and are released with it
+TEST(test_hb_array_init_arena)
+  hb_arena_T allocator;
+  hb_arena_init(&allocator, 1024);
+
+  hb_array_T* array = hb_array_init_arena(&allocator, 1);
+
+  ck_assert_ptr_nonnull(array);
+  ck_assert_ptr_eq(array->allocator, &allocator);
+  ck_assert_int_eq(array->capacity, 1);
+
+  size_t item1 = 42, item2 = 99, item3 = 100;
+  hb_array_append(array, &item1);
+  hb_array_append(array, &item2);
+  hb_array_append(array, &item3);
+
+  ck_assert_int_eq(array->size, 3);
+  ck_assert_int_ge(array->capacity, 3);
+  ck_assert_ptr_eq(array->items[0], &item1);
+  ck_assert_ptr_eq(array->items[1], &item2);
+  ck_assert_ptr_eq(array->items[2], &item3);
+
+  hb_array_free(&array);
+  ck_assert_ptr_null(array);
+
+  hb_arena_free(&allocator);
+END
+
+// Test a NULL arena falls back to the heap
+TEST(test_hb_array_init_arena_null)
+  hb_array_T* array = hb_array_init_arena(NULL, 4);
+
+  ck_assert_ptr_nonnull(array);
+  ck_assert_ptr_null(array->allocator);
+  ck_assert_int_eq(array->capacity, 4);
+
+  hb_array_free(&array);
+END
+
 // Register test cases
 TCase *hb_array_tests(void) {
   TCase *array = tcase_create("Herb Array");
@@ -118,6 +158,8 @@ TCase *hb_array_tests(void) {
   tcase_add_test(array, test_hb_array_remove);
   tcase_add_test(array, test_hb_array_free);
   tcase_add_test(array, test_hb_array_size);
+  tcase_add_test(array, test_hb_array_init_arena);
+  tcase_add_test(array, test_hb_array_init_arena_null);
 
   return array;
 }
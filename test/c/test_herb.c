@@ -1,14 +1,311 @@
 #include "include/test.h"
+#include "include/serialize_assertions.h"
 #include "../../src/include/herb.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
 TEST(test_herb_version)
   ck_assert_str_eq(herb_version(), "0.8.10");
 END
 
+TEST(test_herb_parse_unclosed_output_tag_in_open_tag)
+  AST_DOCUMENT_NODE_T* document = herb_parse("<h1 <%= \"id=\">></h1>", NULL);
+
+  ck_assert_ptr_nonnull(document);
+  ck_assert_int_eq(hb_array_size(document->children), 1);
+
+  ast_node_free((AST_NODE_T*) document);
+END
+
+TEST(test_herb_parse_text_content)
+  AST_DOCUMENT_NODE_T* document = herb_parse("Hello\n  world %> again<p>x</p>", NULL);
+
+  ck_assert_ptr_nonnull(document);
+  ck_assert_int_eq(hb_array_size(document->children), 2);
+
+  AST_HTML_TEXT_NODE_T* text = hb_array_get(document->children, 0);
+  ck_assert_int_eq(text->base.type, AST_HTML_TEXT_NODE);
+  ck_assert_str_eq(text->content, "Hello\n  world %> again");
+
+  ast_node_free((AST_NODE_T*) document);
+END
+
+// Writes the elements and stray tags in `nodes` as e.g. `div(<span!1) </p!1`: unmatched open and close tags are
+// prefixed with `<` and `</`, and `!n` is the number of errors on a node.
+static void describe_tags(hb_array_T* nodes, hb_buffer_T* output) {
+  for (size_t i = 0; i < hb_array_size(nodes); i++) {
+    AST_NODE_T* node = hb_array_get(nodes, i);
+
+    if (i > 0) { hb_buffer_append_char(output, ' '); }
+
+    switch (node->type) {
+      case AST_HTML_ELEMENT_NODE: {
+        AST_HTML_ELEMENT_NODE_T* element = (AST_HTML_ELEMENT_NODE_T*) node;
+
+        hb_buffer_append_string(output, element->tag_name->value);
+        hb_buffer_append_char(output, '(');
+        describe_tags(element->body, output);
+        hb_buffer_append_char(output, ')');
+        break;
+      }
+
+      case AST_HTML_OPEN_TAG_NODE:
+        hb_buffer_append_char(output, '<');
+        hb_buffer_append_string(output, ((AST_HTML_OPEN_TAG_NODE_T*) node)->tag_name->value);
+        break;
+
+      case AST_HTML_CLOSE_TAG_NODE:
+        hb_buffer_append(output, "</");
+        hb_buffer_append_string(output, ((AST_HTML_CLOSE_TAG_NODE_T*) node)->tag_name->value);
+        break;
+
+      default: hb_buffer_append_char(output, '?'); break;
+    }
+
+    if (hb_array_size(node->errors) > 0) {
+      char count[24];
+      snprintf(count, sizeof(count), "!%zu", hb_array_size(node->errors));
+      hb_buffer_append(output, count);
+    }
+  }
+}
+
+static void assert_tags(const char* source, const char* expected) {
+  AST_DOCUMENT_NODE_T* document = herb_parse(source, NULL);
+
+  hb_buffer_T output;
+  hb_buffer_init(&output, 64);
+  describe_tags(document->children, &output);
+
+  ck_assert_str_eq(hb_buffer_value(&output), expected);
+
+  free(output.value);
+  ast_node_free((AST_NODE_T*) document);
+}
+
+// Every open tag pairs with the first close tag of the same name that a forward scan reaches at nesting depth zero,
+// and only when that close tag is inside the range being built, as it did before tags were matched in one pass.
+TEST(test_herb_parse_matches_tags)
+  assert_tags("<div><div></div></div>", "div(div())");
+  assert_tags("<div><DIV></Div></div>", "div(DIV())");
+  assert_tags("<div><div></div>", "<div!1 div()");
+  assert_tags("<div></span></div>", "div(</span!1)");
+  assert_tags("</span><div></div>", "</span!1 div()");
+  assert_tags("<span><div><span></div></span>", "<span!1 div(<span!1) </span!1");
+  assert_tags("<a><b><a></b></a></a>", "a(b(<a!1) </a!1)");
+END
+
+// Only the first `length` bytes are parsed, so the rest of the buffer stands in for whatever follows a host string.
+TEST(test_herb_parse_with_length)
+  const char* source = "<div><%= user.name %></div>";
+  const char buffer[] = "<div><%= user.name %></div><span><% if";
+
+  AST_DOCUMENT_NODE_T* expected = herb_parse(source, NULL);
+  AST_DOCUMENT_NODE_T* document = herb_parse_with_length(buffer, strlen(source), NULL);
+
+  assert_same_serialization(expected, source, document, buffer, strlen(source));
+
+  ast_node_free((AST_NODE_T*) expected);
+  ast_node_free((AST_NODE_T*) document);
+END
+
+TEST(test_herb_lex_with_length)
+  hb_array_T* expected = herb_lex("<p>Hi</p>");
+  hb_array_T* tokens = herb_lex_with_length("<p>Hi</p><%= more", 9);
+
+  ck_assert_uint_eq(hb_array_size(tokens), hb_array_size(expected));
+
+  token_T* eof = hb_array_last(tokens);
+  ck_assert_int_eq(eof->type, TOKEN_EOF);
+  ck_assert_uint_eq(eof->range.from, 9);
+
+  herb_free_tokens(&expected);
+  herb_free_tokens(&tokens);
+END
+
+TEST(test_herb_context_parse)
+  const char* source = "<ul><% items.each do |item| %><li><%= item %></li><% end %></ul>";
+
+  herb_context_T context;
+  ck_assert(herb_context_init(&context, 0));
+
+  AST_DOCUMENT_NODE_T* expected = herb_parse(source, NULL);
+
+  for (size_t iteration = 0; iteration < 3; iteration++) {
+    AST_DOCUMENT_NODE_T* document = herb_context_parse(&context, source, strlen(source), NULL);
+
+    assert_same_serialization(expected, source, document, source, strlen(source));
+
+    herb_context_reset(&context);
+  }
+
+  ast_node_free((AST_NODE_T*) expected);
+  herb_context_free(&context);
+END
+
+// Once the arena has grown to fit a document, parsing it again after a reset doesn't need any new pages.
+TEST(test_herb_context_reuses_arena)
+  const char* source = "<div class=\"card\"><% if user %><p><%= user.name %></p><% end %></div>";
+
+  herb_context_T context;
+  ck_assert(herb_context_init(&context, KB(1)));
+
+  herb_context_parse(&context, source, strlen(source), NULL);
+  herb_context_reset(&context);
+
+  size_t capacity = hb_arena_capacity(&context.allocator);
+
+  for (size_t iteration = 0; iteration < 10; iteration++) {
+    herb_context_parse(&context, source, strlen(source), NULL);
+    herb_context_reset(&context);
+  }
+
+  ck_assert_uint_eq(hb_arena_capacity(&context.allocator), capacity);
+  ck_assert_uint_eq(hb_arena_position(&context.allocator), 0);
+
+  herb_context_free(&context);
+END
+
+#define PARSE_FILES_COUNT 8
+
+typedef struct {
+  int calls[PARSE_FILES_COUNT];
+  size_t children[PARSE_FILES_COUNT];
+  bool has_document[PARSE_FILES_COUNT];
+} parse_files_results_T;
+
+// Every index is only ever handed to one worker, so writing to its own slot needs no locking.
+static void record_parsed_file(
+  size_t index,
+  const char* path,
+  const char* source,
+  AST_DOCUMENT_NODE_T* document,
+  void* user_data
+) {
+  parse_files_results_T* results = user_data;
+
+  results->calls[index]++;
+  results->has_document[index] = document != NULL && source != NULL;
+  results->children[index] = document ? hb_array_size(document->children) : 0;
+}
+
+// The files live in their own temporary directory, which is removed before any assertion can fail.
+TEST(test_herb_parse_files)
+  char directory[] = "/tmp/herb_parse_files_XXXXXX";
+  ck_assert_ptr_nonnull(mkdtemp(directory));
+
+  char paths[PARSE_FILES_COUNT][64];
+  const char* path_pointers[PARSE_FILES_COUNT];
+  bool written = true;
+
+  for (size_t index = 0; index < PARSE_FILES_COUNT; index++) {
+    snprintf(paths[index], sizeof(paths[index]), "%s/%zu.html.erb", directory, index);
+    path_pointers[index] = paths[index];
+
+    // The last path is left missing on purpose.
+    if (index == PARSE_FILES_COUNT - 1) { continue; }
+
+    FILE* fp = fopen(paths[index], "w");
+
+    if (fp == NULL) {
+      written = false;
+      continue;
+    }
+
+    for (size_t element = 0; element <= index; element++) {
+      fputs("<div><%= value %></div>", fp);
+    }
+
+    fclose(fp);
+  }
+
+  parse_files_results_T results = { 0 };
+  if (written) { herb_parse_files(path_pointers, PARSE_FILES_COUNT, NULL, 3, record_parsed_file, &results); }
+
+  for (size_t index = 0; index < PARSE_FILES_COUNT - 1; index++) {
+    remove(paths[index]);
+  }
+
+  rmdir(directory);
+
+  ck_assert(written);
+
+  for (size_t index = 0; index < PARSE_FILES_COUNT - 1; index++) {
+    ck_assert_int_eq(results.calls[index], 1);
+    ck_assert(results.has_document[index]);
+    ck_assert_uint_eq(results.children[index], index + 1);
+  }
+
+  ck_assert_int_eq(results.calls[PARSE_FILES_COUNT - 1], 1);
+  ck_assert(!results.has_document[PARSE_FILES_COUNT - 1]);
+END
+
+TEST(test_herb_parse_stats)
+  const char* source = "<div><% if admin? %><p><%= user.name %></p><% end %></div>";
+
+  hb_array_T* tokens = herb_lex(source);
+
+  hb_arena_T allocator;
+  ck_assert(hb_arena_init(&allocator, 4096));
+
+  herb_parse_stats_T stats = { 0 };
+  parser_options_T options = HERB_DEFAULT_PARSER_OPTIONS;
+  options.stats = &stats;
+
+  AST_DOCUMENT_NODE_T* document = herb_parse_arena(source, &options, &allocator);
+
+  ck_assert_ptr_nonnull(document);
+  ck_assert_uint_ge(stats.tokens, hb_array_size(tokens));
+  ck_assert_uint_ge(stats.nodes, 6);
+  ck_assert_uint_ge(stats.prism_parses, 3);
+  ck_assert_uint_eq(stats.allocations, allocator.allocation_count);
+  ck_assert_str_eq(herb_parse_phase_name(HERB_PARSE_PHASE_MATCH_TAGS), "match_tags");
+
+  size_t nodes = stats.nodes;
+  herb_parse_arena(source, &options, &allocator);
+  ck_assert_uint_eq(stats.nodes, nodes * 2);
+
+  hb_arena_free(&allocator);
+  herb_free_tokens(&tokens);
+END
+
+TEST(test_herb_parse_stats_without_analyze)
+  herb_parse_stats_T stats = { 0 };
+  parser_options_T options = HERB_DEFAULT_PARSER_OPTIONS;
+  options.analyze = false;
+  options.stats = &stats;
+
+  AST_DOCUMENT_NODE_T* document = herb_parse("<p><%= title %></p>", &options);
+
+  ck_assert_uint_gt(stats.tokens, 0);
+  ck_assert_uint_gt(stats.nodes, 0);
+  ck_assert_uint_eq(stats.prism_parses, 0);
+  ck_assert_uint_eq(stats.allocations, 0);
+
+  for (int phase = HERB_PARSE_PHASE_TRANSFORM; phase < HERB_PARSE_PHASE_COUNT; phase++) {
+    ck_assert_uint_eq(stats.nanoseconds[phase], 0);
+  }
+
+  ast_node_free((AST_NODE_T*) document);
+END
+
 TCase *herb_tests(void) {
   TCase *herb = tcase_create("Herb");
 
   tcase_add_test(herb, test_herb_version);
+  tcase_add_test(herb, test_herb_parse_unclosed_output_tag_in_open_tag);
+  tcase_add_test(herb, test_herb_parse_text_content);
+  tcase_add_test(herb, test_herb_parse_matches_tags);
+  tcase_add_test(herb, test_herb_parse_with_length);
+  tcase_add_test(herb, test_herb_lex_with_length);
+  tcase_add_test(herb, test_herb_context_parse);
+  tcase_add_test(herb, test_herb_context_reuses_arena);
+  tcase_add_test(herb, test_herb_parse_files);
+  tcase_add_test(herb, test_herb_parse_stats);
+  tcase_add_test(herb, test_herb_parse_stats_without_analyze);
 
   return herb;
 }
@@ -23,12 +23,48 @@ TEST(html_util_html_self_closing_tag_string)
   ck_assert(hb_string_equals(html_self_closing_tag_string(hb_string("somelongerstring")), hb_string("<somelongerstring />")));
 END
 
+TEST(html_util_html_tag_from_name)
+  ck_assert_int_eq(html_tag_from_name(hb_string("div")), HTML_TAG_DIV);
+  ck_assert_int_eq(html_tag_from_name(hb_string("TBody")), HTML_TAG_TBODY);
+  ck_assert_int_eq(html_tag_from_name(hb_string("address")), HTML_TAG_ADDRESS);
+  ck_assert_int_eq(html_tag_from_name(hb_string("wbr")), HTML_TAG_WBR);
+  ck_assert_int_eq(html_tag_from_name(hb_string("span")), HTML_TAG_UNKNOWN);
+  ck_assert_int_eq(html_tag_from_name(hb_string("divs")), HTML_TAG_UNKNOWN);
+  ck_assert_int_eq(html_tag_from_name(hb_string("")), HTML_TAG_UNKNOWN);
+  ck_assert_int_eq(html_tag_from_name((hb_string_T) { .data = NULL, .length = 0 }), HTML_TAG_UNKNOWN);
+END
+
+TEST(html_util_element_classification)
+  ck_assert(is_void_element(hb_string("br")));
+  ck_assert(is_void_element(hb_string("IMG")));
+  ck_assert(!is_void_element(hb_string("div")));
+  ck_assert(!is_void_element(hb_string("")));
+
+  ck_assert(has_optional_end_tag(hb_string("li")));
+  ck_assert(has_optional_end_tag(hb_string("Colgroup")));
+  ck_assert(!has_optional_end_tag(hb_string("div")));
+
+  ck_assert(should_implicitly_close(hb_string("p"), hb_string("DIV")));
+  ck_assert(should_implicitly_close(hb_string("td"), hb_string("th")));
+  ck_assert(!should_implicitly_close(hb_string("p"), hb_string("span")));
+  ck_assert(!should_implicitly_close(hb_string("div"), hb_string("div")));
+  ck_assert(should_implicitly_close(hb_string("colgroup"), hb_string("my-element")));
+  ck_assert(!should_implicitly_close(hb_string("colgroup"), hb_string("col")));
+
+  ck_assert(parent_closes_element(hb_string("li"), hb_string("ol")));
+  ck_assert(parent_closes_element(hb_string("tr"), hb_string("TABLE")));
+  ck_assert(!parent_closes_element(hb_string("li"), hb_string("div")));
+  ck_assert(!parent_closes_element(hb_string("span"), hb_string("div")));
+END
+
 TCase* html_util_tests(void) {
   TCase* html_util = tcase_create("HTML Util");
 
   tcase_add_test(html_util, html_util_html_closing_tag_string);
   tcase_add_test(html_util, html_util_html_closing_tag_string);
   tcase_add_test(html_util, html_util_html_self_closing_tag_string);
+  tcase_add_test(html_util, html_util_html_tag_from_name);
+  tcase_add_test(html_util, html_util_element_classification);
 
   return html_util;
 }
@@ -0,0 +1,99 @@
+#include "include/test.h"
+#include "../../src/include/herb.h"
+#include "../../src/include/ast_pretty_print.h"
+
+#include <string.h>
+
+static char* pretty_print(AST_DOCUMENT_NODE_T* document) {
+  hb_buffer_T buffer;
+  hb_buffer_init(&buffer, 1024);
+
+  ast_pretty_print_node((AST_NODE_T*) document, 0, 0, &buffer);
+
+  return buffer.value;
+}
+
+static herb_edit_T replace(const char* source, const char* old_text, const char* new_text) {
+  uint32_t start = (uint32_t) (strstr(source, old_text) - source);
+
+  return (herb_edit_T) { .start = start,
+                         .old_end = start + (uint32_t) strlen(old_text),
+                         .new_end = start + (uint32_t) strlen(new_text) };
+}
+
+static void assert_reparse_matches_parse(const char* old_source, const char* new_source, herb_edit_T edit) {
+  AST_DOCUMENT_NODE_T* document = herb_parse(old_source, NULL);
+  AST_DOCUMENT_NODE_T* reparsed = herb_reparse(document, old_source, new_source, &edit, NULL);
+  AST_DOCUMENT_NODE_T* expected = herb_parse(new_source, NULL);
+
+  char* reparsed_output = pretty_print(reparsed);
+  char* expected_output = pretty_print(expected);
+
+  ck_assert_str_eq(reparsed_output, expected_output);
+
+  free(reparsed_output);
+  free(expected_output);
+  ast_node_free((AST_NODE_T*) reparsed);
+  ast_node_free((AST_NODE_T*) expected);
+}
+
+TEST(herb_reparse_reuses_unchanged_nodes)
+  const char* old_source = "<header>a</header>\n<main>b</main>\n<footer>c</footer>\n";
+  const char* new_source = "<header>a</header>\n<main>bbb\n</main>\n<footer>c</footer>\n";
+  herb_edit_T edit = replace(old_source, "b<", "bbb\n<");
+
+  AST_DOCUMENT_NODE_T* document = herb_parse(old_source, NULL);
+  AST_NODE_T* header = hb_array_get(document->children, 0);
+  AST_NODE_T* footer = hb_array_get(document->children, 4);
+
+  AST_DOCUMENT_NODE_T* reparsed = herb_reparse(document, old_source, new_source, &edit, NULL);
+
+  ck_assert_ptr_eq(reparsed, document);
+  ck_assert_ptr_eq(hb_array_get(reparsed->children, 0), header);
+  ck_assert_ptr_eq(hb_array_get(reparsed->children, 4), footer);
+  ck_assert_int_eq(footer->location.start.line, 4);
+
+  ast_node_free((AST_NODE_T*) reparsed);
+END
+
+TEST(herb_reparse_matches_full_parse)
+  const char* source = "<div class=\"a\">\n  <%= title %>\n</div>\n<p>text</p><span>x</span>\n<% if x %>y<% end %>\n";
+
+  assert_reparse_matches_parse(source, "<div class=\"a\">\n  <%= title %>\n</div>\n<p>new text</p><span>x</span>\n"
+                                       "<% if x %>y<% end %>\n", replace(source, "text", "new text"));
+
+  assert_reparse_matches_parse(source, "<div class=\"b\">\n  <%= title %>\n</div>\n<p>text</p><span>x</span>\n"
+                                       "<% if x %>y<% end %>\n", replace(source, "\"a\"", "\"b\""));
+
+  assert_reparse_matches_parse(source, "<div class=\"a\">\n  <%= title %>\n</div>\n<p>text</p><span>x</span>\n"
+                                       "<% if x %>yz<% end %>\n", replace(source, "y<", "yz<"));
+
+  assert_reparse_matches_parse(source, "<div class=\"a\">\n  <%= title %>\n</div>\n<p>te\n\nxt</p><span>x</span>\n"
+                                       "<% if x %>y<% end %>\n", replace(source, "text", "te\n\nxt"));
+
+  assert_reparse_matches_parse(source, "<div class=\"a\">\n  <%= title %>\n</div>\n<p>t</p><span>x</span>\n"
+                                       "<% if x %>y<% end %>\n", replace(source, "text", "t"));
+END
+
+TEST(herb_reparse_falls_back_to_full_parse)
+  const char* source = "<section>a</section>\n<div>b</div>\n<section>c</section>\n";
+
+  assert_reparse_matches_parse(source, "<section>a</section>\n<div>b\n<section>c</section>\n",
+                               replace(source, "</div>", ""));
+
+  assert_reparse_matches_parse(source, "<section>a</section>\n<div>b</div><div>\n<section>c</section>\n",
+                               replace(source, "</div>", "</div><div>"));
+
+  assert_reparse_matches_parse(source, "<section>a</section>\n<div>b<% if x %></div>\n<section>c</section>\n",
+                               replace(source, "b", "b<% if x %>"));
+END
+
+TCase *incremental_tests(void) {
+  TCase *incremental = tcase_create("Incremental");
+
+  tcase_add_test(incremental, herb_reparse_reuses_unchanged_nodes);
+  tcase_add_test(incremental, herb_reparse_matches_full_parse);
+  tcase_add_test(incremental, herb_reparse_falls_back_to_full_parse);
+
+  return incremental;
+}
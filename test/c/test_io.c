@@ -1,6 +1,9 @@
 #include "include/test.h"
 #include "../../src/include/io.h"
 
+#include <string.h>
+#include <unistd.h>
+
 // Create a temporary file for testing
 void create_test_file(const char* filename, const char* content) {
   FILE* fp = fopen(filename, "w");
@@ -33,11 +36,65 @@ TEST(test_herb_read_file)
   remove(filename);
 END
 
+TEST(test_herb_map_file)
+  const char* filename = "test_herb_map_file.txt";
+  const char* file_content = "<p><%= title %></p>\n";
+
+  create_test_file(filename, file_content);
+
+  herb_mapped_file_T file;
+  ck_assert(herb_try_map_file(filename, &file));
+
+  ck_assert_uint_eq(file.length, strlen(file_content));
+  ck_assert_str_eq(file.data, file_content);
+
+  herb_unmap_file(&file);
+  ck_assert_ptr_null(file.data);
+  remove(filename);
+END
+
+// A file filling its last page has no zeroed byte after it, so it's read instead and still NUL-terminated. Its
+// length counts every byte, including those after a NUL, just like a mapped file's.
+TEST(test_herb_map_file_page_sized)
+  const char* filename = "test_herb_map_file_page_sized.txt";
+  size_t length = (size_t) sysconf(_SC_PAGESIZE);
+
+  char* content = malloc(length);
+  memset(content, 'x', length);
+  content[length / 2] = '\0';
+
+  FILE* fp = fopen(filename, "wb");
+  ck_assert_ptr_nonnull(fp);
+  ck_assert_uint_eq(fwrite(content, 1, length, fp), length);
+  fclose(fp);
+
+  herb_mapped_file_T file;
+  ck_assert(herb_try_map_file(filename, &file));
+
+  ck_assert_uint_eq(file.length, length);
+  ck_assert_uint_eq(file.mapped_length, 0);
+  ck_assert_mem_eq(file.data, content, length);
+  ck_assert_int_eq(file.data[length], '\0');
+
+  herb_unmap_file(&file);
+  free(content);
+  remove(filename);
+END
+
+TEST(test_herb_try_map_file_nonexistent)
+  herb_mapped_file_T file;
+
+  ck_assert(!herb_try_map_file("non_existent_file.txt", &file));
+END
+
 TCase* io_tests(void) {
   TCase* io = tcase_create("IO");
 
   tcase_add_test(io, test_herb_read_file);
   tcase_add_exit_test(io, test_herb_read_file_nonexistent_exits, 1);
+  tcase_add_test(io, test_herb_map_file);
+  tcase_add_test(io, test_herb_map_file_page_sized);
+  tcase_add_test(io, test_herb_try_map_file_nonexistent);
 
   return io;
 }
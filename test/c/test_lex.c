@@ -1,6 +1,8 @@
 #include "include/test.h"
 #include "../../src/include/herb.h"
 
+#include <string.h>
+
 TEST(herb_lex_to_buffer_empty_file)
   char* html = "";
   hb_buffer_T output;
@@ -34,11 +36,136 @@ TEST(herb_lex_to_buffer_basic_tag)
   free(output.value);
 END
 
+TEST(herb_lex_arena_matches_herb_lex)
+  char* html = "<div class=\"a\"><%= value %></div>";
+  hb_arena_T allocator;
+  hb_arena_init(&allocator, 1024);
+
+  hb_array_T* heap_tokens = herb_lex(html);
+  hb_array_T* arena_tokens = herb_lex_arena(html, &allocator);
+
+  ck_assert_int_eq(hb_array_size(arena_tokens), hb_array_size(heap_tokens));
+
+  for (size_t i = 0; i < hb_array_size(heap_tokens); i++) {
+    token_T* heap_token = hb_array_get(heap_tokens, i);
+    token_T* arena_token = hb_array_get(arena_tokens, i);
+
+    ck_assert_ptr_eq(arena_token->allocator, &allocator);
+    ck_assert_int_eq(arena_token->type, heap_token->type);
+    ck_assert(hb_string_equals(arena_token->value, heap_token->value));
+    ck_assert_int_eq(arena_token->range.from, heap_token->range.from);
+    ck_assert_int_eq(arena_token->range.to, heap_token->range.to);
+  }
+
+  herb_free_tokens(&heap_tokens);
+  herb_free_tokens(&arena_tokens);
+  hb_arena_free(&allocator);
+END
+
+typedef struct {
+  hb_array_T* tokens;
+  size_t count;
+  size_t limit;
+} lex_each_state_T;
+
+static bool collect_token(const token_T* token, void* user_data) {
+  lex_each_state_T* state = user_data;
+  token_T* expected = hb_array_get(state->tokens, state->count);
+
+  ck_assert_ptr_nonnull(expected);
+  ck_assert_int_eq(token->type, expected->type);
+  ck_assert(hb_string_equals(token->value, expected->value));
+  ck_assert_int_eq(token->range.from, expected->range.from);
+  ck_assert_int_eq(token->range.to, expected->range.to);
+
+  state->count++;
+
+  return state->limit == 0 || state->count < state->limit;
+}
+
+TEST(herb_lex_each_matches_herb_lex)
+  char* html = "<div class=\"a\"><%= value %></div>\n<%# comment %>";
+  hb_array_T* tokens = herb_lex(html);
+  lex_each_state_T state = { .tokens = tokens, .count = 0, .limit = 0 };
+
+  herb_lex_each(html, collect_token, &state);
+
+  ck_assert_int_eq(state.count, hb_array_size(tokens));
+
+  herb_free_tokens(&tokens);
+END
+
+TEST(herb_lex_each_stops_when_callback_returns_false)
+  char* html = "<div class=\"a\"><%= value %></div>";
+  hb_array_T* tokens = herb_lex(html);
+  lex_each_state_T state = { .tokens = tokens, .count = 0, .limit = 3 };
+
+  herb_lex_each(html, collect_token, &state);
+
+  ck_assert_int_eq(state.count, 3);
+
+  herb_free_tokens(&tokens);
+END
+
+TEST(herb_lex_long_erb_content)
+  char* html = "<%= aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\nbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb -%> <% x %%>";
+  hb_array_T* tokens = herb_lex(html);
+
+  token_T* content = hb_array_get(tokens, 1);
+  ck_assert_int_eq(content->type, TOKEN_ERB_CONTENT);
+  ck_assert_int_eq(content->range.from, 3);
+  ck_assert_int_eq(content->range.to, 86);
+  ck_assert_int_eq(content->location.end.line, 2);
+  ck_assert_int_eq(content->location.end.column, 41);
+
+  token_T* end = hb_array_get(tokens, 2);
+  ck_assert_int_eq(end->type, TOKEN_ERB_END);
+  ck_assert(hb_string_equals(end->value, hb_string("-%>")));
+
+  token_T* percent_end = hb_array_get(tokens, 6);
+  ck_assert_int_eq(percent_end->type, TOKEN_ERB_END);
+  ck_assert(hb_string_equals(percent_end->value, hb_string("%%>")));
+
+  herb_free_tokens(&tokens);
+END
+
+TEST(herb_lex_with_length_stops_at_nul)
+  const char* sources[] = { "<% a\0b %>", "<% aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\0bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb %>" };
+
+  for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+    const char* source = sources[i];
+    size_t length = strlen(source) + 1 + strlen(source + strlen(source) + 1);
+
+    hb_array_T* tokens = herb_lex(source);
+    hb_array_T* length_tokens = herb_lex_with_length(source, length);
+
+    ck_assert_int_eq(hb_array_size(length_tokens), hb_array_size(tokens));
+
+    for (size_t j = 0; j < hb_array_size(tokens); j++) {
+      token_T* token = hb_array_get(tokens, j);
+      token_T* length_token = hb_array_get(length_tokens, j);
+
+      ck_assert_int_eq(length_token->type, token->type);
+      ck_assert(hb_string_equals(length_token->value, token->value));
+      ck_assert_int_eq(length_token->range.from, token->range.from);
+      ck_assert_int_eq(length_token->range.to, token->range.to);
+    }
+
+    herb_free_tokens(&tokens);
+    herb_free_tokens(&length_tokens);
+  }
+END
+
 TCase *lex_tests(void) {
   TCase *tags = tcase_create("Lex");
 
   tcase_add_test(tags, herb_lex_to_buffer_empty_file);
   tcase_add_test(tags, herb_lex_to_buffer_basic_tag);
+  tcase_add_test(tags, herb_lex_arena_matches_herb_lex);
+  tcase_add_test(tags, herb_lex_each_matches_herb_lex);
+  tcase_add_test(tags, herb_lex_each_stops_when_callback_returns_false);
+  tcase_add_test(tags, herb_lex_long_erb_content);
+  tcase_add_test(tags, herb_lex_with_length_stops_at_nul);
 
   return tags;
 }
@@ -0,0 +1,60 @@
+#include "include/test.h"
+#include "../../src/include/line_offsets.h"
+#include "../../src/include/position.h"
+
+#include <string.h>
+
+TEST(line_offsets_match_position_from_source)
+  const char* source = "<div>\n  <%= this line is long enough to cover a whole vector chunk %>\r\n</div>\r\r\nend";
+  size_t length = strlen(source);
+
+  line_offsets_T line_offsets;
+  ck_assert(line_offsets_init(&line_offsets, source, length));
+  ck_assert_uint_eq(line_offsets_line_count(&line_offsets), 7);
+
+  for (size_t offset = 0; offset <= length; offset++) {
+    position_T expected = position_from_source_with_offset(source, offset);
+    position_T actual = line_offsets_position(&line_offsets, offset);
+
+    ck_assert_uint_eq(actual.line, expected.line);
+    ck_assert_uint_eq(actual.column, expected.column);
+    ck_assert_uint_eq(line_offsets_offset(&line_offsets, actual), offset);
+  }
+
+  line_offsets_free(&line_offsets);
+END
+
+TEST(line_offsets_clamp_out_of_range_lookups)
+  line_offsets_T line_offsets;
+  ck_assert(line_offsets_init(&line_offsets, "ab\ncd", 5));
+
+  position_T end = line_offsets_position(&line_offsets, 100);
+  ck_assert_uint_eq(end.line, 2);
+  ck_assert_uint_eq(end.column, 2);
+
+  ck_assert_uint_eq(line_offsets_offset(&line_offsets, (position_T) { .line = 1, .column = 10 }), 2);
+  ck_assert_uint_eq(line_offsets_offset(&line_offsets, (position_T) { .line = 5, .column = 0 }), 5);
+
+  line_offsets_free(&line_offsets);
+END
+
+TEST(line_offsets_empty_source)
+  line_offsets_T line_offsets;
+  ck_assert(line_offsets_init(&line_offsets, "", 0));
+
+  ck_assert_uint_eq(line_offsets_line_count(&line_offsets), 1);
+  ck_assert_uint_eq(line_offsets_position(&line_offsets, 0).line, 1);
+  ck_assert_uint_eq(line_offsets_position(&line_offsets, 0).column, 0);
+
+  line_offsets_free(&line_offsets);
+END
+
+TCase *line_offsets_tests(void) {
+  TCase *line_offsets = tcase_create("Line Offsets");
+
+  tcase_add_test(line_offsets, line_offsets_match_position_from_source);
+  tcase_add_test(line_offsets, line_offsets_clamp_out_of_range_lookups);
+  tcase_add_test(line_offsets, line_offsets_empty_source);
+
+  return line_offsets;
+}
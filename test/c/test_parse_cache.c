@@ -0,0 +1,167 @@
+#include "include/test.h"
+#include "include/serialize_assertions.h"
+#include "../../src/include/herb.h"
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static void remove_directory(const char* directory) {
+  DIR* handle = opendir(directory);
+  if (handle == NULL) { return; }
+
+  struct dirent* entry;
+  char path[4096];
+
+  while ((entry = readdir(handle)) != NULL) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) { continue; }
+
+    snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+    remove(path);
+  }
+
+  closedir(handle);
+  rmdir(directory);
+}
+
+// Overwrites `length` bytes at `offset` in every cache entry in `directory`.
+static void overwrite_cache_entries(const char* directory, long offset, const void* bytes, size_t length) {
+  DIR* handle = opendir(directory);
+  struct dirent* entry;
+  char path[4096];
+
+  while ((entry = readdir(handle)) != NULL) {
+    if (entry->d_name[0] == '.') { continue; }
+
+    snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+    FILE* file = fopen(path, "r+b");
+    fseek(file, offset, SEEK_SET);
+    fwrite(bytes, 1, length, file);
+    fclose(file);
+  }
+
+  closedir(handle);
+}
+
+TEST(test_parse_cache_hit_matches_parse)
+  char directory[] = "/tmp/herb-cache-XXXXXX";
+  ck_assert_ptr_nonnull(mkdtemp(directory));
+
+  const char* source = "<div class=\"greeting\"><%= user.name %></span>";
+
+  hb_buffer_T expected;
+  hb_buffer_init(&expected, 256);
+  AST_DOCUMENT_NODE_T* document = herb_parse(source, NULL);
+  herb_serialize(document, source, &expected);
+  ast_node_free((AST_NODE_T*) document);
+
+  hb_buffer_T miss;
+  hb_buffer_init(&miss, 256);
+  ck_assert(!herb_parse_to_buffer_cached(source, NULL, directory, &miss));
+
+  hb_buffer_T hit;
+  hb_buffer_init(&hit, 256);
+  ck_assert(herb_parse_to_buffer_cached(source, NULL, directory, &hit));
+
+  assert_same_bytes(&expected, &miss);
+  assert_same_bytes(&expected, &hit);
+
+  free(expected.value);
+  free(miss.value);
+  free(hit.value);
+  remove_directory(directory);
+END
+
+TEST(test_parse_cache_keys_on_source_and_options)
+  char directory[] = "/tmp/herb-cache-XXXXXX";
+  ck_assert_ptr_nonnull(mkdtemp(directory));
+
+  hb_buffer_T buffer;
+  hb_buffer_init(&buffer, 256);
+
+  parser_options_T whitespace = HERB_DEFAULT_PARSER_OPTIONS;
+  whitespace.track_whitespace = true;
+
+  ck_assert(!herb_parse_to_buffer_cached("<p>Hello</p>", NULL, directory, &buffer));
+  ck_assert(!herb_parse_to_buffer_cached("<p>Hallo</p>", NULL, directory, &buffer));
+  ck_assert(!herb_parse_to_buffer_cached("<p>Hello</p>", &whitespace, directory, &buffer));
+
+  ck_assert(herb_parse_to_buffer_cached("<p>Hello</p>", NULL, directory, &buffer));
+  ck_assert(herb_parse_to_buffer_cached("<p>Hello</p>", &whitespace, directory, &buffer));
+
+  free(buffer.value);
+  remove_directory(directory);
+END
+
+TEST(test_parse_cache_ignores_corrupt_entries)
+  char directory[] = "/tmp/herb-cache-XXXXXX";
+  ck_assert_ptr_nonnull(mkdtemp(directory));
+
+  const char* source = "<p><%= title %></p>";
+
+  hb_buffer_T buffer;
+  hb_buffer_init(&buffer, 256);
+  ck_assert(!herb_parse_to_buffer_cached(source, NULL, directory, &buffer));
+
+  // Entries start with a 16-byte header, so this overwrites the start of the serialized document.
+  overwrite_cache_entries(directory, 16, "JUNK", 4);
+
+  hb_buffer_T reparsed;
+  hb_buffer_init(&reparsed, 256);
+  ck_assert(!herb_parse_to_buffer_cached(source, NULL, directory, &reparsed));
+
+  assert_same_bytes(&buffer, &reparsed);
+
+  free(buffer.value);
+  free(reparsed.value);
+  remove_directory(directory);
+END
+
+// An entry whose header doesn't match, as it wouldn't for a different source with a colliding name, is a miss.
+TEST(test_parse_cache_checks_entry_header)
+  char directory[] = "/tmp/herb-cache-XXXXXX";
+  ck_assert_ptr_nonnull(mkdtemp(directory));
+
+  const char* source = "<p><%= title %></p>";
+  const uint64_t wrong = 0;
+
+  hb_buffer_T buffer;
+  hb_buffer_init(&buffer, 256);
+
+  ck_assert(!herb_parse_to_buffer_cached(source, NULL, directory, &buffer));
+  overwrite_cache_entries(directory, 0, &wrong, sizeof(wrong));
+  ck_assert(!herb_parse_to_buffer_cached(source, NULL, directory, &buffer));
+
+  ck_assert(herb_parse_to_buffer_cached(source, NULL, directory, &buffer));
+  overwrite_cache_entries(directory, 8, &wrong, sizeof(wrong));
+  ck_assert(!herb_parse_to_buffer_cached(source, NULL, directory, &buffer));
+
+  free(buffer.value);
+  remove_directory(directory);
+END
+
+TEST(test_parse_cache_without_directory)
+  hb_buffer_T buffer;
+  hb_buffer_init(&buffer, 256);
+
+  ck_assert(!herb_parse_to_buffer_cached("<p>Hello</p>", NULL, NULL, &buffer));
+  ck_assert(!herb_parse_to_buffer_cached("<p>Hello</p>", NULL, "/nonexistent/herb-cache", &buffer));
+  ck_assert_int_eq(memcmp(buffer.value, "HERB", 4), 0);
+
+  free(buffer.value);
+END
+
+TCase *parse_cache_tests(void) {
+  TCase *parse_cache = tcase_create("Parse Cache");
+
+  tcase_add_test(parse_cache, test_parse_cache_hit_matches_parse);
+  tcase_add_test(parse_cache, test_parse_cache_keys_on_source_and_options);
+  tcase_add_test(parse_cache, test_parse_cache_ignores_corrupt_entries);
+  tcase_add_test(parse_cache, test_parse_cache_checks_entry_header);
+  tcase_add_test(parse_cache, test_parse_cache_without_directory);
+
+  return parse_cache;
+}
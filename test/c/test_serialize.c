@@ -0,0 +1,95 @@
+#include "include/test.h"
+#include "../../src/include/ast_serialize.h"
+#include "../../src/include/herb.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t read_u32(const hb_buffer_T* buffer, size_t* offset) {
+  const unsigned char* bytes = (const unsigned char*) buffer->value + *offset;
+  *offset += 4;
+
+  return (uint32_t) bytes[0] | ((uint32_t) bytes[1] << 8) | ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+}
+
+// Reads a node header up to its first field, checking it has no errors.
+static uint32_t read_node_header(const hb_buffer_T* buffer, size_t* offset, uint32_t* length) {
+  uint32_t type = read_u32(buffer, offset);
+  *length = read_u32(buffer, offset);
+  *offset += 4 * sizeof(uint32_t);
+
+  ck_assert_uint_eq(read_u32(buffer, offset), 0);
+
+  return type;
+}
+
+TEST(test_serialize_header_and_text_node)
+  const char* source = "Hello";
+  AST_DOCUMENT_NODE_T* document = herb_parse(source, NULL);
+
+  hb_buffer_T buffer;
+  hb_buffer_init(&buffer, 256);
+  herb_serialize(document, source, &buffer);
+
+  size_t offset = 0;
+  ck_assert_int_eq(memcmp(buffer.value, "HERB", 4), 0);
+  offset += 4;
+
+  ck_assert_uint_eq(read_u32(&buffer, &offset), HERB_SERIALIZE_VERSION);
+  ck_assert_uint_eq(read_u32(&buffer, &offset), strlen(source));
+
+  uint32_t length;
+  ck_assert_uint_eq(read_node_header(&buffer, &offset, &length), AST_DOCUMENT_NODE);
+  ck_assert_uint_eq(length, buffer.length - 12);
+  ck_assert_uint_eq(read_u32(&buffer, &offset), 1);
+
+  size_t text_start = offset;
+  ck_assert_uint_eq(read_node_header(&buffer, &offset, &length), AST_HTML_TEXT_NODE);
+  ck_assert_uint_eq(text_start + length, buffer.length);
+
+  // The text was copied while parsing, so it is written inline.
+  ck_assert_uint_eq(read_u32(&buffer, &offset), HERB_SERIALIZE_INLINE);
+  ck_assert_uint_eq(read_u32(&buffer, &offset), 5);
+  ck_assert_int_eq(memcmp(buffer.value + offset, "Hello", 5), 0);
+
+  free(buffer.value);
+  ast_node_free((AST_NODE_T*) document);
+END
+
+TEST(test_serialize_token_values_as_source_offsets)
+  const char* source = "<%= value %>";
+  AST_DOCUMENT_NODE_T* document = herb_parse(source, NULL);
+
+  hb_buffer_T buffer;
+  hb_buffer_init(&buffer, 256);
+  herb_serialize(document, source, &buffer);
+
+  size_t offset = 12;
+  uint32_t length;
+  ck_assert_uint_eq(read_node_header(&buffer, &offset, &length), AST_DOCUMENT_NODE);
+  ck_assert_uint_eq(read_u32(&buffer, &offset), 1);
+  ck_assert_uint_eq(read_node_header(&buffer, &offset, &length), AST_ERB_CONTENT_NODE);
+
+  // tag_opening
+  ck_assert_uint_eq(read_u32(&buffer, &offset), TOKEN_ERB_START);
+  ck_assert_uint_eq(read_u32(&buffer, &offset), 0);
+  ck_assert_uint_eq(read_u32(&buffer, &offset), 3);
+  offset += 6 * sizeof(uint32_t);
+
+  // content
+  ck_assert_uint_eq(read_u32(&buffer, &offset), TOKEN_ERB_CONTENT);
+  ck_assert_uint_eq(read_u32(&buffer, &offset), 3);
+  ck_assert_uint_eq(read_u32(&buffer, &offset), 7);
+
+  free(buffer.value);
+  ast_node_free((AST_NODE_T*) document);
+END
+
+TCase *serialize_tests(void) {
+  TCase *serialize = tcase_create("Serialize");
+
+  tcase_add_test(serialize, test_serialize_header_and_text_node);
+  tcase_add_test(serialize, test_serialize_token_values_as_source_offsets);
+
+  return serialize;
+}
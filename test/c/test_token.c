@@ -63,6 +63,53 @@ TEST(test_token_to_string)
   free(output.value);
 END
 
+TEST(test_token_value_is_source_slice)
+  const char* source = "<div>";
+  hb_array_T* tokens = herb_lex(source);
+
+  token_T* tag_name = hb_array_get(tokens, 1);
+
+  ck_assert_ptr_eq(tag_name->value.data, source + 1);
+  ck_assert_int_eq(tag_name->value.length, 3);
+  ck_assert(!tag_name->owns_value);
+
+  char* value = token_value_to_c_string(tag_name);
+  ck_assert_str_eq(value, "div");
+  free(value);
+
+  herb_free_tokens(&tokens);
+END
+
+TEST(test_token_copy_shares_source_slice)
+  const char* source = "<div>";
+  hb_array_T* tokens = herb_lex(source);
+
+  token_T* tag_name = hb_array_get(tokens, 1);
+  token_T* copy = token_copy(tag_name);
+
+  ck_assert_ptr_ne(copy, tag_name);
+  ck_assert_ptr_eq(copy->value.data, tag_name->value.data);
+  ck_assert_int_eq(copy->value.length, tag_name->value.length);
+
+  token_free(copy);
+  herb_free_tokens(&tokens);
+END
+
+TEST(test_token_own_value)
+  char source[] = "<div>";
+  hb_array_T* tokens = herb_lex(source);
+
+  token_T* tag_name = hb_array_get(tokens, 1);
+  ck_assert(token_own_value(tag_name, NULL));
+
+  source[1] = 'X';
+
+  ck_assert(tag_name->owns_value);
+  ck_assert(hb_string_equals(tag_name->value, hb_string("div")));
+
+  herb_free_tokens(&tokens);
+END
+
 TCase *token_tests(void) {
   TCase *token = tcase_create("Token");
 
@@ -70,6 +117,9 @@ TCase *token_tests(void) {
   tcase_add_test(token, test_token_type_to_friendly_string);
   tcase_add_test(token, test_token_types_to_friendly_string);
   tcase_add_test(token, test_token_to_string);
+  tcase_add_test(token, test_token_value_is_source_slice);
+  tcase_add_test(token, test_token_copy_shares_source_slice);
+  tcase_add_test(token, test_token_own_value);
 
   return token;
 }
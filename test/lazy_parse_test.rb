@@ -0,0 +1,63 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+require "objspace"
+require "tempfile"
+
+class LazyParseTest < Minitest::Spec
+  let(:source) { "<div><span></div>\n<%= user.name %><p>Hello</p>" }
+
+  test "errors match the eager result without building the document" do
+    eager = Herb.parse(source)
+    lazy = Herb.parse(source, lazy: true)
+
+    assert_equal eager.errors.to_json, lazy.errors.to_json
+    assert_equal 1, lazy.errors.size
+    assert lazy.failed?
+
+    refute_predicate lazy.instance_variable_get(:@value), :materialized?
+  end
+
+  test "value matches the eager result" do
+    eager = Herb.parse(source)
+    lazy = Herb.parse(source, lazy: true)
+
+    assert_equal eager.value.inspect, lazy.value.inspect
+    assert_equal eager.errors.to_json, lazy.errors.to_json
+  end
+
+  test "document outlives changes to the source string" do
+    mutable_source = +"<p>Hello</p>"
+    result = Herb.parse(mutable_source, lazy: true)
+
+    mutable_source.replace("<span>Goodbye</span>")
+    GC.start
+
+    assert_equal Herb.parse("<p>Hello</p>").value.inspect, result.value.inspect
+  end
+
+  test "memsize includes the C tree until the document is materialized" do
+    document = Herb.parse(source, lazy: true).instance_variable_get(:@value)
+    unmaterialized_size = ObjectSpace.memsize_of(document)
+
+    assert_operator unmaterialized_size, :>=, 16 * 1024
+
+    document.value
+
+    assert_operator ObjectSpace.memsize_of(document), :<, unmaterialized_size
+  end
+
+  test "stats count allocations" do
+    assert_operator Herb.parse(source, lazy: true, stats: true).stats[:allocations], :>, 0
+  end
+
+  test "parse_file supports lazy" do
+    file = Tempfile.new(["lazy", ".html.erb"])
+    file.write(source)
+    file.close
+
+    assert_equal Herb.parse(source).value.inspect, Herb.parse_file(file.path, lazy: true).value.inspect
+  ensure
+    file&.unlink
+  end
+end
@@ -35,8 +35,13 @@ module Lexer
       SNAPSHOT
 
       assert_equal snapshot, result.value.inspect
+      assert_equal %(<h1><%= RUBY_VERSION %></h1>), result.source
 
       file.unlink
     end
+
+    test "lex_file with a missing file" do
+      assert_raises(Errno::ENOENT) { Herb.lex_file("/nonexistent/template.html.erb") }
+    end
   end
 end
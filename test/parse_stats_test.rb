@@ -0,0 +1,42 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+require "tempfile"
+
+class ParseStatsTest < Minitest::Spec
+  let(:source) { "<div><% if admin? %><p><%= user.name %></p><% end %></div>" }
+
+  test "stats are nil unless requested" do
+    assert_nil Herb.parse(source).stats
+  end
+
+  test "parse with stats: true" do
+    result = Herb.parse(source, stats: true)
+    stats = result.stats
+
+    assert_equal Herb.parse(source).value.inspect, result.value.inspect
+    assert_equal [:lex, :parse, :transform, :match_tags, :parse_errors], stats[:nanoseconds].keys
+    assert(stats[:nanoseconds].values.all? { |nanoseconds| nanoseconds.is_a?(Integer) })
+    assert_operator stats[:tokens], :>=, Herb.lex(source).value.size
+    assert_operator stats[:nodes], :>, 0
+    assert_operator stats[:prism_parses], :>=, 3
+    assert_operator stats[:allocations], :>, 0
+  end
+
+  test "analysis phases are skipped with analyze: false" do
+    stats = Herb.parse(source, stats: true, analyze: false).stats
+
+    assert_equal 0, stats[:prism_parses]
+    assert_equal 0, stats[:nanoseconds][:transform]
+    assert_equal 0, stats[:nanoseconds][:match_tags]
+  end
+
+  test "parse_file with stats: true" do
+    Tempfile.create(["template", ".html.erb"]) do |file|
+      file.write(source)
+      file.flush
+
+      assert_operator Herb.parse_file(file.path, stats: true).stats[:nodes], :>, 0
+    end
+  end
+end
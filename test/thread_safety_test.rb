@@ -0,0 +1,70 @@
+# frozen_string_literal: true
+
+require_relative "test_helper"
+
+class ThreadSafetyTest < Minitest::Spec
+  let(:sources) do
+    [
+      "<div><%= user.name %></div>",
+      "<% if admin? %><p>Welcome</p><% else %><span></div><% end %>",
+      "<ul><% items.each do |item| %><li><%= item %></li><% end %></ul>",
+      "<!DOCTYPE html><html><head><title><%= title %></title></head></html>",
+    ]
+  end
+
+  test "parse, lex and extract from many threads at once" do
+    expected = sources.map do |source|
+      [Herb.parse(source).value.inspect, Herb.lex(source).value.inspect, Herb.extract_ruby(source), Herb.extract_html(source)]
+    end
+
+    threads = 8.times.map do
+      Thread.new do
+        20.times.flat_map do
+          sources.map do |source|
+            [Herb.parse(source).value.inspect, Herb.lex(source).value.inspect, Herb.extract_ruby(source), Herb.extract_html(source)]
+          end
+        end
+      end
+    end
+
+    threads.each do |thread|
+      assert_equal expected * 20, thread.value
+    end
+  end
+
+  test "source modified by another thread while parsing" do
+    hello = "<p>#{"Hello " * 10_000}</p>"
+    jello = hello.tr("H", "J")
+    expected = [Herb.parse(hello).value.inspect, Herb.parse(jello).value.inspect]
+
+    source = +hello
+    writer = Thread.new do
+      200.times do
+        source.replace(jello)
+        source.replace(hello)
+      end
+    end
+
+    results = 20.times.map { Herb.parse(source).value.inspect }
+    writer.join
+
+    assert(results.all? { |result| expected.include?(result) })
+  end
+
+  test "parse from a Ractor" do
+    skip "Ractor is not available" unless defined?(Ractor)
+
+    previous_verbose = Warning[:experimental]
+    Warning[:experimental] = false
+
+    source = "<div><%= user.name %></div>"
+    ractor = Ractor.new(source) { |template| Herb.parse(template).value.inspect }
+
+    # Ractor#take was replaced by Ractor#value in Ruby 3.5.
+    result = ractor.respond_to?(:value) ? ractor.value : ractor.take
+
+    assert_equal Herb.parse(source).value.inspect, result
+  ensure
+    Warning[:experimental] = previous_verbose unless previous_verbose.nil?
+  end
+end
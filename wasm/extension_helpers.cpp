@@ -76,11 +76,7 @@ val CreateToken(token_T* token) {
   val Object = val::global("Object");
   val result = Object.new_();
 
-  if (token->value) {
-    result.set("value", std::string(token->value));
-  } else {
-    result.set("value", val::null());
-  }
+  result.set("value", std::string(token->value.data, token->value.length));
 
   result.set("type", std::string(token_type_to_string(token->type)));
   result.set("range", CreateRange(token->range));
@@ -115,6 +111,25 @@ val CreateLexResult(hb_array_T* tokens, const std::string& source) {
   return result;
 }
 
+static val CreateParseStats(const herb_parse_stats_T* stats) {
+  val Object = val::global("Object");
+
+  val result = Object.new_();
+  val nanoseconds = Object.new_();
+
+  for (int phase = 0; phase < HERB_PARSE_PHASE_COUNT; phase++) {
+    nanoseconds.set(herb_parse_phase_name((herb_parse_phase_T) phase), val((double) stats->nanoseconds[phase]));
+  }
+
+  result.set("nanoseconds", nanoseconds);
+  result.set("tokens", val((double) stats->tokens));
+  result.set("nodes", val((double) stats->nodes));
+  result.set("prism_parses", val((double) stats->prism_parses));
+  result.set("allocations", val((double) stats->allocations));
+
+  return result;
+}
+
 val CreateParseResult(AST_DOCUMENT_NODE_T *root, const std::string& source, parser_options_T* options){
   val Object = val::global("Object");
   val Array = val::global("Array");
@@ -136,5 +151,9 @@ val CreateParseResult(AST_DOCUMENT_NODE_T *root, const std::string& source, pars
 
   result.set("options", options_object);
 
+  if (options->stats != nullptr) {
+    result.set("stats", CreateParseStats(options->stats));
+  }
+
   return result;
 }
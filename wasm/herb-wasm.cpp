@@ -24,7 +24,7 @@ extern "C" {
 using namespace emscripten;
 
 val Herb_lex(const std::string& source) {
-  hb_array_T* tokens = herb_lex(source.c_str());
+  hb_array_T* tokens = herb_lex_with_length(source.c_str(), source.length());
 
   val result = CreateLexResult(tokens, source);
 
@@ -35,6 +35,7 @@ val Herb_lex(const std::string& source) {
 
 val Herb_parse(const std::string& source, val options) {
   parser_options_T parser_options = HERB_DEFAULT_PARSER_OPTIONS;
+  herb_parse_stats_T parse_stats = {};
 
   if (!options.isUndefined() && !options.isNull() && options.typeOf().as<std::string>() == "object") {
     if (options.hasOwnProperty("track_whitespace")) {
@@ -54,13 +55,29 @@ val Herb_parse(const std::string& source, val options) {
     if (options.hasOwnProperty("strict")) {
       parser_options.strict = options["strict"].as<bool>();
     }
+
+    if (options.hasOwnProperty("stats") && options["stats"].as<bool>()) {
+      parser_options.stats = &parse_stats;
+    }
+  }
+
+  // With stats the document is parsed into an arena, so its allocations are counted too.
+  hb_arena_T allocator;
+  hb_arena_T* arena = nullptr;
+
+  if (parser_options.stats != nullptr && hb_arena_init(&allocator, KB(64))) {
+    arena = &allocator;
   }
 
-  AST_DOCUMENT_NODE_T* root = herb_parse(source.c_str(), &parser_options);
+  AST_DOCUMENT_NODE_T* root = herb_parse_arena_with_length(source.c_str(), source.length(), &parser_options, arena);
 
   val result = CreateParseResult(root, source, &parser_options);
 
-  ast_node_free((AST_NODE_T *) root);
+  if (arena) {
+    hb_arena_free(arena);
+  } else {
+    ast_node_free((AST_NODE_T *) root);
+  }
 
   return result;
 }
@@ -85,7 +102,7 @@ std::string Herb_extract_ruby(const std::string& source, val options) {
     }
   }
 
-  herb_extract_ruby_to_buffer_with_options(source.c_str(), &output, &extract_options);
+  herb_extract_ruby_to_buffer_with_length(source.c_str(), source.length(), &output, &extract_options);
   std::string result(hb_buffer_value(&output));
   free(output.value);
   return result;
@@ -95,7 +112,7 @@ std::string Herb_extract_html(const std::string& source) {
   hb_buffer_T output;
   hb_buffer_init(&output, source.length());
 
-  herb_extract_html_to_buffer(source.c_str(), &output);
+  herb_extract_html_to_buffer_with_length(source.c_str(), source.length(), &output);
   std::string result(hb_buffer_value(&output));
   free(output.value);
   return result;